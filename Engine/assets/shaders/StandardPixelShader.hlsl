@@ -25,7 +25,9 @@ struct Light {
 
   int hasShadow;
 
-  float2 _padding;
+  int shadowIndex;
+
+  float _padding;
 
   matrix lightTransform;
 };
@@ -1,18 +1,23 @@
 // This file is linked into every fragment shader.
 // All fragment shaders should implement frag(), not main().
 
-// If we're rendering this model through a portal, this mat4 is the
-// inverse of the transform of the output portal-front in scene space.
-// This is used to transform a fragment's position from scene-space to
-// portal-space to determine which side of the portal we're on for culling.
+// With the PORTAL_CLIP keyword, for rendering this model through a portal,
+// this mat4 is the inverse of the transform of the output portal-front in
+// scene space. This is used to transform a fragment's position from
+// scene-space to portal-space to determine which side of the portal we're
+// on for culling.
+#ifdef PORTAL_CLIP
 uniform mat4 _InvPortal;
+#endif
 
 vec4 frag();
 
 void main() {
-  if (_InvPortal[3][3] == 1 && (_InvPortal * v_ScenePos).z < 0) {
+#ifdef PORTAL_CLIP
+  if ((_InvPortal * v_ScenePos).z < 0) {
     discard;
   }
+#endif
 
   FragColor = frag();
 }
@@ -0,0 +1,94 @@
+// Clustered light lookup for fragment shaders. Include after shared_head.glsl
+// and fragment_head.glsl.
+//
+// All lights in the scene are stored in _LightData. The first
+// _LightClusters.globalCount lights affect every fragment. The rest are
+// assigned to froxel clusters on the CPU, and each cluster stores an
+// (offset, count) range of _LightIndices.
+//
+// NOTE: Keep this consistent with include/dg/LightClusters.h.
+
+const int LIGHT_CLUSTER_TILES_X = 16;
+const int LIGHT_CLUSTER_TILES_Y = 9;
+const int LIGHT_CLUSTER_SLICES = 24;
+const int LIGHT_DATA_TEXELS = 10;
+
+struct LightClusterInfo {
+  // Number of lights at the front of _LightData that apply to all clusters.
+  int globalCount;
+
+  // (scale, bias, isPerspective) for mapping view depth to a depth slice.
+  vec3 depthSlicing;
+};
+
+uniform LightClusterInfo _LightClusters;
+uniform samplerBuffer _LightData;
+uniform usamplerBuffer _LightGrid;
+uniform usamplerBuffer _LightIndices;
+
+// Unpacks a light stored as Light::ShaderData.
+Light fetchLight(int index) {
+  int base = index * LIGHT_DATA_TEXELS;
+  vec4 t0 = texelFetch(_LightData, base + 0);
+  vec4 t1 = texelFetch(_LightData, base + 1);
+  vec4 t2 = texelFetch(_LightData, base + 2);
+  vec4 t3 = texelFetch(_LightData, base + 3);
+  vec4 t4 = texelFetch(_LightData, base + 4);
+  vec4 t5 = texelFetch(_LightData, base + 5);
+
+  Light light;
+  light.diffuse = t0.xyz;
+  light.type = floatBitsToInt(t0.w);
+  light.ambient = t1.xyz;
+  light.innerCutoff = t1.w;
+  light.specular = t2.xyz;
+  light.outerCutoff = t2.w;
+  light.position = t3.xyz;
+  light.constantCoeff = t3.w;
+  light.direction = t4.xyz;
+  light.linearCoeff = t4.w;
+  light.quadraticCoeff = t5.x;
+  light.hasShadow = floatBitsToInt(t5.y);
+  light.shadowIndex = floatBitsToInt(t5.z);
+  light.lightTransform = mat4(
+      texelFetch(_LightData, base + 6),
+      texelFetch(_LightData, base + 7),
+      texelFetch(_LightData, base + 8),
+      texelFetch(_LightData, base + 9));
+  return light;
+}
+
+// Returns the (offset, count) range of _LightIndices for this fragment's
+// cluster.
+ivec2 lightClusterRange() {
+  // The tile is found from the view rather than gl_FragCoord, since in
+  // single-pass stereo the view spans both eyes but each eye only covers
+  // half of the target.
+  vec4 clip = _Matrix_P * _Matrix_V * v_ScenePos;
+  vec2 tile = (clip.xy / clip.w * 0.5 + 0.5) *
+              vec2(LIGHT_CLUSTER_TILES_X, LIGHT_CLUSTER_TILES_Y);
+
+  float depth = -(_Matrix_V * v_ScenePos).z;
+  float slice = _LightClusters.depthSlicing.z > 0.5
+              ? log(max(depth, 1e-6)) * _LightClusters.depthSlicing.x
+              : depth * _LightClusters.depthSlicing.x;
+  slice += _LightClusters.depthSlicing.y;
+
+  ivec3 cluster = clamp(
+      ivec3(ivec2(tile), int(floor(slice))),
+      ivec3(0),
+      ivec3(LIGHT_CLUSTER_TILES_X - 1, LIGHT_CLUSTER_TILES_Y - 1,
+            LIGHT_CLUSTER_SLICES - 1));
+  int index = (cluster.z * LIGHT_CLUSTER_TILES_Y + cluster.y) *
+              LIGHT_CLUSTER_TILES_X + cluster.x;
+
+  // Two clusters are packed into each texel.
+  uvec4 texel = texelFetch(_LightGrid, index / 2);
+  return ivec2((index % 2 == 0) ? texel.xy : texel.zw);
+}
+
+// Returns the light index at position i of _LightIndices.
+int clusterLightIndex(int i) {
+  // Four indices are packed into each texel.
+  return int(texelFetch(_LightIndices, i / 4)[i % 4]);
+}
@@ -5,45 +5,59 @@
 #define LIGHT_TYPE_SPOT        2
 #define LIGHT_TYPE_DIRECTIONAL 3
 
+// NOTE: Keep this struct consistent with Light::ShaderData in
+//       include/dg/Lights.h, whose member order it follows so that the
+//       light block's std140 layout matches it.
 struct Light {
-  // Type of light. Allowed values are those defined above.
-	int type;
-
-  // Light color properties.
+  // Type of light (one of those defined above) and light color properties,
+  // with the spot light cutoff angles packed between them.
   vec3 diffuse;
+  int type;
   vec3 ambient;
-  vec3 specular;
-
-  // Point light position.
-  vec3 position;
-
-  // Directional and spot light direction.
-  vec3 direction;
-
-  // Spot light cutoff angle.
   float innerCutoff;
+  vec3 specular;
   float outerCutoff;
 
-  // Point light attenuation properties.
+  // Point light position and attenuation properties, and directional and
+  // spot light direction.
+  vec3 position;
   float constantCoeff;
+  vec3 direction;
   float linearCoeff;
   float quadraticCoeff;
 
-  // Shadow.
+  // Shadow. For point lights, lightTransform maps scene space to the
+  // light's position scaled by 1 / its shadow's far clip, and shadowIndex
+  // selects its shadow cubemap.
   int hasShadow;
+  int shadowIndex;
+  float _padding;
   mat4 lightTransform;
 };
 
-uniform vec2 _BufferDimensions;
-
-// NOTE: Keep this consistent with MAX_LIGHTS in include/dg/Lights.h.
+// Lights of the current subrender for shaders that don't use clustered
+// lighting, uploaded once per subrender by the scene.
+//
+// NOTE: Keep this consistent with MAX_LIGHTS and LIGHTS_BLOCK_NAME in
+//       include/dg/Lights.h.
 const int MAX_LIGHTS = 8;
-uniform Light _Lights[MAX_LIGHTS];
-
-uniform vec3 _CameraPosition;
+layout (std140) uniform _LightBlock {
+  Light _Lights[MAX_LIGHTS];
+};
 
-uniform mat4 _Matrix_MVP;
-uniform mat4 _Matrix_M;
-uniform mat4 _Matrix_V;
-uniform mat4 _Matrix_P;
-uniform mat4 _Matrix_Normal;
+// Uniforms of the current view, and of the object being drawn, which the
+// engine writes into a ring buffer and binds by offset for each draw.
+//
+// NOTE: Keep these consistent with OpenGLGraphics::ViewUniforms and
+//       OpenGLGraphics::ObjectUniforms in include/dg/Graphics.h.
+layout (std140) uniform _ViewBlock {
+  mat4 _Matrix_V;
+  mat4 _Matrix_P;
+  vec3 _CameraPosition;
+  vec2 _BufferDimensions;
+};
+layout (std140) uniform _ObjectBlock {
+  mat4 _Matrix_MVP;
+  mat4 _Matrix_M;
+  mat4 _Matrix_Normal;
+};
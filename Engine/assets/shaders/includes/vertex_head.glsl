@@ -4,3 +4,10 @@ layout (location = 0) in vec3 in_Position;
 layout (location = 1) in vec3 in_Normal;
 layout (location = 2) in vec2 in_TexCoord;
 layout (location = 3) in vec3 in_Tangent;
+
+// Single-pass stereo. When _Stereo is set, each mesh is drawn as two
+// instances, one per eye, into the two halves of a side-by-side target.
+// _Matrix_V and _Matrix_P are those of a frustum enclosing both eyes, and
+// _Matrix_StereoReprojection maps its clip space to each eye's.
+uniform bool _Stereo;
+uniform mat4 _Matrix_StereoReprojection[2];
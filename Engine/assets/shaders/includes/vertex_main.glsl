@@ -16,5 +16,16 @@ void main() {
   v_TBN = mat3(T, B, v_Normal);
 
   gl_Position = vert();
+
+  if (_Stereo) {
+    int eye = gl_InstanceID;
+    vec4 clip = _Matrix_StereoReprojection[eye] * gl_Position;
+
+    // Squeeze the eye's view into its half of the target, and clip away
+    // anything that would spill into the other half.
+    gl_ClipDistance[0] = (eye == 0) ? clip.w - clip.x : clip.w + clip.x;
+    clip.x = clip.x * 0.5 + ((eye == 0) ? -0.5 : 0.5) * clip.w;
+    gl_Position = clip;
+  }
 }
 
@@ -0,0 +1,12 @@
+#version 330 core
+
+uniform vec3 _LightPosition;
+uniform float _FarClip;
+
+in vec4 g_ScenePos;
+
+// Store the distance to the light instead of projected depth, so that it can
+// be compared against without knowing which face a fragment falls in.
+void main() {
+  gl_FragDepth = distance(g_ScenePos.xyz, _LightPosition) / _FarClip;
+}
@@ -0,0 +1,29 @@
+#version 330 core
+
+// Renders each triangle to every cubemap face in _FaceMask, in one pass.
+//
+// NOTE: Keep the face order consistent with dg::TextureFace.
+
+layout (triangles) in;
+layout (triangle_strip, max_vertices = 18) out;
+
+uniform mat4 _FaceMatrices[6];
+uniform int _FaceMask;
+
+out vec4 g_ScenePos;
+
+void main() {
+  for (int face = 0; face < 6; face++) {
+    if ((_FaceMask & (1 << face)) == 0) {
+      continue;
+    }
+
+    gl_Layer = face;
+    for (int i = 0; i < 3; i++) {
+      g_ScenePos = gl_in[i].gl_Position;
+      gl_Position = _FaceMatrices[face] * g_ScenePos;
+      EmitVertex();
+    }
+    EndPrimitive();
+  }
+}
@@ -0,0 +1,9 @@
+#version 330 core
+#include "includes/shared_head.glsl"
+#include "includes/vertex_head.glsl"
+
+// Positions stay in scene space. The geometry shader projects each triangle
+// onto the cubemap faces it's drawn to.
+void main() {
+  gl_Position = _Matrix_M * vec4(in_Position, 1.0);
+}
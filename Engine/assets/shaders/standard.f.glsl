@@ -2,32 +2,115 @@
 #include "includes/shared_head.glsl"
 #include "includes/fragment_head.glsl"
 #include "includes/fragment_main.glsl"
+#include "includes/light_clusters.glsl"
+
+// Material properties, which each material uploads as one uniform buffer.
+// NOTE: Keep the block name consistent with Material::PROPERTY_BLOCK_NAME.
+//
+// Features are chosen by keywords instead of uniforms, so that each variant
+// only does the work of the features it's used with:
+//   LIT           Lit by the scene's lights, instead of just its color.
+//   DIFFUSE_MAP   Color from _DiffuseMap, instead of diffuse.
+//   SPECULAR_MAP  Specular color from _SpecularMap, instead of specular.
+//   NORMAL_MAP    Normals from _NormalMap.
+// NOTE: Keep consistent with StandardMaterial.
+layout (std140) uniform _Material {
+  vec2 uvScale;
+  vec4 diffuse;
+  vec3 specular;
+  float shininess;
+} material;
 
-struct Material {
-  bool lit;
+uniform sampler2D _DiffuseMap;
+uniform sampler2D _SpecularMap;
+uniform sampler2D _NormalMap;
 
-  bool useDiffuseMap;
-  sampler2D diffuseMap;
-  vec4 diffuse;
+uniform sampler2D _ShadowMap;
 
-  bool useSpecularMap;
-  sampler2D specularMap;
-  vec3 specular;
+// Cascaded shadow maps of the shadow-casting directional light.
+// NOTE: Keep consistent with Engine/include/dg/ShadowCascades.h.
+#define MAX_CASCADES 4
+struct Cascades {
+  int count;
 
-  bool useNormalMap;
-  sampler2D normalMap;
+  // View-space distance to the far end of each cascade.
+  vec4 splits;
 
-  float shininess;
+  mat4 transforms[MAX_CASCADES];
 };
+uniform Cascades _Cascades;
+uniform sampler2DArray _CascadedShadowMap;
 
-uniform Material _Material;
-uniform vec2 _UVScale;
-
-uniform sampler2D _ShadowMap;
+// Distance-based depth cubemaps of shadow-casting point lights, indexed by
+// light.shadowIndex.
+// NOTE: Keep consistent with Engine/include/dg/PointShadowMap.h.
+#define MAX_POINT_SHADOWS 4
+uniform samplerCube _PointShadowMaps[MAX_POINT_SHADOWS];
 
 in vec2 v_TexCoord;
 in mat3 v_TBN;
 
+// Window-space position of the fragment in a cascade's shadow map, and
+// whether the cascade's shadow map covers it.
+bool cascadeCovers(int cascade, out vec3 projCoords) {
+  vec4 fragPosLightSpace = _Cascades.transforms[cascade] * v_ScenePos;
+  projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
+  projCoords = projCoords * 0.5 + 0.5;
+  return all(greaterThanEqual(projCoords, vec3(0))) &&
+         all(lessThanEqual(projCoords, vec3(1)));
+}
+
+float calculateCascadedShadow() {
+  // The cascades are fit to the main camera, which may not be the camera
+  // drawing this fragment, such as for a mirror. The cascade whose split
+  // contains the view depth is preferred, since it's the right one for the
+  // main camera, but otherwise the nearest cascade that covers the fragment
+  // is used. Fragments that no cascade covers are unshadowed.
+  float depth = -(_Matrix_V * v_ScenePos).z;
+  int cascade = 0;
+  while (cascade < _Cascades.count && depth > _Cascades.splits[cascade]) {
+    cascade++;
+  }
+  vec3 projCoords;
+  if (cascade >= _Cascades.count || !cascadeCovers(cascade, projCoords)) {
+    cascade = 0;
+    while (cascade < _Cascades.count &&
+           !cascadeCovers(cascade, projCoords)) {
+      cascade++;
+    }
+    if (cascade >= _Cascades.count) {
+      return 0;
+    }
+  }
+
+  float closestDepth =
+    texture(_CascadedShadowMap, vec3(projCoords.xy, cascade)).r;
+  float currentDepth = projCoords.z;
+  float bias = 0.0001;
+  return currentDepth - bias > closestDepth  ? 1.0 : 0.0;
+}
+
+float calculatePointShadow(Light light) {
+  // The light transform maps to light space scaled by 1 / far clip, which is
+  // what the cubemaps store.
+  vec3 lightToFrag = (light.lightTransform * v_ScenePos).xyz;
+
+  // Sampler arrays can only be indexed by constants in GLSL 3.30.
+  float closestDepth = 1;
+  if (light.shadowIndex == 0) {
+    closestDepth = texture(_PointShadowMaps[0], lightToFrag).r;
+  } else if (light.shadowIndex == 1) {
+    closestDepth = texture(_PointShadowMaps[1], lightToFrag).r;
+  } else if (light.shadowIndex == 2) {
+    closestDepth = texture(_PointShadowMaps[2], lightToFrag).r;
+  } else if (light.shadowIndex == 3) {
+    closestDepth = texture(_PointShadowMaps[3], lightToFrag).r;
+  }
+  float currentDepth = length(lightToFrag);
+  float bias = 0.002;
+  return currentDepth - bias > closestDepth  ? 1.0 : 0.0;
+}
+
 vec3 calculateLight(
     Light light, vec3 normal, vec3 diffuseColor, vec3 specularColor) {
   if (light.type == LIGHT_TYPE_NULL) {
@@ -51,7 +134,7 @@ vec3 calculateLight(
   // Specular
   vec3 viewDir = normalize(_CameraPosition - v_ScenePos.xyz);
   vec3 reflectDir = reflect(-lightDir, norm);
-  float spec = pow(max(dot(viewDir, reflectDir), 0.0), _Material.shininess);
+  float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
   vec3 specular = light.specular * spec * specularColor;
 
   // Attenuation
@@ -76,7 +159,11 @@ vec3 calculateLight(
 
   // Calculate shadow
   float shadow = 0;
-  if (light.hasShadow == 1) {
+  if (light.hasShadow == 1 && light.type == LIGHT_TYPE_DIRECTIONAL) {
+    shadow = calculateCascadedShadow();
+  } else if (light.hasShadow == 1 && light.type == LIGHT_TYPE_POINT) {
+    shadow = calculatePointShadow(light);
+  } else if (light.hasShadow == 1) {
     vec4 fragPosLightSpace = light.lightTransform * v_ScenePos;
     vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
     projCoords = projCoords * 0.5 + 0.5;
@@ -90,36 +177,48 @@ vec3 calculateLight(
 }
 
 vec4 frag() {
-  vec2 texCoord = v_TexCoord * _UVScale;
+  vec2 texCoord = v_TexCoord * material.uvScale;
 
-  vec4 diffuseColor = _Material.useDiffuseMap
-                    ? texture(_Material.diffuseMap, texCoord)
-                    : vec4(_Material.diffuse);
+#ifdef DIFFUSE_MAP
+  vec4 diffuseColor = texture(_DiffuseMap, texCoord);
+#else
+  vec4 diffuseColor = material.diffuse;
+#endif
 
-  if (!_Material.lit) {
-    return diffuseColor;
-  }
+#ifndef LIT
+  return diffuseColor;
+#else
 
-  vec3 specularColor = _Material.useSpecularMap
-                     ? texture(_Material.specularMap, texCoord).rgb
-                     : vec3(_Material.specular);
+#ifdef SPECULAR_MAP
+  vec3 specularColor = texture(_SpecularMap, texCoord).rgb;
+#else
+  vec3 specularColor = material.specular;
+#endif
 
   vec3 normal = v_Normal;
-  if (_Material.useNormalMap) {
-    normal = normalize(texture(_Material.normalMap, texCoord).rgb * 2.0 - 1.0);
+#ifdef NORMAL_MAP
+  normal = normalize(texture(_NormalMap, texCoord).rgb * 2.0 - 1.0);
 
-    // Transform normal from tangent space (which is what the normal map is)
-    // to world space by left-multiplying the world-space basis vectors of
-    // this fragment's tangent space.
-    normal = normalize(v_TBN * normal);
-  }
+  // Transform normal from tangent space (which is what the normal map is)
+  // to world space by left-multiplying the world-space basis vectors of
+  // this fragment's tangent space.
+  normal = normalize(v_TBN * normal);
+#endif
 
   vec3 cumulative = vec3(0);
-  for (int i = 0; i < MAX_LIGHTS; i++) {
+  for (int i = 0; i < _LightClusters.globalCount; i++) {
+    cumulative += calculateLight(
+        fetchLight(i), normal, diffuseColor.rgb, specularColor);
+  }
+
+  ivec2 clusterRange = lightClusterRange();
+  for (int i = 0; i < clusterRange.y; i++) {
     cumulative += calculateLight(
-        _Lights[i], normal, diffuseColor.rgb, specularColor);
+        fetchLight(clusterLightIndex(clusterRange.x + i)), normal,
+        diffuseColor.rgb, specularColor);
   }
 
   return vec4(cumulative, diffuseColor.a);
+#endif
 }
 
@@ -0,0 +1,55 @@
+//
+//  Bounds.h
+//
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+namespace dg {
+
+  // Axis-aligned bounding box.
+  struct AABB {
+
+      // Returns an AABB containing nothing, which grows to fit whatever is
+      // added to it with Encapsulate().
+      static AABB Empty();
+
+      AABB() = default;
+      AABB(glm::vec3 min, glm::vec3 max);
+
+      glm::vec3 min = glm::vec3(0);
+      glm::vec3 max = glm::vec3(0);
+
+      bool IsEmpty() const;
+      glm::vec3 Center() const;
+      glm::vec3 Extents() const;
+
+      void Encapsulate(glm::vec3 point);
+      void Encapsulate(const AABB &other);
+
+      // Returns the AABB of this box after being transformed by an affine
+      // transformation matrix.
+      AABB Transformed(const glm::mat4x4 &xf) const;
+
+  }; // struct AABB
+
+  // Six planes bounding a view volume, with normals pointing inwards.
+  struct Frustum {
+
+      // Extracts the frustum planes from a projection * view matrix.
+      static Frustum FromMatrix(const glm::mat4x4 &projectionView);
+
+      // Each plane is (normal, distance) such that a point p is inside the
+      // plane when dot(normal, p) + distance >= 0.
+      glm::vec4 planes[6];
+
+      // Conservative tests. These may return true for volumes just outside
+      // a corner of the frustum, but never return false for a volume that
+      // intersects it.
+      bool Intersects(const AABB &box) const;
+      bool Intersects(glm::vec3 center, float radius) const;
+
+  }; // struct Frustum
+
+} // namespace dg
@@ -35,6 +35,12 @@ namespace dg {
       glm::mat4x4 GetProjectionMatrix() const;
       glm::mat4x4 GetProjectionMatrix(vr::EVREye eye) const;
 
+      // View and projection of a single frustum enclosing both eyes'
+      // frustums, from a point just behind the eyes. Used to cull and assign
+      // lights once for both eyes in single-pass stereo rendering.
+      glm::mat4x4 GetStereoViewMatrix() const;
+      glm::mat4x4 GetStereoProjectionMatrix() const;
+
   }; // class Camera
 
 } // namespace dg
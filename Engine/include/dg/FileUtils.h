@@ -18,6 +18,10 @@ namespace dg {
       static std::string DirectoryPathOfFilePath(const std::string &filename);
       static std::string FlattenPath(const std::string &path);
 
+      // Creates a directory if it doesn't exist yet. Its parent must exist.
+      // Returns whether the directory exists afterwards.
+      static bool MakeDirectory(const std::string &path);
+
   }; // class FileUtils
 
 } // namespace dg
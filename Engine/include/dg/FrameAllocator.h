@@ -0,0 +1,132 @@
+//
+//  FrameAllocator.h
+//
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace dg {
+
+  // Linear allocator that hands out memory by bumping an offset through
+  // large blocks, and frees everything at once with Reset().
+  //
+  // When allocations overflow the first block, more blocks are added, and
+  // the next Reset() replaces them all with a single block big enough for
+  // everything, so that a steady workload stops allocating from the heap
+  // after its first few frames.
+  class FrameArena {
+
+    public:
+
+      static const size_t DEFAULT_BLOCK_SIZE = 1 << 20;
+
+      FrameArena(size_t blockSize = DEFAULT_BLOCK_SIZE);
+
+      FrameArena(const FrameArena &) = delete;
+      FrameArena &operator=(const FrameArena &) = delete;
+
+      // Returns size bytes aligned to alignment, which must be a power of
+      // two. Never returns nullptr.
+      void *Allocate(size_t size, size_t alignment);
+
+      // Frees every allocation made since the last reset.
+      void Reset();
+
+      // Bytes allocated since the last reset, not counting alignment.
+      size_t GetBytesAllocated() const;
+
+      // Total size of the arena's blocks.
+      size_t GetCapacity() const;
+
+    private:
+
+      struct Block {
+        std::unique_ptr<char[]> memory;
+        size_t size;
+      };
+
+      std::vector<Block> blocks;
+      size_t blockSize;
+
+      // Position of the next allocation.
+      size_t blockIndex = 0;
+      size_t offset = 0;
+
+      size_t bytesAllocated = 0;
+
+  }; // class FrameArena
+
+  // Double-buffered arenas for temporaries of the main loop.
+  //
+  // Each frame allocates from one arena, and BeginFrame() switches to the
+  // other one, resetting it. Memory allocated during a frame therefore stays
+  // valid until the end of the frame after it, so results built late in one
+  // frame can still be read early in the next.
+  //
+  // Not thread-safe. Only allocate from the main thread.
+  class FrameMemory {
+
+    public:
+
+      // Called once at the start of each frame by the engine.
+      static void BeginFrame();
+
+      // Arena of the current frame.
+      static FrameArena &Current();
+
+    private:
+
+      static FrameArena arenas[2];
+      static unsigned int current;
+
+  }; // class FrameMemory
+
+  // Standard allocator adapter over a FrameArena, by default the current
+  // frame's. Deallocation does nothing, since the arena is reset as a whole,
+  // so containers using it must not outlive the frame after the one they
+  // were created in.
+  template <typename T>
+  class FrameAllocator {
+
+    template <typename U> friend class FrameAllocator;
+
+    public:
+
+      typedef T value_type;
+
+      FrameAllocator() : arena(&FrameMemory::Current()) {}
+      explicit FrameAllocator(FrameArena &arena) : arena(&arena) {}
+
+      template <typename U>
+      FrameAllocator(const FrameAllocator<U> &other) : arena(other.arena) {}
+
+      T *allocate(size_t count) {
+        return static_cast<T *>(arena->Allocate(count * sizeof(T), alignof(T)));
+      }
+
+      void deallocate(T *pointer, size_t count) {}
+
+      template <typename U>
+      bool operator==(const FrameAllocator<U> &other) const {
+        return arena == other.arena;
+      }
+
+      template <typename U>
+      bool operator!=(const FrameAllocator<U> &other) const {
+        return arena != other.arena;
+      }
+
+    private:
+
+      FrameArena *arena;
+
+  }; // class FrameAllocator
+
+  // Vector of frame-scoped temporaries.
+  template <typename T>
+  using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+} // namespace dg
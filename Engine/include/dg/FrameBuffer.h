@@ -40,6 +40,11 @@ namespace dg {
       bool hasColor = true;
       bool hasStencil = true;
       std::vector<TextureOptions> textureOptions;
+
+      // Type and layer count of the framebuffer's textures. If
+      // textureOptions are given, their type is used instead.
+      TextureType type = TextureType::_2D;
+      unsigned int layers = 1;
     };
 
     static std::shared_ptr<FrameBuffer> Create(Options options);
@@ -79,6 +84,12 @@ namespace dg {
 
     GLuint GetHandle() const;
 
+    // For _2D_ARRAY and CUBEMAP framebuffers, attaches a single layer (or
+    // cube face, in TextureFace order) of each texture so that draws and
+    // clears only affect that layer. A layer of -1 attaches all layers, for
+    // layered rendering with gl_Layer.
+    void SelectLayer(int layer);
+
    private:
 
     OpenGLFrameBuffer(Options options);
@@ -6,15 +6,42 @@
 
 #include <forward_list>
 #include <glm/glm.hpp>
+#include <map>
 #include <memory>
+#include <string>
+#include <tuple>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include "dg/FrameBuffer.h"
 #include "dg/RasterizerState.h"
+#include "dg/Texture.h"
 
 #if defined(_OPENGL)
 #include "dg/opengl/glad/glad.h"
+#include "dg/opengl/UniformRing.h"
 
 #include <GLFW/glfw3.h>
+
+// Memory barrier bits are core in GL 4.2, which GLAD wasn't generated for.
+#ifndef GL_TEXTURE_FETCH_BARRIER_BIT
+#define GL_TEXTURE_FETCH_BARRIER_BIT 0x00000008
+#endif
+#ifndef GL_SHADER_IMAGE_ACCESS_BARRIER_BIT
+#define GL_SHADER_IMAGE_ACCESS_BARRIER_BIT 0x00000020
+#endif
+#ifndef GL_BUFFER_UPDATE_BARRIER_BIT
+#define GL_BUFFER_UPDATE_BARRIER_BIT 0x00000200
+#endif
+#ifndef GL_FRAMEBUFFER_BARRIER_BIT
+#define GL_FRAMEBUFFER_BARRIER_BIT 0x00000400
+#endif
+#ifndef GL_SHADER_STORAGE_BARRIER_BIT
+#define GL_SHADER_STORAGE_BARRIER_BIT 0x00002000
+#endif
+#ifndef GL_ALL_BARRIER_BITS
+#define GL_ALL_BARRIER_BITS 0xFFFFFFFF
+#endif
 #elif defined(_DIRECTX)
 #include <d3d11.h>
 #pragma comment(lib, "d3d11.lib")
@@ -45,6 +72,9 @@ namespace dg {
 
       virtual void OnWindowResize(Window& window) {};
 
+      // Called once at the start of each frame by the engine.
+      virtual void BeginFrame() {};
+
       virtual void SetRenderTarget(FrameBuffer &frameBuffer) = 0;
       virtual void SetRenderTarget(Window &window) = 0;
 
@@ -58,6 +88,21 @@ namespace dg {
       virtual void ClearDepthStencil(bool clearDepth = true,
                                      bool clearStencil = true) = 0;
 
+      // Restricts clears and draws to a rectangle of the render target.
+      virtual void SetScissor(int x, int y, int width, int height) = 0;
+      virtual void DisableScissor() = 0;
+
+      // Enables or disables clipping against the plane whose signed distance
+      // vertex shaders write to gl_ClipDistance[index].
+      virtual void SetClipPlaneEnabled(unsigned int index, bool enabled) = 0;
+
+      // Copies a rectangle of the depth (and color, if both have it) of one
+      // framebuffer to the same rectangle of another framebuffer of the same
+      // format. Changes the current render target to the destination.
+      virtual void CopyFrameBufferRegion(FrameBuffer &source,
+                                         FrameBuffer &destination, int x,
+                                         int y, int width, int height) = 0;
+
       void PushRasterizerState(const RasterizerState &state);
       void PopRasterizerState();
       void ApplyCurrentRasterizerState();
@@ -88,6 +133,7 @@ namespace dg {
     public:
 
       OpenGLGraphics(Window& window);
+      virtual ~OpenGLGraphics();
 
       virtual void SetRenderTarget(FrameBuffer &frameBuffer);
       virtual void SetRenderTarget(Window &window);
@@ -98,12 +144,132 @@ namespace dg {
       virtual void ClearDepthStencil(bool clearDepth = true,
                                      bool clearStencil = true);
 
+      virtual void SetScissor(int x, int y, int width, int height);
+      virtual void DisableScissor();
+      virtual void SetClipPlaneEnabled(unsigned int index, bool enabled);
+      virtual void CopyFrameBufferRegion(FrameBuffer &source,
+                                         FrameBuffer &destination, int x,
+                                         int y, int width, int height);
+
+      // Whether the context's version is at least major.minor.
+      bool SupportsVersion(int major, int minor) const;
+
+      // Whether the context supports an extension, given by its full name,
+      // such as "GL_ARB_ES3_compatibility".
+      bool SupportsExtension(const std::string &name) const;
+
+      // Whether compute programs, shader storage blocks and image load/store
+      // are available, which needs GL 4.3, or the ARB extensions for each.
+      bool SupportsCompute() const;
+
+      // Makes shader writes of the kinds in barriers, such as
+      // GL_SHADER_STORAGE_BARRIER_BIT, visible to the following commands
+      // that read them that way. Requires SupportsCompute().
+      void IssueMemoryBarrier(GLbitfield barriers);
+
+      // Binds a texture, and the sampler for its options, to a texture unit
+      // for shaders to sample. The texture and sampler last bound to each
+      // unit are remembered, so binding them again does nothing.
+      void BindTexture(unsigned int unit, const Texture &texture);
+
+      // Binds a texture to the active texture unit to edit it. Texture
+      // binds must go through here or BindTexture(), so that the units'
+      // remembered bindings stay correct.
+      void BindTextureToEdit(GLenum target, GLuint texture);
+
+      // Forgets the units a texture is bound to, since deleting it unbinds
+      // it. Called when a texture is deleted.
+      void ForgetTexture(GLuint texture);
+
+      // Sampler object for the wrap, filtering and anisotropy of texture
+      // options, shared by every texture with the same ones.
+      GLuint GetSampler(const TextureOptions &options);
+
+      // Names of the std140 uniform blocks of engine-provided uniforms
+      // declared by shared_head.glsl. The view block holds the view and
+      // projection matrices, camera position and viewport size, and the
+      // object block holds the drawn object's matrices.
+      static const char *VIEW_BLOCK_NAME;
+      static const char *OBJECT_BLOCK_NAME;
+
+      virtual void BeginFrame();
+
+      // Sets the view block for the following draws, using the current
+      // viewport's size. Does nothing if the block already holds this view,
+      // so it may be called before every draw.
+      void SetViewUniforms(const glm::mat4x4 &view,
+                           const glm::mat4x4 &projection,
+                           glm::vec3 cameraPosition);
+
+      // Sets the object block for the next draw. The model-view-projection
+      // matrix is flipped vertically if the rasterizer state says to.
+      void SetObjectUniforms(const glm::mat4x4 &model,
+                             const glm::mat4x4 &normal,
+                             const glm::mat4x4 &modelViewProjection);
+
     protected:
 
       virtual void InitializeGraphics();
       virtual void InitializeResources();
       virtual void ApplyRasterizerState(const RasterizerState &state);
 
+      // Names of the extensions the context supports.
+      std::unordered_set<std::string> extensions;
+
+      typedef void (APIENTRYP MemoryBarrierProc)(GLbitfield barriers);
+
+      // glMemoryBarrier(), or nullptr if compute isn't supported.
+      MemoryBarrierProc memoryBarrier = nullptr;
+
+      // Texture and sampler last bound to each texture unit, by unit.
+      struct TextureUnit {
+        GLenum target = GL_NONE;
+        GLuint texture = 0;
+        GLuint sampler = 0;
+      };
+      std::vector<TextureUnit> textureUnits;
+      unsigned int activeTextureUnit = 0;
+
+      void SetActiveTextureUnit(unsigned int unit);
+      TextureUnit &GetTextureUnit(unsigned int unit);
+
+      // Samplers by their wrap, min filter, mag filter and anisotropy.
+      typedef std::tuple<GLenum, GLenum, GLenum, unsigned int> SamplerKey;
+      std::map<SamplerKey, GLuint> samplers;
+
+      // Largest anisotropy samplers may use, or 0 if anisotropic filtering
+      // isn't supported.
+      float maxAnisotropy = 0;
+
+      // NOTE: Keep these structs consistent with the view and object blocks
+      //       in assets/shaders/includes/shared_head.glsl.
+      struct ViewUniforms {
+        glm::mat4x4 view = glm::mat4x4(1);
+        glm::mat4x4 projection = glm::mat4x4(1);
+        glm::vec3 cameraPosition = glm::vec3(0);
+        float _padding = 0;
+        glm::vec2 bufferDimensions = glm::vec2(0);
+        glm::vec2 _padding2 = glm::vec2(0);
+      };
+      struct ObjectUniforms {
+        glm::mat4x4 modelViewProjection = glm::mat4x4(1);
+        glm::mat4x4 model = glm::mat4x4(1);
+        glm::mat4x4 normal = glm::mat4x4(1);
+      };
+
+      // Both blocks are written into one ring buffer, and bound by offset.
+      UniformRing uniformRing;
+      GLuint viewBinding = 0;
+      GLuint objectBinding = 0;
+
+      // View block last bound, and the ring generation it was bound from.
+      // Rebound when the view changes, as well as every frame and whenever
+      // the ring moves to a new buffer, since the range it was written to
+      // is then reused or gone.
+      ViewUniforms currentView;
+      bool viewBound = false;
+      unsigned int viewGeneration = 0;
+
       static GLenum ToGLEnum(RasterizerState::CullMode cullMode);
       static GLenum ToGLEnum(RasterizerState::DepthFunc depthFunc);
       static GLenum ToGLEnum(RasterizerState::BlendEquation blendEquation);
@@ -133,6 +299,13 @@ namespace dg {
       virtual void ClearDepthStencil(bool clearDepth = true,
                                      bool clearStencil = true);
 
+      virtual void SetScissor(int x, int y, int width, int height);
+      virtual void DisableScissor();
+      virtual void SetClipPlaneEnabled(unsigned int index, bool enabled);
+      virtual void CopyFrameBufferRegion(FrameBuffer &source,
+                                         FrameBuffer &destination, int x,
+                                         int y, int width, int height);
+
       ID3D11Device *device;
       ID3D11DeviceContext *context;
       D3D_FEATURE_LEVEL dxFeatureLevel;
@@ -0,0 +1,143 @@
+//
+//  LightClusters.h
+//
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "dg/Lights.h"
+#include "dg/Texture.h"
+
+namespace dg {
+
+  // Clustered forward light assignment.
+  //
+  // The view frustum is divided into a grid of "froxels": TILES_X by TILES_Y
+  // screen-space tiles, each split into SLICES depth slices spaced
+  // exponentially between the near and far clip planes. Each frame, every
+  // point and spot light's bounding volume (derived from its attenuation and
+  // cone) is tested against the clusters it could touch, producing a compact
+  // list of light indices per cluster. The standard shader then looks up the
+  // cluster of each fragment and only evaluates the lights in that cluster,
+  // so the cost per fragment scales with local light density instead of the
+  // total number of lights in the scene.
+  //
+  // Directional lights, and any lights whose attenuation never falls off,
+  // affect every cluster. These are placed at the front of the light list as
+  // "global" lights and evaluated for every fragment.
+  //
+  // Build() is pure CPU work and touches no graphics API, so it can be run
+  // and inspected without a GPU. UploadTextures() copies the results into
+  // buffer textures for the shader to read.
+  //
+  // NOTE: Keep these values and texture layouts consistent with:
+  //       -> assets/shaders/includes/light_clusters.glsl.
+  class LightClusters {
+
+    public:
+
+      static const unsigned int TILES_X = 16;
+      static const unsigned int TILES_Y = 9;
+      static const unsigned int SLICES = 24;
+      static const unsigned int CLUSTER_COUNT = TILES_X * TILES_Y * SLICES;
+
+      // Number of RGBA32F texels used to store one Light::ShaderData.
+      static const unsigned int TEXELS_PER_LIGHT =
+          sizeof(Light::ShaderData) / sizeof(glm::vec4);
+
+      // Light intensity below which a light is considered to have no effect.
+      // Used to derive a finite range from a light's attenuation.
+      static const float ATTENUATION_THRESHOLD;
+
+      // Per-cluster entry of the light grid. The cluster's light indices are
+      // indices[offset] through indices[offset + count - 1].
+      struct Cluster {
+        uint32_t offset = 0;
+        uint32_t count = 0;
+      };
+
+      // Assigns lights to clusters for a view.
+      //
+      // `view` and `projection` must be the same matrices used to draw the
+      // subrender, and `nearClip` and `farClip` the clip distances used to
+      // build `projection`. Lights of type NONE are ignored.
+      void Build(const glm::mat4x4 &view, const glm::mat4x4 &projection,
+                 float nearClip, float farClip,
+                 const Light::ShaderData *lights, size_t lightCount);
+
+      // Distance beyond which a point or spot light contributes less than
+      // ATTENUATION_THRESHOLD, or infinity if its attenuation never gets
+      // that low.
+      static float LightRange(const Light::ShaderData &light);
+
+      // Index of the cluster containing tile (x, y) and depth slice z.
+      static inline unsigned int ClusterIndex(unsigned int x, unsigned int y,
+                                              unsigned int z) {
+        return (z * TILES_Y + y) * TILES_X + x;
+      }
+
+      // Lights in the order referenced by the index lists. The first
+      // GetGlobalLightCount() lights apply to every cluster.
+      const std::vector<Light::ShaderData> &GetLights() const;
+      unsigned int GetGlobalLightCount() const;
+
+      const std::vector<Cluster> &GetClusters() const;
+      const std::vector<uint32_t> &GetIndices() const;
+
+      // Returns (scale, bias, isPerspective) such that a fragment at view
+      // depth d lies in slice floor(log(d) * scale + bias) for perspective
+      // projections, or floor(d * scale + bias) for orthographic ones.
+      glm::vec3 GetDepthSlicing() const;
+
+      // Copies the most recent Build() results to the GPU, growing the
+      // buffer textures as needed.
+      void UploadTextures();
+
+      std::shared_ptr<Texture> GetLightDataTexture() const;
+      std::shared_ptr<Texture> GetGridTexture() const;
+      std::shared_ptr<Texture> GetIndexTexture() const;
+
+    private:
+
+      // View-space axis-aligned bounds of a single cluster.
+      struct Bounds {
+        glm::vec3 min;
+        glm::vec3 max;
+      };
+
+      Bounds ClusterBounds(unsigned int x, unsigned int y,
+                           unsigned int z) const;
+      float SliceDepth(unsigned int slice) const;
+      unsigned int DepthSlice(float depth) const;
+      void TileRange(const glm::vec3 &center, float radius, float minDepth,
+                     float maxDepth, glm::uvec2 &min, glm::uvec2 &max) const;
+
+      static void EnsureCapacity(std::shared_ptr<Texture> &texture,
+                                 TexturePixelType pixelType,
+                                 unsigned int texels);
+
+      // Parameters of the view most recently built.
+      glm::mat4x4 projection = glm::mat4x4(1);
+      float nearClip = 0.1f;
+      float farClip = 100.f;
+      bool perspective = true;
+
+      std::vector<Light::ShaderData> lights;
+      unsigned int globalLightCount = 0;
+      std::vector<Cluster> clusters = std::vector<Cluster>(CLUSTER_COUNT);
+      std::vector<uint32_t> indices;
+
+      // Scratch list of (cluster, light) pairs, kept between frames to avoid
+      // reallocation.
+      std::vector<std::pair<uint32_t, uint32_t>> assignments;
+
+      std::shared_ptr<Texture> lightDataTexture = nullptr;
+      std::shared_ptr<Texture> gridTexture = nullptr;
+      std::shared_ptr<Texture> indexTexture = nullptr;
+
+  }; // class LightClusters
+
+} // namespace dg
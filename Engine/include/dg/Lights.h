@@ -16,14 +16,21 @@ namespace dg {
 
     public:
 
+      // Size of the fixed light array sent to shaders that don't use
+      // clustered lighting (see LightClusters), which have no limit.
+      //
       // NOTE: Keep these values consistent with:
-      //       -> assets/shaders/fragment_head.glsl
+      //       -> assets/shaders/includes/shared_head.glsl
       //       -> assets/shaders/StandardPixelShader.hlsl.
       static const char *LIGHTS_ARRAY_NAME;
       static const int MAX_LIGHTS = 8;
 
+      // Name of the std140 uniform block holding the light array in OpenGL
+      // shaders, which the scene uploads once per subrender.
+      static const char *LIGHTS_BLOCK_NAME;
+
       // NOTE: Keep this struct consistent with:
-      //       -> assets/shaders/fragment_head.glsl
+      //       -> assets/shaders/includes/shared_head.glsl
       //       -> assets/shaders/StandardPixelShader.hlsl.
       enum class LightType : uint32_t {
         NONE        = 0,
@@ -33,11 +40,14 @@ namespace dg {
       };
 
       // Struct size must be a multiple of 16 bytes, and vectors cannot
-      // cross 16-byte boundaries. Hence the confusing order and 3 bytes of
+      // cross 16-byte boundaries. Hence the confusing order and 4 bytes of
       // padding.
       //
+      // The same layout is used for the std140 light block.
+      //
       // NOTE: Keep this struct consistent with:
-      //       -> assets/shaders/fragment_head.glsl
+      //       -> assets/shaders/includes/shared_head.glsl
+      //       -> assets/shaders/includes/light_clusters.glsl
       //       -> assets/shaders/StandardPixelShader.hlsl.
       struct ShaderData {
         glm::vec3 diffuse;
@@ -52,7 +62,8 @@ namespace dg {
         float linearCoeff = 0.14f;
         float quadraticCoeff = 0.07f;
         int hasShadow = 0;
-        glm::vec2 _padding;
+        int shadowIndex = 0;
+        float _padding;
         glm::mat4x4 lightTransform;
       };
 
@@ -61,13 +72,19 @@ namespace dg {
       void SetSpecular(const glm::vec3& specular);
       void SetShadowMap(std::shared_ptr<Texture> shadowMap);
       void SetCastShadows(bool castShadows);
+      void SetShadowResolution(unsigned int resolution);
       void SetLightTransform(const glm::mat4x4 &xf);
 
+      // Which of the shader's point light shadow maps belongs to this light.
+      // Only used by point lights.
+      void SetShadowIndex(int index);
+
       glm::vec3 GetAmbient() const;
       glm::vec3 GetDiffuse() const;
       glm::vec3 GetSpecular() const;
       std::shared_ptr<Texture> GetShadowMap() const;
       bool GetCastShadows() const;
+      unsigned int GetShadowResolution() const;
       const glm::mat4x4 &GetLightTransform() const;
 
       virtual ShaderData GetShaderData() const;
@@ -82,6 +99,11 @@ namespace dg {
       std::shared_ptr<Texture> shadowMap = nullptr;
       bool castShadows = false;
 
+      // Requested width and height of this light's region of the scene's
+      // shadow atlas, rounded down to a power of two and reduced further if
+      // the atlas is full. For point lights, the size of each cube face.
+      unsigned int shadowResolution = 2048;
+
   }; // class Light
 
   class DirectionalLight : public Light {
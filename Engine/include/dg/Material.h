@@ -5,13 +5,22 @@
 
 #include <memory>
 #include <unordered_map>
+#include <vector>
 #include "dg/Lights.h"
+#include "dg/PointShadowMap.h"
 #include "dg/RasterizerState.h"
 #include "dg/Shader.h"
 #include "dg/Texture.h"
 
+#if defined(_OPENGL)
+#include "dg/opengl/UniformBuffer.h"
+#endif
+
 namespace dg {
 
+  class LightClusters;
+  class ShadowCascades;
+
   // Value for rendering order.
   enum class RenderQueue : int {
     Background  = 1000,
@@ -61,6 +70,13 @@ namespace dg {
         VEC4,
         MAT4X4,
         TEXTURE,
+
+        // Arrays, whose elements are stored in Property::array.
+        FLOAT_ARRAY,
+        VEC2_ARRAY,
+        VEC3_ARRAY,
+        VEC4_ARRAY,
+        MAT4X4_ARRAY,
       };
 
       union PropertyValue {
@@ -81,10 +97,30 @@ namespace dg {
         PropertyType type = PropertyType::NONE;
         PropertyValue value;
         std::shared_ptr<Texture> texture = nullptr;
-        int texUnitHint = -1;
+
+        // Texture unit the texture is bound to. Either the hint it was set
+        // with, or the unit shared by texture properties of its name.
+        unsigned int texUnit = 0;
+
+        // Tightly packed elements of an array property.
+        std::vector<float> array;
+
+        // Shader::HashUniformName() of the property's name.
+        uint64_t nameHash = 0;
+
+        // Whether the property is a member of the property block, as last
+        // laid out.
+        mutable bool inBlock = false;
       };
 
+      // Name of the std140 uniform block shaders may declare material
+      // properties in. Properties in the block are uploaded to a buffer
+      // owned by the material when they change, instead of being sent as
+      // uniforms every time the material is used.
+      static const char *PROPERTY_BLOCK_NAME;
+
       Material() = default;
+      virtual ~Material() = default;
 
       Material(Material& other);
       Material(Material&& other);
@@ -101,6 +137,25 @@ namespace dg {
       void SetProperty(const std::string& name, glm::vec3 value);
       void SetProperty(const std::string& name, glm::vec4 value);
       void SetProperty(const std::string& name, glm::mat4x4 value);
+
+      // Array properties are uploaded with one call for the whole array,
+      // which is set by its name without an index, such as "_Samples".
+      void SetProperty(const std::string& name,
+                       const std::vector<float>& values);
+      void SetProperty(const std::string& name,
+                       const std::vector<glm::vec2>& values);
+      void SetProperty(const std::string& name,
+                       const std::vector<glm::vec3>& values);
+      void SetProperty(const std::string& name,
+                       const std::vector<glm::vec4>& values);
+      void SetProperty(const std::string& name,
+                       const std::vector<glm::mat4x4>& values);
+
+      // Sets an array property from elements that aren't in a vector. Setting
+      // an array of the same length again reuses its storage.
+      void SetProperty(const std::string& name, const glm::mat4x4 *values,
+                       size_t count);
+
       void SetProperty(
           const std::string& name, std::shared_ptr<Texture> value);
       void SetProperty(const std::string &name, std::shared_ptr<Texture> value,
@@ -108,6 +163,15 @@ namespace dg {
 
       void ClearProperty(const std::string& name);
 
+      // Enables or disables a keyword, which is defined in the variant of
+      // the shader the material is drawn with. Shaders use keywords to
+      // leave out features the material doesn't use, instead of branching
+      // on a uniform for them.
+      void SetKeyword(const std::string& keyword, bool enabled);
+      bool HasKeyword(const std::string& keyword) const;
+
+      // Used by the DirectX build. The OpenGL build sends these through
+      // the view and object uniform blocks of OpenGLGraphics instead.
       void SendBufferDimensions(glm::vec2 dimensions);
       void SendCameraPosition(glm::vec3 position);
       void SendMatrixMVP(glm::mat4x4 mvp);
@@ -117,6 +181,15 @@ namespace dg {
       void SendMatrixNormal(glm::mat4x4 normal);
       void SendLights(const Light::ShaderData(&lights)[Light::MAX_LIGHTS]);
       void SendShadowMap(std::shared_ptr<Texture> shadowMap);
+      void SendLightClusters(const LightClusters &clusters);
+      void SendShadowCascades(const ShadowCascades &cascades);
+      void SendPointShadowMaps(
+          const std::vector<std::shared_ptr<Texture>> &shadowMaps);
+
+      // Enables or disables single-pass stereo in the vertex shader. Must be
+      // disabled again after drawing, since it outlives the material.
+      void SendStereo(bool stereo,
+                      const glm::mat4x4 *reprojections = nullptr);
 
       void Use() const;
 
@@ -127,25 +200,85 @@ namespace dg {
 
       enum class TexUnitHints {
         SHADOWMAP = 0,
+        LIGHT_DATA,
+        LIGHT_GRID,
+        LIGHT_INDICES,
+        CASCADED_SHADOWMAP,
+        POINT_SHADOWMAPS,
 
-        END,
+        END = POINT_SHADOWMAPS + PointShadowMap::MAX_SHADOWED_LIGHTS,
       };
 
-      static const std::string LightProperty(
-          int index, const std::string& property);
+      virtual void SendShaderProperties() const;
 
-#if defined(_OPENGL)
-      void SendLight(int index, const Light::ShaderData& data);
-      void ClearLights();
-      void ClearLight(int index);
-#endif
+      // Variant of the shader for the material's keywords, which is the one
+      // that's used and sent uniforms.
+      Shader &GetActiveShader() const;
 
-      virtual void SendShaderProperties() const;
+      // Sends this material's properties to a shader, which may be other
+      // than its own.
+      void SendProperties(Shader &target) const;
 
     private:
 
+      void StoreProperty(const std::string& name, Property& property);
+
+      template <typename T>
+      void StoreArrayProperty(const std::string& name, PropertyType type,
+                              const T *values, size_t count);
+
+#if defined(_OPENGL)
+      // Lays out the property block for a shader's block, and writes every
+      // property into it.
+      void BuildPropertyBlock(
+          std::shared_ptr<const OpenGLShader::UniformBlock> layout) const;
+
+      // Writes a property into the property block if it's a member of it,
+      // and marks the bytes written as changed.
+      void WriteBlockProperty(const Property& property) const;
+
+      // Extends the changed range of the property block.
+      void MarkBlockDirty(size_t begin, size_t end) const;
+
+      // Uploads the changed range of the property block, and binds it.
+      void BindPropertyBlock() const;
+#endif
+
       std::unordered_map<std::string, Property> properties;
-      unsigned int highestTexUnitHint = 0;
+
+      // Texture unit for unhinted texture properties of a name. Every
+      // material binds them to the same unit, so that consecutive draws of
+      // materials sharing a texture leave it bound.
+      static unsigned int GetSharedTexUnit(const std::string &name);
+
+      static std::unordered_map<std::string, unsigned int> sharedTexUnits;
+
+      // Next shared texture unit. Starts after the units reserved for
+      // engine-provided textures, and is kept after every hinted unit.
+      static unsigned int nextSharedTexUnit;
+
+      // Enabled keywords, sorted.
+      std::vector<std::string> keywords;
+
+      // Variant of variantBase for the keywords, or nullptr if it needs to
+      // be looked up again.
+      mutable std::shared_ptr<Shader> variant;
+      mutable std::shared_ptr<Shader> variantBase;
+
+#if defined(_OPENGL)
+      // Properties packed into the std140 layout of the shader's
+      // PROPERTY_BLOCK_NAME block, and the buffer they're uploaded to. The
+      // block is laid out again when used with a shader whose block has a
+      // different layout.
+      mutable std::shared_ptr<const OpenGLShader::UniformBlock> blockLayout;
+      mutable std::vector<uint8_t> blockData;
+      mutable std::unique_ptr<UniformBuffer> blockBuffer;
+
+      // Range of blockData changed since it was last uploaded. Empty when
+      // dirtyBegin >= dirtyEnd.
+      mutable size_t dirtyBegin = 0;
+      mutable size_t dirtyEnd = 0;
+#endif
 
   }; // class Material
 
@@ -15,6 +15,7 @@
 #include <memory>
 #include <unordered_map>
 #include <vector>
+#include "dg/Bounds.h"
 #include "dg/Utils.h"
 
 namespace dg {
@@ -136,7 +137,18 @@ namespace dg {
 
       const Vertex GetVertex(int i) const;
 
-      virtual void Draw() const;
+      // Vertex positions and triangle indices, which are kept on the CPU
+      // after the mesh is built.
+      const std::vector<glm::vec3> &GetPositions() const;
+      const std::vector<unsigned int> &GetIndices() const;
+
+      // Local-space bounds of all vertex positions added so far.
+      const AABB &GetBounds() const;
+
+      // Draws the mesh. With more than one instance, it's drawn that many
+      // times in one instanced draw call, and shaders tell the instances
+      // apart with gl_InstanceID.
+      virtual void Draw(unsigned int instances = 1) const;
       virtual bool IsDrawable() const = 0;
 
     protected:
@@ -152,6 +164,8 @@ namespace dg {
       std::vector<glm::vec3> vertexTangents;
       std::vector<unsigned int> indices;
 
+      AABB bounds = AABB::Empty();
+
       // Bitmask of which attributes this mesh's vertices have.
       // If no vertices added yet, value is NONE.
       Vertex::AttrFlag attributes = Vertex::AttrFlag::NONE;
@@ -186,7 +200,7 @@ namespace dg {
 
       virtual void FinishBuilding();
 
-      virtual void Draw() const;
+      virtual void Draw(unsigned int instances = 1) const;
       virtual bool IsDrawable() const;
 
     private:
@@ -213,7 +227,7 @@ namespace dg {
 
       virtual void FinishBuilding();
 
-      virtual void Draw() const;
+      virtual void Draw(unsigned int instances = 1) const;
       virtual bool IsDrawable() const;
 
     private:
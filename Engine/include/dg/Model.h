@@ -4,12 +4,15 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 #include <glm/mat4x4.hpp>
 
+#include "dg/LightClusters.h"
 #include "dg/Material.h"
 #include "dg/Mesh.h"
 #include "dg/Scene.h"
 #include "dg/SceneObject.h"
+#include "dg/ShadowCascades.h"
 
 namespace dg {
 
@@ -23,6 +26,15 @@ namespace dg {
         const glm::vec3 *cameraPos = nullptr;
         const Light::ShaderData (*lights)[Light::MAX_LIGHTS] = nullptr;
         std::shared_ptr<Texture> shadowMap = nullptr;
+        const LightClusters *lightClusters = nullptr;
+        const ShadowCascades *shadowCascades = nullptr;
+        const std::vector<std::shared_ptr<Texture>> *pointShadowMaps = nullptr;
+
+        // Draw both eyes at once with instancing. `view` and `projection`
+        // then enclose both eyes, and these map from their clip space to
+        // each eye's.
+        bool stereo = false;
+        glm::mat4x4 stereoReprojections[2];
       };
 
       Model();
@@ -37,12 +49,42 @@ namespace dg {
       std::shared_ptr<Material> material = nullptr;
       Scene::LayerMask layer = Scene::LayerMask::Default();
 
+      // Hint that this model rarely moves, so its depth can be cached in
+      // shadow maps. Static models may still move, but doing so invalidates
+      // the cached shadow maps they're in.
+      bool isStatic = false;
+
+      // Simplified mesh, in the same space as `mesh`, that hides whatever
+      // is behind it from the scene's occlusion culler. Should be entirely
+      // inside of the model's rendered surface. If nullptr, this model
+      // doesn't occlude anything.
+      std::shared_ptr<Mesh> occluder = nullptr;
+
+      // Scene-space bounds of the mesh, using the cached scene-space
+      // transform.
+      AABB SceneBounds() const;
+
+      // Points the model at its model and normal matrices for the current
+      // frame, which the Scene computes once for all models it renders. If
+      // nullptr, they're computed from the cached scene-space transform when
+      // needed.
+      void SetCachedMatrices(const glm::mat4x4 *modelMatrix,
+                             const glm::mat4x4 *normalMatrix);
+
+      glm::mat4x4 ModelMatrix() const;
+      glm::mat4x4 NormalMatrix() const;
+
       void Draw(glm::mat4x4 view, glm::mat4x4 projection,
                 Material *material = nullptr) const;
 
       void Draw(const DrawContext &context,
                 Material *material = nullptr) const;
 
+    private:
+
+      const glm::mat4x4 *cachedModelMatrix = nullptr;
+      const glm::mat4x4 *cachedNormalMatrix = nullptr;
+
   }; // class Model
 
 } // namespace dg
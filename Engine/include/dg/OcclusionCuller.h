@@ -0,0 +1,93 @@
+//
+//  OcclusionCuller.h
+//
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+#include "dg/Bounds.h"
+
+namespace dg {
+
+  class Mesh;
+
+  // Software occlusion culling against a low-resolution depth buffer.
+  //
+  // Each view, a few large occluder meshes are rasterized on the CPU into a
+  // small depth buffer, which is divided into tiles that are rasterized
+  // independently of each other, four pixels of a row at a time where SSE
+  // or NEON is available. A hierarchical-Z pyramid is then built
+  // where each texel holds the farthest depth of the four below it, so that
+  // the screen-space bounds of any model can be tested against a handful of
+  // texels: if the nearest point of the bounds is farther than the farthest
+  // occluder depth in every texel it covers, it's hidden.
+  //
+  // Depths are window-space depths in [0, 1] of the view's projection.
+  class OcclusionCuller {
+
+    public:
+
+      struct Options {
+        // Whether scenes should use the culler at all.
+        bool enabled = false;
+
+        // Size of the depth buffer. Both must be powers of two.
+        unsigned int width = 256;
+        unsigned int height = 128;
+      };
+
+      Options options;
+
+      // Clears the depth buffer, and prepares to rasterize occluders for a
+      // view with the given projection * view matrix.
+      void Begin(const glm::mat4x4 &viewProjection);
+
+      // Projects the triangles of an occluder mesh and bins them into the
+      // tiles they overlap. Both faces of each triangle occlude.
+      void RasterizeOccluder(const Mesh &mesh, const glm::mat4x4 &modelMatrix);
+
+      // Rasterizes every tile of the depth buffer and builds the
+      // hierarchical-Z pyramid. Must be called after all occluders are
+      // added, and before any visibility tests.
+      void Finish();
+
+      // Conservatively tests whether any part of a scene-space box may be
+      // visible past the occluders.
+      bool IsVisible(const AABB &bounds) const;
+
+      // Number of occluder triangles rasterized since Begin().
+      unsigned int GetTriangleCount() const;
+
+    private:
+
+      static const unsigned int TILE_SIZE = 32;
+
+      // Triangle in window space, with x and y in pixels and z in [0, 1].
+      struct ScreenTriangle {
+        glm::vec3 vertices[3];
+        glm::ivec2 min;
+        glm::ivec2 max;
+      };
+
+      void SetUpTriangle(const glm::vec4 (&clip)[3]);
+      void RasterizeTile(unsigned int tileX, unsigned int tileY);
+
+      glm::mat4x4 viewProjection = glm::mat4x4(1);
+      unsigned int width = 0;
+      unsigned int height = 0;
+      unsigned int tilesX = 0;
+      unsigned int tilesY = 0;
+
+      std::vector<ScreenTriangle> triangles;
+
+      // Indices into triangles of those overlapping each tile.
+      std::vector<std::vector<unsigned int>> tileBins;
+
+      // Depth pyramid. Level 0 is the full-resolution depth buffer, and each
+      // following level is half the size of the one before.
+      std::vector<std::vector<float>> levels;
+
+  }; // class OcclusionCuller
+
+} // namespace dg
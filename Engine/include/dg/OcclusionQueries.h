@@ -0,0 +1,119 @@
+//
+//  OcclusionQueries.h
+//
+
+#pragma once
+
+#include <functional>
+#include <glm/glm.hpp>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "dg/Bounds.h"
+
+#if defined(_OPENGL)
+#include "dg/opengl/glad/glad.h"
+#endif
+
+namespace dg {
+
+  class Model;
+  class UVMaterial;
+
+  // GPU occlusion culling of expensive models, using occlusion queries.
+  //
+  // Each queried model is drawn inside a query counting whether any of its
+  // samples passed the depth test. The result is only read on a later frame,
+  // once the GPU reports it's available, so the CPU never waits on the GPU.
+  // Models whose last result was hidden aren't drawn; instead their bounding
+  // box is drawn into a new query without writing color or depth, and the
+  // model is then drawn with conditional rendering on that query, which the
+  // GPU skips if it knows in time that the box was hidden. Models whose
+  // query is still in flight from an earlier frame are drawn the same way,
+  // conditioned on that query, if they were hidden before it.
+  //
+  // Models are drawn in the order the caller gives them, so queries only see
+  // occluders drawn before the model. Scenes sort opaque models front to
+  // back, which suits this.
+  //
+  // Only implemented in the OpenGL build. In the DirectX build, every model
+  // is simply drawn.
+  class OcclusionQueries {
+
+    public:
+
+      struct Options {
+        // Whether scenes should use occlusion queries at all.
+        bool enabled = false;
+
+        // Number of triangles a model's mesh must have to be queried. For
+        // cheaper models, the query costs more than it could save.
+        unsigned int minTriangles = 2000;
+      };
+
+      Options options;
+
+      OcclusionQueries();
+      ~OcclusionQueries();
+
+      OcclusionQueries(const OcclusionQueries &) = delete;
+      OcclusionQueries &operator=(const OcclusionQueries &) = delete;
+
+      // Starts drawing a view. Query results are kept separately for each
+      // view, identified by any pointer that stays the same between frames,
+      // such as its subrender.
+      void BeginView(const void *view);
+
+      // Whether a model is expensive enough to be queried.
+      bool IsQueried(const Model &model) const;
+
+      // Draws a model of the current view by calling draw(), unless earlier
+      // queries found it hidden. viewProjection is the projection * view
+      // matrix it's drawn with.
+      void Draw(const Model &model, const glm::mat4x4 &viewProjection,
+                const std::function<void()> &draw);
+
+      // Finishes drawing the current view. Releases the queries of models
+      // that weren't drawn in it.
+      void EndView();
+
+    private:
+
+#if defined(_OPENGL)
+      struct Query {
+        GLuint handle = 0;
+
+        // Whether the query was issued, and its result not yet read.
+        bool pending = false;
+
+        // Whether the model was visible as of the last result read. Models
+        // start out visible, so that they're drawn while their first
+        // query is in flight.
+        bool visible = true;
+
+        // Whether the model was drawn in the current view.
+        bool drawn = false;
+      };
+
+      // Draws a box into the depth buffer, without writing to it or to
+      // color.
+      void DrawBounds(const AABB &bounds, const glm::mat4x4 &viewProjection);
+
+      // Any-samples-passed target to query, the conservative one if
+      // supported.
+      GLenum target = GL_ANY_SAMPLES_PASSED;
+
+      std::unordered_map<const void *,
+                         std::unordered_map<const Model *, Query>>
+          views;
+      std::unordered_map<const Model *, Query> *currentView = nullptr;
+
+      // Query objects released by models no longer drawn, to be reused.
+      std::vector<GLuint> freeHandles;
+
+      std::shared_ptr<UVMaterial> boundsMaterial = nullptr;
+#endif
+
+  }; // class OcclusionQueries
+
+} // namespace dg
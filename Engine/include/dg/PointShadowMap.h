@@ -0,0 +1,85 @@
+//
+//  PointShadowMap.h
+//
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <memory>
+#include "dg/FrameBuffer.h"
+#include "dg/Texture.h"
+
+namespace dg {
+
+  // Omnidirectional shadow map of a point light, stored in a depth cubemap.
+  //
+  // All six faces are rendered in one pass with layered rendering: a
+  // geometry shader emits each caster's triangles only to the faces whose
+  // frustums the caster's bounds intersect, as determined on the CPU. The
+  // depth written is the distance from the light divided by the far clip,
+  // rather than the projected depth, so that shaders can compare it against
+  // a fragment's distance without knowing which face it falls in.
+  //
+  // Each face remembers what was last rendered into it, so faces whose
+  // casters are all static and unchanged aren't rendered again.
+  //
+  // NOTE: Keep MAX_SHADOWED_LIGHTS consistent with:
+  //       -> assets/shaders/standard.f.glsl
+  class PointShadowMap {
+
+    public:
+
+      // Maximum number of point lights that can cast shadows at once.
+      static const unsigned int MAX_SHADOWED_LIGHTS = 4;
+
+      static const int FACE_COUNT = 6;
+
+      // Distance from the light within which nothing casts shadows.
+      static const float NEAR_CLIP;
+
+      struct Face {
+        // Hash of the static casters (and their transforms) that were drawn
+        // into this face.
+        std::size_t staticCasterHash = 0;
+
+        // Whether this face holds a valid render of its static casters.
+        bool valid = false;
+
+        // Whether dynamic casters were drawn into this face last time it was
+        // rendered. If so, it must be rendered again to remove them even if
+        // there are no dynamic casters now.
+        bool hadDynamicCasters = false;
+      };
+
+      Face faces[FACE_COUNT];
+
+      PointShadowMap(unsigned int resolution);
+
+      // Moves the origin of the shadow map and sets its range. Invalidates
+      // every face if either changed.
+      void SetOrigin(glm::vec3 position, float farClip);
+
+      glm::vec3 GetPosition() const;
+      float GetFarClip() const;
+      unsigned int GetResolution() const;
+
+      glm::mat4x4 GetViewMatrix(TextureFace face) const;
+      glm::mat4x4 GetProjectionMatrix() const;
+
+      // Matrix mapping scene space to the light's position, scaled by
+      // 1 / far clip. A transformed point's direction is its cubemap lookup
+      // vector, and its length is comparable to the depth stored there.
+      glm::mat4x4 GetLightTransform() const;
+
+      std::shared_ptr<FrameBuffer> GetFrameBuffer() const;
+      std::shared_ptr<Texture> GetTexture() const;
+
+    private:
+
+      glm::vec3 position = glm::vec3(0);
+      float farClip = 0;
+      std::shared_ptr<FrameBuffer> framebuffer;
+
+  }; // class PointShadowMap
+
+} // namespace dg
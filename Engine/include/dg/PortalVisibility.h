@@ -0,0 +1,117 @@
+//
+//  PortalVisibility.h
+//
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+#include "dg/Bounds.h"
+#include "dg/FrameAllocator.h"
+#include "dg/Transform.h"
+
+namespace dg {
+
+  // Cell and portal visibility, for scenes made of enclosed regions such as
+  // rooms or caves.
+  //
+  // Scenes divide the space they want culled into cells, which are boxes,
+  // and connect neighboring cells with portals, which are the convex
+  // openings between them. For each view, the cells reachable from the
+  // camera's cell are found by flood filling through portals. Each portal
+  // passed through narrows the view volume to what can be seen through it,
+  // and portals outside of the narrowed volume are not passed through.
+  // Models are then only visible if they're in a reached cell, and within
+  // one of the volumes it was reached through.
+  //
+  // Models that aren't in any cell are always visible, as is everything
+  // when the camera isn't in a cell.
+  class PortalVisibility {
+
+    public:
+
+      struct Options {
+        // Largest number of portals to see through in a row.
+        unsigned int maxPortalDepth = 8;
+      };
+
+      Options options;
+
+      // Adds a cell covering a scene-space box, and returns its index.
+      unsigned int AddCell(const AABB &bounds);
+
+      // Connects two cells with a portal whose corners are given in
+      // scene space, in order around its edge. The opening must be convex
+      // and planar.
+      void AddPortal(unsigned int cellA, unsigned int cellB,
+                     const std::vector<glm::vec3> &corners);
+
+      // Connects two cells with a portal in the shape of Mesh::Quad after
+      // being transformed, matching a quad model drawn as the opening.
+      void AddPortal(unsigned int cellA, unsigned int cellB,
+                     const Transform &quad);
+
+      // Removes all cells and portals.
+      void Clear();
+
+      unsigned int GetCellCount() const;
+
+      // Finds the cells visible to a view from its camera position and
+      // projection * view matrix.
+      void Update(glm::vec3 cameraPosition,
+                  const glm::mat4x4 &viewProjection);
+
+      // Tests whether a scene-space box may be seen from the view given to
+      // the last Update().
+      bool IsVisible(const AABB &bounds) const;
+
+      // Whether a cell was reached by the last Update().
+      bool IsCellVisible(unsigned int cell) const;
+
+    private:
+
+      // Convex volume, where a point p is inside if dot(normal, p) +
+      // distance >= 0 for each plane (normal, distance). Volumes kept by
+      // cells are read until the next Update(), which may be frames later,
+      // so they use the heap. Volumes only used while flooding use frame
+      // memory.
+      typedef std::vector<glm::vec4> Volume;
+      typedef FrameVector<glm::vec4> FrameVolume;
+
+      struct Cell {
+        AABB bounds;
+        std::vector<unsigned int> portals;
+
+        // Volumes the cell was seen through in the last Update() are the
+        // first volumeCount. The rest are left from earlier updates, so
+        // that their storage is reused instead of freed.
+        std::vector<Volume> volumes;
+        size_t volumeCount = 0;
+      };
+
+      struct Portal {
+        unsigned int cells[2];
+        std::vector<glm::vec3> corners;
+        glm::vec4 plane = glm::vec4(0);
+      };
+
+      void Flood(unsigned int cell, const FrameVolume &volume,
+                 unsigned int depth);
+
+      static bool Intersects(const Volume &volume, const AABB &box);
+
+      std::vector<Cell> cells;
+      std::vector<Portal> portals;
+
+      glm::vec3 cameraPosition = glm::vec3(0);
+
+      // Whether the camera was in a cell in the last Update().
+      bool inCell = false;
+
+      // Cells on the path from the camera's cell to the one being flooded,
+      // so the flood doesn't loop back through them.
+      std::vector<unsigned int> path;
+
+  }; // class PortalVisibility
+
+} // namespace dg
@@ -5,6 +5,8 @@
 #pragma once
 
 #include <cassert>
+#include <cstdint>
+#include <map>
 #include <memory>
 #include <set>
 #include <string>
@@ -14,25 +16,73 @@
 
 namespace dg {
 
+  // Expands #include "file" directives of shader files, inserting #line
+  // directives so that compile errors point back to the original files.
+  //
+  // Files are shared by the whole process. Each is loaded and split into
+  // its text and includes once, and its processed content is kept until it
+  // or a file it includes is invalidated. The files including each file are
+  // recorded, so that invalidating a header only drops the processed
+  // content of the files that include it.
+  //
+  // Not thread-safe. Only use from the main thread.
   class Preprocessor {
 
     public:
 
-      static std::shared_ptr<Preprocessor> ForFile(const std::string &filename);
+      // Processed content of a file, with its includes expanded, and a
+      // #define for each of defines after its #version directive. Calls for
+      // the same file and defines share the content until it's
+      // invalidated.
+      static std::shared_ptr<const std::string> Process(
+          const std::string &filename,
+          const std::vector<std::string> &defines = {});
 
-      const std::string &GetProcessedContent();
-      inline const std::string &GetFilename() const {
-        return filename;
-      }
+      // Files that include a file, directly or through other includes, as
+      // of their last processing.
+      static std::vector<std::string> GetDependents(
+          const std::string &filename);
+
+      // Reloads a file from disk. If its content changed, returns it and
+      // every file that includes it, whose processed content is dropped.
+      // Returns nothing if its content didn't change.
+      static std::vector<std::string> Invalidate(const std::string &filename);
+
+      // Forgets every file.
+      static void Clear();
 
     private:
 
+      // Run of text lines, or an #include directive.
+      struct Segment {
+        std::string text;
+
+        // Flattened path of the included file, if it's an #include.
+        std::string include;
+
+        // Line number of the #include.
+        int line = 0;
+      };
+
       struct File {
         std::string filename;
-        std::vector<std::string> lines;
-        std::string processedContent;
-        int id;
-        bool processed = false;
+
+        // Source string number of the file in #line directives.
+        int id = 0;
+
+        uint64_t contentHash = 0;
+        std::vector<Segment> segments;
+
+        // Files included directly, as of the last processing.
+        std::vector<std::string> includes;
+
+        // Processed content, or nullptr if it needs to be processed again.
+        std::shared_ptr<const std::string> processedContent;
+
+        // Processed content with defines added, by the defines. Dropped
+        // along with processedContent.
+        std::map<std::vector<std::string>, std::shared_ptr<const std::string>>
+            definedContent;
       };
 
       class UnterminatedQuoteError : public EngineError {
@@ -56,15 +106,20 @@ namespace dg {
                             file.filename + ":" + std::to_string(line)) {}
       };
 
-      Preprocessor() = default;
+      Preprocessor() = delete;
+
+      static File &GetFile(const std::string &filename);
+      static void LoadFile(File &file);
+      static const std::string &GetProcessedContent(File &file);
+
+      static std::unordered_map<std::string, File> files;
 
-      File &GetFile(const std::string &filename);
-      File &GetProcessedFile(File &file);
+      // Files including each file directly, by the included file's name.
+      static std::unordered_map<std::string, std::set<std::string>>
+          includers;
 
-      std::string filename;
-      std::unordered_map<std::string, File> files;
-      std::set<std::string> currentFilenames;
-      int nextFileID = 0;
+      // Files being processed, to detect include cycles.
+      static std::set<std::string> currentFilenames;
 
   }; // class Preprocessor
 
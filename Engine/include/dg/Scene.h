@@ -5,15 +5,25 @@
 #pragma once
 
 #include <openvr.h>
-#include <deque>
 #include <forward_list>
 #include <memory>
 #include <unordered_map>
 #include <vector>
 #include "dg/FrameBuffer.h"
+#include "dg/LightClusters.h"
 #include "dg/Lights.h"
+#include "dg/OcclusionCuller.h"
+#include "dg/OcclusionQueries.h"
+#include "dg/PointShadowMap.h"
+#include "dg/PortalVisibility.h"
 #include "dg/RasterizerState.h"
 #include "dg/SceneObject.h"
+#include "dg/ShadowAtlas.h"
+#include "dg/ShadowCascades.h"
+
+#if defined(_OPENGL)
+#include "dg/opengl/UniformBuffer.h"
+#endif
 
 namespace dg {
 
@@ -66,18 +76,63 @@ namespace dg {
   //                                           | populating the currentRender
   //                                           | struct.
   //                                           |
-  //   if (shadow-producing light exists) {    |
-  //     SetupSubrender(Type::Depthmap)       | Sets framebuffer, also calls
-  //                                           | ClearBuffer().
+  //   if (shadow-producing lights exist) {    |
+  //     SetupSubrender(Type::Depthmap)       | Sets framebuffer. Does not
+  //                                           | clear it, since unchanged
+  //                                           | regions of the shadow atlas
+  //                                           | are kept between frames.
   //     PreSubrender()                        | Virtual, empty by default.
-  //     DrawScene()                           |
+  //     for (each shadow atlas region) {      |
+  //       if (light or casters changed) {     |
+  //         ClearBuffer()                     | Scissored to the region.
+  //         Draw static casters               | Into the static layer.
+  //       }                                   |
+  //       if (changed or dynamic casters) {   |
+  //         Copy static layer to atlas        |
+  //         Draw dynamic casters              |
+  //       }                                   |
+  //     }                                     |
   //     PostSubrender()                       | Virtual, empty by default.
   //     TeardownSubrender()                   |
   //   }                                       |
   //                                           |
+  //   if (shadow-casting directional light) { |
+  //     SetupSubrender(Type::Depthmap)        | Sets framebuffer, a layer per
+  //                                           | cascade.
+  //     PreSubrender()                        | Virtual, empty by default.
+  //     for (each cascade due this frame) {   | Distant cascades may update
+  //       ClearBuffer()                       | less often.
+  //       Draw casters within cascade         |
+  //     }                                     |
+  //     PostSubrender()                       | Virtual, empty by default.
+  //     TeardownSubrender()                   |
+  //   }                                       |
+  //                                           |
+  //   for (each shadow-casting point light) { |
+  //     if (any cube face changed) {          | Faces with only unchanged
+  //                                           | static casters are kept.
+  //       SetupSubrender(Type::Depthmap)      | Sets framebuffer.
+  //       PreSubrender()                      | Virtual, empty by default.
+  //       ClearBuffer()                       | For each changed face.
+  //       Draw casters to changed faces       | All faces in a single pass.
+  //       PostSubrender()                     | Virtual, empty by default.
+  //       TeardownSubrender()                 |
+  //     }                                     |
+  //   }                                       |
+  //                                           |
   //   RenderFramebuffers()                    | Virtual, empty by default.
   //                                           |
-  //   if (rendering VR) {                     |
+  //   if (rendering single-pass VR) {         |
+  //                                           |
+  //     SetupSubrender(                       | Sets side-by-side framebuffer,
+  //         Type::StereoscopicInstanced)      | also calls ClearBuffer().
+  //     DrawHiddenAreaMesh()                  | For each eye.
+  //     PreSubrender()                        | Virtual, empty by default.
+  //     DrawScene()                           | Draws both eyes at once.
+  //     PostSubrender()                       | Virtual, empty by default.
+  //     TeardownSubrender()                   |
+  //                                           |
+  //   } else if (rendering VR) {              |
   //                                           |
   //     SetupSubrender(                       | Sets framebuffer, also calls
   //         Type::Stereoscopic, left)         | ClearBuffer().
@@ -187,6 +242,9 @@ namespace dg {
           // Rendering to left or right eye of VR HMD.
           Stereoscopic,
 
+          // Rendering to both eyes of VR HMD at once, side by side.
+          StereoscopicInstanced,
+
           // Rendering depths for a light map.
           Depthmap,
         };
@@ -327,6 +385,31 @@ namespace dg {
       // that of the supplied render target.
       void PerformSubrender(Subrender &subrender);
 
+      // Width and height of the shadow atlas framebuffer, if it's created by
+      // the Scene. Scenes may instead provide subrenders.light.framebuffer,
+      // which must be square.
+      unsigned int shadowAtlasSize = 4096;
+
+      // Cascaded shadow maps of the shadow-casting directional light, if any.
+      // Scenes may tune its options.
+      ShadowCascades shadowCascades;
+
+      // Culls models hidden behind other models' occluder meshes when
+      // drawing the scene for a camera. Scenes with large occluders may
+      // enable it with occlusionCuller.options.enabled.
+      OcclusionCuller occlusionCuller;
+
+      // Skips drawing expensive models that the GPU found hidden in earlier
+      // frames. Enabled with occlusionQueries.options.enabled. Results are
+      // kept per subrender, so subrenders drawn with it should persist
+      // between frames.
+      OcclusionQueries occlusionQueries;
+
+      // Cells and portals of the scene. When the camera is in a cell, only
+      // models seen through the portals of its cell are drawn. Scenes add
+      // cells and portals in Initialize(), and none are added by default.
+      PortalVisibility portalVisibility;
+
       // The Skybox to render, or nullptr if no skybox is desired.
       std::shared_ptr<Skybox> skybox = nullptr;
 
@@ -338,7 +421,10 @@ namespace dg {
         Subrender main;
         Subrender framebuffer;
         Subrender light;
+        Subrender cascades;
+        Subrender pointLight;
         Subrender eyes[2];
+        Subrender stereo;
       } subrenders;
 
       // Cameras.
@@ -360,6 +446,10 @@ namespace dg {
         // True if the scene has successfully enabled VR.
         bool enabled = false;
 
+        // True to render both eyes in a single subrender, drawing each model
+        // once for both eyes. Only supported in the OpenGL build.
+        bool singlePassStereo = true;
+
         // Container of the VR play space in the scene hierarchy. The HMD
         // and controllers are all direct children of this container.
         std::shared_ptr<SceneObject> container;
@@ -382,11 +472,28 @@ namespace dg {
         // Models in scene hierarchy for current frame.
         std::vector<SortedModel> models;
 
+        // Model and normal matrices of each of the models above, in the same
+        // order, computed once per frame for all subrenders to share.
+        std::vector<glm::mat4x4> modelMatrices;
+        std::vector<glm::mat4x4> normalMatrices;
+
         // Lights in scene hierarchy for current frame.
-        std::deque<Light *> lights;
+        std::vector<Light *> lights;
 
-        // Pointer to the light currently casting a shadow, if any.
-        Light *shadowCastingLight = nullptr;
+        // Lights casting shadows this frame.
+        std::vector<Light *> shadowCastingLights;
+
+        // Shadow atlas depth texture holding the shadow maps of all
+        // shadow-casting lights, if any.
+        std::shared_ptr<Texture> shadowMap = nullptr;
+
+        // Directional light casting shadows with shadowCascades this frame.
+        Light *cascadedShadowLight = nullptr;
+
+        // Point lights casting shadows this frame, and their shadow cubemaps
+        // in the same order.
+        std::vector<Light *> pointShadowLights;
+        std::vector<std::shared_ptr<Texture>> pointShadowMaps;
 
       } currentRender;
 
@@ -397,11 +504,53 @@ namespace dg {
       void TeardownSubrender();
       void TeardownRender();
       void DrawScene();
+      void PrepareLights(const glm::mat4x4 &view,
+                         const glm::mat4x4 &projection, float nearClip,
+                         float farClip);
       void ProcessSceneHierarchy();
-      void RenderLightShadowMap();
+      void RenderLightShadowMaps();
+      void RenderShadowRegion(ShadowAtlas::Region &region);
+      void RenderCascadedShadowMaps();
+      void RenderPointShadowMaps();
+      void RenderPointShadowMap(Light &light, PointShadowMap &shadowMap);
       void InitializeVR();
       void DrawHiddenAreaMesh(vr::EVREye eye);
 
+      // Restricts drawing to one eye's half of the side-by-side stereo
+      // framebuffer, or to all of it if eye is -1.
+      void SetStereoViewport(int eye);
+
+      // Fixed-size light array for shaders that don't use clustered
+      // lighting, rebuilt with lightClusters by PrepareLights().
+      Light::ShaderData lightArray[Light::MAX_LIGHTS];
+
+#if defined(_OPENGL)
+      // lightArray as the light block, shared by every program.
+      UniformBuffer lightBuffer;
+#endif
+
+      // Per-view assignment of lights to clusters, rebuilt for each subrender
+      // that sends lights.
+      LightClusters lightClusters;
+
+      // State of the shadow atlas kept between frames.
+      struct {
+        std::unique_ptr<ShadowAtlas> atlas = nullptr;
+
+        // Framebuffer the atlas was packed for. If subrenders.light's
+        // framebuffer changes, the atlas is recreated.
+        std::shared_ptr<FrameBuffer> framebuffer = nullptr;
+
+        // Depth of only the static casters of each region, copied into the
+        // atlas before dynamic casters are drawn over it. If nullptr, every
+        // region is redrawn every frame.
+        std::shared_ptr<FrameBuffer> staticLayer = nullptr;
+      } shadowCache;
+
+      // Shadow cubemaps of point lights, kept between frames.
+      std::unordered_map<Light *, std::unique_ptr<PointShadowMap>>
+          pointShadowCache;
+
   }; // class Scene
 
 } // namespace dg
@@ -8,13 +8,18 @@
 #include "dg/opengl/glad/glad.h"
 
 #include "dg/opengl/ShaderSource.h"
+#include "dg/opengl/StorageBuffer.h"
+#include "dg/opengl/UniformBuffer.h"
 #elif defined(_DIRECTX)
 #include "dg/directx/SimpleShader.h"
 #endif
 
+#include <cstdint>
 #include <glm/glm.hpp>
+#include <map>
 #include <memory>
 #include <string>
+#include <tuple>
 #include <unordered_map>
 #include <vector>
 #include "dg/Texture.h"
@@ -27,7 +32,7 @@ namespace dg {
 
   // Copy is disabled. This prevents us from leaking or redeleting
   // OpenGL/DirectX resources.
-  class Shader {
+  class Shader : public std::enable_shared_from_this<Shader> {
 
     public:
 
@@ -37,20 +42,60 @@ namespace dg {
       typedef DirectXShader shader_class;
 #endif
 
+      // Shaders are shared. Loading the same files again returns the
+      // shader they were already loaded into, as long as it's still in use.
       static std::shared_ptr<Shader> FromFiles(
           const std::string& vertexPath, const std::string& fragmentPath);
       static std::shared_ptr<Shader> FromFiles(const std::string& vertexPath,
                                                const std::string& geometryPath,
                                                const std::string& fragmentPath);
 
+      // Compute program, shared in the same way. Compute programs only
+      // support Dispatch() and setting uniforms, images and storage blocks.
+      // Requires OpenGLGraphics::SupportsCompute().
+      static std::shared_ptr<Shader> FromComputeFile(
+          const std::string& computePath);
+
       Shader() = default;
       virtual ~Shader() = default;
 
       Shader(Shader& other) = delete;
       Shader& operator=(Shader& other) = delete;
 
+      // Hash identifying a uniform by its name, so that its location can be
+      // looked up without comparing strings. Never 0.
+      static uint64_t HashUniformName(const std::string& name);
+
+      // Variant of this shader built from the same files with a #define
+      // for each keyword, which must be sorted and unique. Each variant is
+      // built the first time it's requested, and kept for as long as this
+      // shader. Without keywords, returns this shader.
+      //
+      // The DirectX build loads precompiled shaders, so it has no variants
+      // and always returns this shader.
+      std::shared_ptr<Shader> GetVariant(
+          const std::vector<std::string>& keywords);
+
+      // Shaders may finish building in the background after they're
+      // loaded, until they're first used or Finish() is called. Returns
+      // whether Finish() would return without waiting.
+      virtual bool IsReady() { return true; }
+
+      // Waits for the shader to finish building, and throws if it failed.
+      virtual void Finish() {}
+
+      // Finishes every shader in use. Called once a scene has loaded its
+      // shaders, so that they build in parallel, and their errors are
+      // reported while initializing the scene.
+      static void FinishAll();
+
       virtual void Use() = 0;
 
+      // Runs a compute program over a grid of work groups. Writes it makes
+      // are only visible to later commands after a memory barrier for them.
+      virtual void Dispatch(unsigned int groupsX, unsigned int groupsY = 1,
+                            unsigned int groupsZ = 1) = 0;
+
       virtual void SetBool(const std::string& name, bool value) = 0;
       virtual void SetInt(const std::string& name, int value) = 0;
       virtual void SetFloat(const std::string& name, float value) = 0;
@@ -73,6 +118,27 @@ namespace dg {
       std::string vertexPath = std::string();
       std::string geometryPath = std::string();
       std::string fragmentPath = std::string();
+      std::string computePath = std::string();
+
+      // Keywords defined in this shader's sources.
+      std::vector<std::string> keywords;
+
+    private:
+
+      // Vertex, geometry, fragment and compute files, and keywords, a
+      // shader is built from.
+      typedef std::tuple<std::string, std::string, std::string, std::string,
+                         std::vector<std::string>>
+          ProgramKey;
+
+      // Returns the shared shader built from files and keywords, building
+      // it if no shader built from them is still in use.
+      static std::shared_ptr<Shader> Load(const ProgramKey& key);
+
+      // Every shader in use, by what it was built from.
+      static std::map<ProgramKey, std::weak_ptr<Shader>> programs;
+
+      std::map<std::vector<std::string>, std::shared_ptr<Shader>> variants;
 
   }; // class Shader
 
@@ -90,10 +156,95 @@ namespace dg {
       OpenGLShader& operator=(OpenGLShader& other) = delete;
 
       virtual void Use();
-
+      virtual void Dispatch(unsigned int groupsX, unsigned int groupsY = 1,
+                            unsigned int groupsZ = 1);
+
+      // Programs are linked asynchronously. Their status is only checked,
+      // which waits for the driver, when they're first used or finished.
+      // With KHR_parallel_shader_compile, the driver compiles them on
+      // background threads meanwhile.
+      virtual bool IsReady();
+      virtual void Finish();
+
+      // Location of an active uniform, or -1 if the program doesn't have
+      // it. Active uniforms are reflected once after linking, so these
+      // don't call into the driver. The program must be finished.
       GLint GetUniformLocation(const std::string& name) const;
+      GLint GetUniformLocation(uint64_t nameHash) const;
+
       GLint GetAttributeLocation(const std::string& name) const;
 
+      // Layout of an active std140 uniform block, reflected after linking.
+      // Blocks declared the same way in different programs have the same
+      // layoutHash.
+      struct UniformBlock {
+        std::string name;
+        uint64_t nameHash = 0;
+        GLuint index = 0;
+
+        // Binding point, shared by every program's block of this name.
+        GLuint binding = 0;
+
+        GLsizeiptr size = 0;
+        uint64_t layoutHash = 0;
+
+        // Byte offsets of the members by the hashes of their reflected
+        // names, such as "Block.member", including each array element.
+        std::unordered_map<uint64_t, GLint> offsets;
+
+        // Bytes between the elements of array members, by the hashes of
+        // the arrays' names without an index.
+        std::unordered_map<uint64_t, GLint> arrayStrides;
+      };
+
+      // Active uniform block by the hash of its name, or nullptr if the
+      // program doesn't have it. The program must be finished.
+      std::shared_ptr<const UniformBlock> GetUniformBlock(
+          uint64_t nameHash) const;
+
+      // Binding point used by all programs for uniform blocks of a name.
+      static GLuint GetUniformBlockBinding(const std::string &blockName);
+
+      // Binding point used by all programs for storage blocks of a name.
+      static GLuint GetStorageBlockBinding(const std::string &blockName);
+
+      // Set uniforms by location, skipping those at location -1.
+      void SetUniform(GLint location, bool value);
+      void SetUniform(GLint location, int value);
+      void SetUniform(GLint location, float value);
+      void SetUniform(GLint location, const glm::vec2& value);
+      void SetUniform(GLint location, const glm::vec3& value);
+      void SetUniform(GLint location, const glm::vec4& value);
+      void SetUniform(GLint location, const glm::mat4& mat);
+
+      // Set count elements of a uniform array by the location of its
+      // first element.
+      void SetUniform(GLint location, const float *values, GLsizei count);
+      void SetUniform(GLint location, const glm::vec2 *values, GLsizei count);
+      void SetUniform(GLint location, const glm::vec3 *values, GLsizei count);
+      void SetUniform(GLint location, const glm::vec4 *values, GLsizei count);
+      void SetUniform(GLint location, const glm::mat4 *mats, GLsizei count);
+
+      void SetTexture(unsigned int textureUnit, GLint location,
+                      const Texture *texture);
+
+      // Binds a level of a texture to an image unit for load/store, as the
+      // texture's image format, and sets an image uniform to the unit.
+      // Access is GL_READ_ONLY, GL_WRITE_ONLY or GL_READ_WRITE. The texture
+      // must be stored in its image format, as BYTE and buffer textures
+      // are. Requires OpenGLGraphics::SupportsCompute().
+      void SetImage(unsigned int imageUnit, GLint location,
+                    const Texture *texture, GLenum access = GL_READ_WRITE,
+                    int level = 0);
+      void SetImage(unsigned int imageUnit, const std::string& name,
+                    const Texture *texture, GLenum access = GL_READ_WRITE,
+                    int level = 0);
+
+      // Binds a buffer to a storage block's binding point. Skipped if the
+      // program has no such block.
+      void SetStorageBuffer(const std::string& blockName,
+                            const StorageBuffer& buffer);
+
       virtual void SetBool(const std::string& name, bool value);
       virtual void SetInt(const std::string& name, int value);
       virtual void SetFloat(const std::string& name, float value);
@@ -105,21 +256,50 @@ namespace dg {
       virtual void SetTexture(
           unsigned int textureUnit, const std::string& name,
           const Texture *texture);
+
+      // Uploads the std140 contents of a uniform block, and binds them to
+      // the block's binding point. Skipped if the program has no such block.
       virtual void SetData(const std::string& name, void *data, size_t size);
 
     private:
 
-      static std::shared_ptr<OpenGLShader>FromFiles(
-          const std::string& vertexPath, const std::string& fragmentPath);
-      static std::shared_ptr<OpenGLShader> FromFiles(
-          const std::string& vertexPath, const std::string& geometryPath,
-          const std::string& fragmentPath);
-
+      // Compiles and links the program, without waiting for the driver.
       void CreateProgram();
       void CheckLinkErrors();
+      void ReflectUniforms();
+      void ReflectUniformBlocks();
+      void ReflectStorageBlocks();
 
       GLuint programHandle = 0;
 
+      // Whether the program's link status was checked, and its uniforms
+      // reflected.
+      bool finished = false;
+
+      // Sources of a program linked from source, kept until its link
+      // status is checked so that their compile errors can be reported.
+      std::vector<std::shared_ptr<ShaderSource>> pendingSources;
+      uint64_t cacheKey = 0;
+
+      // Open-addressed hash table of the active uniforms' locations, keyed
+      // by the hashes of their names. Its size is a power of two, and at
+      // least twice the number of uniforms. Slots with a hash of 0 are
+      // empty.
+      struct UniformSlot {
+        uint64_t nameHash = 0;
+        GLint location = -1;
+      };
+      std::vector<UniformSlot> uniformSlots;
+
+      std::vector<std::shared_ptr<UniformBlock>> uniformBlocks;
+
+      // Binding points of the active storage blocks, by the hashes of
+      // their names.
+      std::unordered_map<uint64_t, GLuint> storageBlockBindings;
+
+      // Buffers given to SetData() for each block, created on first use.
+      std::vector<std::unique_ptr<UniformBuffer>> blockBuffers;
+
   }; // class OpenGLShader
 
 #elif defined(_DIRECTX)
@@ -136,6 +316,8 @@ namespace dg {
       DirectXShader& operator=(DirectXShader& other) = delete;
 
       virtual void Use();
+      virtual void Dispatch(unsigned int groupsX, unsigned int groupsY = 1,
+                            unsigned int groupsZ = 1);
 
       virtual void SetBool(const std::string& name, bool value);
       virtual void SetInt(const std::string& name, int value);
@@ -5,16 +5,31 @@
 #pragma once
 
 #include <memory>
+#include <unordered_map>
+#include <utility>
 #include "dg/Material.h"
 #include "dg/Shader.h"
 #include "dg/Texture.h"
 
 namespace dg {
 
+  // Material drawn with the properties of another material, but with a
+  // different shader. Holds no properties of its own, so changes to the
+  // source material's properties apply to it as well.
+  //
+  // The source material is only weakly referenced, and must outlive any
+  // draws with the replaced material.
   class ShaderReplacedMaterial : public Material {
 
     public:
 
+      // Returns the variant of a material using a replacement shader,
+      // creating it the first time it's requested and reusing it after that.
+      // A variant is dropped once its source material is destroyed.
+      static const std::shared_ptr<ShaderReplacedMaterial> &Get(
+          const std::shared_ptr<Material> &material,
+          const std::shared_ptr<Shader> &newShader);
+
       ShaderReplacedMaterial() = default;
       ShaderReplacedMaterial(std::shared_ptr<Material> material,
                              std::shared_ptr<Shader> newShader);
@@ -32,7 +47,20 @@ namespace dg {
 
     private:
 
-      std::shared_ptr<Material> material = nullptr;
+      typedef std::pair<const Material *, const Shader *> VariantKey;
+
+      struct VariantKeyHash {
+        std::size_t operator()(const VariantKey &key) const;
+      };
+
+      struct Variant {
+        std::weak_ptr<Material> source;
+        std::shared_ptr<ShaderReplacedMaterial> material;
+      };
+
+      static std::unordered_map<VariantKey, Variant, VariantKeyHash> variants;
+
+      std::weak_ptr<Material> material;
 
   }; // class Material
 
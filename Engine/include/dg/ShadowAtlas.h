@@ -0,0 +1,99 @@
+//
+//  ShadowAtlas.h
+//
+
+#pragma once
+
+#include <cstddef>
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace dg {
+
+  class Light;
+
+  // Packs the shadow maps of several lights into square regions of a single
+  // square depth texture.
+  //
+  // Region sizes are powers of two, so regions are allocated as nodes of a
+  // quadtree over the atlas. If a light's requested resolution doesn't fit,
+  // it is halved until it does, down to MIN_REGION_SIZE.
+  //
+  // Each region also remembers what was last rendered into it, so that the
+  // scene can skip re-rendering regions whose light and casters haven't
+  // changed. The layout, and therefore every region's cache, is only reset
+  // when the set of lights or their requested resolutions change.
+  class ShadowAtlas {
+
+    public:
+
+      static const unsigned int MIN_REGION_SIZE = 64;
+
+      struct Request {
+        Light *light;
+        unsigned int resolution;
+      };
+
+      struct Region {
+        Light *light = nullptr;
+
+        // Lower-left corner and size of the region, in texels.
+        unsigned int x = 0;
+        unsigned int y = 0;
+        unsigned int size = 0;
+
+        // Projection * view matrix of the light when the region was last
+        // rendered.
+        glm::mat4x4 viewProjection = glm::mat4x4(0);
+
+        // Hash of the static casters (and their transforms) that were drawn
+        // into the cached static layer of this region.
+        std::size_t staticCasterHash = 0;
+
+        // Whether the cached static layer of this region is valid.
+        bool staticValid = false;
+
+        // Whether dynamic casters were drawn over the static layer last time
+        // the region was rendered. If so, the region must be restored from
+        // the static layer even if there are no dynamic casters now.
+        bool hadDynamicCasters = false;
+      };
+
+      ShadowAtlas(unsigned int size);
+
+      // Assigns a region to each of `count` requested lights, in order of
+      // decreasing resolution. Lights that can't fit even at MIN_REGION_SIZE
+      // get no region. Returns true if the layout changed, in which case
+      // every region's cache has been invalidated.
+      bool Pack(const Request *requests, size_t count);
+
+      // Marks every region's cache as invalid.
+      void Invalidate();
+
+      unsigned int GetSize() const;
+      std::vector<Region> &GetRegions();
+
+      // Matrix mapping a light's normalized device coordinates into the
+      // region's part of the atlas, still in normalized device coordinates.
+      // Multiplying a light's projection * view by this lets shaders sample
+      // the atlas exactly as they would a dedicated shadow map.
+      glm::mat4x4 RegionTransform(const Region &region) const;
+
+    private:
+
+      struct Square {
+        unsigned int x;
+        unsigned int y;
+        unsigned int size;
+      };
+
+      bool Allocate(unsigned int size, Square &square);
+
+      const unsigned int size;
+      std::vector<Request> packedRequests;
+      std::vector<Region> regions;
+      std::vector<Square> freeSquares;
+
+  }; // class ShadowAtlas
+
+} // namespace dg
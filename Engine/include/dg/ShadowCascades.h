@@ -0,0 +1,114 @@
+//
+//  ShadowCascades.h
+//
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <memory>
+#include "dg/Bounds.h"
+#include "dg/FrameBuffer.h"
+#include "dg/Texture.h"
+
+namespace dg {
+
+  class Camera;
+
+  // Cascaded shadow maps for a single directional light.
+  //
+  // The camera's view frustum is split along its depth into up to
+  // MAX_CASCADES ranges, spaced between logarithmically and uniformly by
+  // splitLambda. Each range gets an orthographic shadow map fit around the
+  // bounding sphere of its part of the frustum, so that the size of each
+  // cascade doesn't change as the camera rotates, and whose position is
+  // snapped to whole shadow map texels, so that shadow edges don't shimmer
+  // as the camera moves. All cascades are layers of one depth array texture.
+  //
+  // Cascade 0 is rendered every frame. Farther cascades cover more of the
+  // scene with less detail per texel, so they can be rendered less often
+  // with distantUpdateInterval.
+  //
+  // NOTE: Keep MAX_CASCADES and the shader uniforms consistent with:
+  //       -> assets/shaders/standard.f.glsl
+  class ShadowCascades {
+
+    public:
+
+      static const unsigned int MAX_CASCADES = 4;
+
+      struct Options {
+        // Number of cascades, from 1 to MAX_CASCADES.
+        unsigned int count = 4;
+
+        // Width and height of each cascade's shadow map.
+        unsigned int resolution = 2048;
+
+        // Blend between logarithmic (1) and uniform (0) split distances.
+        float splitLambda = 0.75f;
+
+        // Distance from the camera beyond which there are no shadows, if
+        // less than the camera's far clip.
+        float maxDistance = 100;
+
+        // Cascades after the first are rendered once every this many frames,
+        // staggered so that they don't all update on the same frame.
+        unsigned int distantUpdateInterval = 1;
+      };
+
+      Options options;
+
+      // Fits the cascades to the view of a camera for a light shining in
+      // `lightDirection`, and decides which cascades to render this frame.
+      // `casterBounds` are the scene-space bounds of all shadow casters,
+      // which are used to extend each cascade towards the light so that
+      // casters outside the view still cast shadows into it.
+      void Fit(const Camera &camera, float aspectRatio,
+               glm::vec3 lightDirection, const AABB &casterBounds);
+
+      // Whether shaders should sample the cascades. They must be inactive
+      // while being rendered to.
+      void SetActive(bool active);
+      bool IsActive() const;
+      unsigned int GetCount() const;
+
+      // Whether a cascade was refit by the most recent Fit() and needs to be
+      // rendered.
+      bool NeedsRender(unsigned int cascade) const;
+
+      glm::mat4x4 GetViewMatrix() const;
+      glm::mat4x4 GetProjectionMatrix(unsigned int cascade) const;
+
+      // Projection * view matrix that the cascade was last rendered with.
+      glm::mat4x4 GetLightTransform(unsigned int cascade) const;
+
+      // View-space distance from the camera to the far end of each cascade.
+      // Unused cascades are 0.
+      glm::vec4 GetSplitDepths() const;
+
+      // Framebuffer with one layer per cascade, created or recreated as
+      // needed to match the options.
+      std::shared_ptr<FrameBuffer> GetFrameBuffer();
+
+      // The depth array texture, or nullptr if none has been created.
+      std::shared_ptr<Texture> GetTexture() const;
+
+    private:
+
+      struct Cascade {
+        float splitDepth = 0;
+        glm::mat4x4 projection = glm::mat4x4(1);
+        glm::mat4x4 lightTransform = glm::mat4x4(1);
+        bool needsRender = true;
+      };
+
+      bool active = false;
+      unsigned int count = 0;
+      unsigned int frame = 0;
+      glm::mat4x4 view = glm::mat4x4(1);
+      glm::vec3 lightDirection = glm::vec3(0);
+      Cascade cascades[MAX_CASCADES];
+      std::shared_ptr<FrameBuffer> framebuffer = nullptr;
+
+  }; // class ShadowCascades
+
+} // namespace dg
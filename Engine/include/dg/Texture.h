@@ -9,8 +9,10 @@
 #include <d3d11.h>
 #endif
 
+#include <cstddef>
 #include <memory>
 #include <string>
+#include <unordered_map>
 
 namespace dg {
 
@@ -21,6 +23,15 @@ namespace dg {
   enum class TextureType {
     _2D,
     CUBEMAP,
+
+    // Array of 2D images of the same dimensions, sampled in shaders with a
+    // layer index. The number of images is TextureOptions::layers.
+    _2D_ARRAY,
+
+    // One-dimensional array of texels backed by a GPU buffer, read in shaders
+    // with texelFetch(). Width is the number of texels and height must be 1.
+    // Buffer textures have no sampler state and cannot be mipmapped.
+    BUFFER,
   };
 
   enum class TextureFace {
@@ -70,14 +81,27 @@ namespace dg {
     unsigned int width;
     unsigned int height;
 
+    // Number of images in a _2D_ARRAY texture. Ignored for other types.
+    unsigned int layers = 1;
+
+    // Most samples anisotropic filtering may take. Clamped to what the
+    // driver supports, and ignored without anisotropic filtering support or
+    // in the DirectX build.
+    unsigned int anisotropy = 1;
+
 #if defined(_OPENGL)
     GLenum GetOpenGLTarget() const;
     GLenum GetOpenGLWrap() const;
     GLenum GetOpenGLMinFilter() const;
     GLenum GetOpenGLMagFilter() const;
     GLenum GetOpenGLInternalFormat() const;
+
+    // Sized format of the texture's pixel type, which image load/store and
+    // buffer textures require.
+    GLenum GetOpenGLImageFormat() const;
     GLenum GetOpenGLExternalFormat() const;
     GLenum GetOpenGLType() const;
+    unsigned int GetOpenGLBytesPerPixel() const;
 #elif defined(_DIRECTX)
     DXGI_FORMAT GetDirectXInternalFormat() const;
     DXGI_FORMAT GetDirectXShaderFormat() const;
@@ -105,6 +129,9 @@ namespace dg {
 
     public:
 
+      // Textures loaded from files are shared. Loading the same files
+      // again returns the texture they were already loaded into, as long
+      // as it's still in use, so they mustn't be modified after loading.
       static std::shared_ptr<Texture> FromPath(const std::string& path);
       static std::shared_ptr<Texture> FromImage(std::shared_ptr<Image> image);
       static std::shared_ptr<Texture> FromPaths(const std::string &right,
@@ -121,6 +148,19 @@ namespace dg {
                                                  std::shared_ptr<Image> front);
       static std::shared_ptr<Texture> Generate(TextureOptions options);
 
+      // Counts of loads from files since the process started.
+      struct CacheStats {
+        // Loads that returned a texture already loaded from the same files.
+        unsigned int hits = 0;
+
+        // Loads that decoded and uploaded the files.
+        unsigned int misses = 0;
+
+        // Bytes of texture storage the hits would have uploaded again.
+        size_t bytesSaved = 0;
+      };
+      static const CacheStats &GetCacheStats();
+
       BaseTexture() = delete;
 
       virtual ~BaseTexture() = default;
@@ -147,6 +187,16 @@ namespace dg {
 
       const TextureOptions options;
 
+    private:
+
+      // Returns the texture loaded from files under a key if it's still in
+      // use, and counts the load as a hit or a miss.
+      static std::shared_ptr<Texture> FindLoaded(const std::string &key);
+
+      // Textures loaded from files, by their flattened paths.
+      static std::unordered_map<std::string, std::weak_ptr<Texture>> fileMap;
+      static CacheStats cacheStats;
+
   }; // class BaseTexture
 
 #if defined(_OPENGL)
@@ -164,8 +214,15 @@ namespace dg {
       virtual void GenerateMips();
       virtual void GenerateMips(TextureFace face);
 
+      // Replaces the first `size` bytes of a BUFFER texture's storage.
+      void UpdateBufferData(const void *data, size_t size);
+
       GLuint GetHandle() const;
 
+      // Sampler object for this texture's options, shared with other
+      // textures that have the same ones. 0 for BUFFER textures.
+      GLuint GetSampler() const;
+
     private:
 
       static GLenum FaceToGLTarget(TextureFace face);
@@ -174,10 +231,12 @@ namespace dg {
 
       virtual void GenerateImage(void *pixels);
 
+      // Binds the texture to edit it. It's left bound afterwards.
       void Bind() const;
-      void Unbind() const;
 
       GLuint textureHandle = 0;
+      mutable GLuint samplerHandle = 0;
+      GLuint bufferHandle = 0;
 
   }; // class OpenGLTexture
 
@@ -6,6 +6,7 @@
 #include <glm/vec3.hpp>
 #include <glm/mat4x4.hpp>
 #include <glm/gtc/quaternion.hpp>
+#include <cstddef>
 #include <string>
 #include <ostream>
 
@@ -46,6 +47,21 @@ namespace dg {
 
       glm::mat4x4 ToMat4() const;
 
+      // Matrix for transforming normals and other directions (w = 0): the
+      // inverse transpose of ToMat4(), without translation.
+      glm::mat4x4 ToNormalMat4() const;
+
+      // Batched versions of ToMat4(), ToNormalMat4() and operator* over
+      // arrays of `count` elements. These process four transforms at a time
+      // with SSE or NEON where available. `products` may be the same array
+      // as `a` or `b`.
+      static void ToMat4(const Transform *transforms, glm::mat4x4 *matrices,
+                         size_t count);
+      static void ToNormalMat4(const Transform *transforms,
+                               glm::mat4x4 *matrices, size_t count);
+      static void Multiply(const Transform *a, const Transform *b,
+                           Transform *products, size_t count);
+
       glm::vec3 Right() const;
       glm::vec3 Up() const;
       glm::vec3 Forward() const;
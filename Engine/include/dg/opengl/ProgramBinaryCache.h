@@ -0,0 +1,61 @@
+//
+//  opengl/ProgramBinaryCache.h
+//
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "dg/opengl/ShaderSource.h"
+#include "dg/opengl/glad/glad.h"
+
+namespace dg {
+
+  // On-disk cache of linked program binaries, so that programs built in an
+  // earlier run are loaded with glProgramBinary() instead of being compiled
+  // and linked again.
+  //
+  // Binaries are keyed by the fully preprocessed source of each stage, and
+  // by the vendor, renderer and version strings of the driver, since
+  // drivers only accept binaries they produced themselves. A binary the
+  // driver rejects anyway, such as after a driver update that kept its
+  // version string, is simply compiled again and replaced.
+  //
+  // Requires GL 4.1 or ARB_get_program_binary, and a driver that supports
+  // at least one binary format. Otherwise the cache is never used.
+  class ProgramBinaryCache {
+
+    public:
+
+      // Directory binaries are stored in, relative to the working
+      // directory. Created when the first binary is stored.
+      static std::string directory;
+
+      // Whether the context can load and retrieve program binaries.
+      static bool IsSupported();
+
+      // Key of a program linked from preprocessed sources, on this driver.
+      static uint64_t GetKey(
+          const std::vector<std::shared_ptr<ShaderSource>> &sources);
+
+      // Loads a cached binary into a program that has nothing attached.
+      // Returns whether the program was successfully linked from it.
+      static bool Load(GLuint program, uint64_t key);
+
+      // Called before linking a program from source, so that the driver
+      // keeps its binary retrievable for Store().
+      static void PrepareToLink(GLuint program);
+
+      // Stores the binary of a successfully linked program. Failures to
+      // write it are ignored, since the cache is only an optimization.
+      static void Store(GLuint program, uint64_t key);
+
+    private:
+
+      static std::string GetPath(uint64_t key);
+
+  }; // class ProgramBinaryCache
+
+} // namespace dg
@@ -4,7 +4,9 @@
 
 #pragma once
 
+#include <cassert>
 #include <glm/glm.hpp>
+#include <memory>
 #include <string>
 #include <vector>
 #include "dg/Preprocessor.h"
@@ -18,30 +20,44 @@ namespace dg {
 
     public:
 
-      static std::shared_ptr<ShaderSource> FromFile(GLenum type,
-                                                    const std::string& path);
+      // Loads and preprocesses a shader file, with a #define for each of
+      // defines. It isn't compiled until Compile() is called, so that
+      // programs loaded from the binary cache skip the compiler.
+      static std::shared_ptr<ShaderSource> FromFile(
+          GLenum type, const std::string& path,
+          const std::vector<std::string>& defines = {});
 
       ShaderSource() = default;
       ShaderSource(ShaderSource& other) = delete;
       ~ShaderSource();
       ShaderSource& operator=(ShaderSource& other) = delete;
 
+      // Starts compiling the shader, if it isn't yet. Doesn't wait for the
+      // driver to finish, so errors are only thrown by
+      // CheckCompileErrors().
+      void Compile();
+      void CheckCompileErrors();
+
+      inline GLenum GetType() const {
+        return shaderType;
+      }
       inline GLuint GetHandle() const {
+        assert(shaderHandle != 0);
         return shaderHandle;
       }
       inline const std::string &GetPath() const {
-        return file->GetFilename();
+        return path;
       }
       inline const std::string &GetContent() const {
-        return file->GetProcessedContent();
+        return *content;
       }
 
     private:
 
-      void CompileShader();
-      void CheckCompileErrors();
+      std::string path;
 
-      std::shared_ptr<Preprocessor> file;
+      // Processed content, shared with other sources of the same file.
+      std::shared_ptr<const std::string> content;
 
       GLenum shaderType = 0;
       GLuint shaderHandle = 0;
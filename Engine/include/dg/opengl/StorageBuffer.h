@@ -0,0 +1,65 @@
+//
+//  opengl/StorageBuffer.h
+//
+
+#pragma once
+
+#include <cstddef>
+#include "dg/opengl/glad/glad.h"
+
+// Shader storage buffers are core in GL 4.3, which GLAD wasn't generated for.
+#ifndef GL_SHADER_STORAGE_BUFFER
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#endif
+
+namespace dg {
+
+  // Buffer backing shader storage blocks, which compute programs and other
+  // shaders may both read and write. Bound to a block's binding point for
+  // every program that declares the block.
+  //
+  // Shader writes are only visible to later reads, including Read(), after
+  // a memory barrier for them. See OpenGLGraphics::IssueMemoryBarrier().
+  //
+  // Copy is disabled. This prevents us from leaking or redeleting the
+  // OpenGL buffer resource.
+  class StorageBuffer {
+
+    public:
+
+      StorageBuffer() = default;
+      StorageBuffer(StorageBuffer& other) = delete;
+      ~StorageBuffer();
+      StorageBuffer& operator=(StorageBuffer& other) = delete;
+
+      // Replaces the buffer's storage with size bytes, copied from data if
+      // it isn't nullptr.
+      void Allocate(size_t size, const void *data = nullptr);
+
+      // Writes size bytes of data at an offset into the buffer's storage.
+      void Update(size_t offset, const void *data, size_t size);
+
+      // Copies size bytes at an offset of the buffer's storage into data.
+      // Waits for the GPU to finish writing them.
+      void Read(size_t offset, void *data, size_t size) const;
+
+      // Binds a range of the buffer, or all of it, to a storage block
+      // binding point.
+      void Bind(GLuint binding, size_t offset, size_t size) const;
+      void Bind(GLuint binding) const;
+
+      inline GLuint GetHandle() const {
+        return bufferHandle;
+      }
+      inline size_t GetSize() const {
+        return size;
+      }
+
+    private:
+
+      GLuint bufferHandle = 0;
+      size_t size = 0;
+
+  }; // class StorageBuffer
+
+} // namespace dg
@@ -0,0 +1,52 @@
+//
+//  opengl/UniformBuffer.h
+//
+
+#pragma once
+
+#include <cstddef>
+#include "dg/opengl/glad/glad.h"
+
+namespace dg {
+
+  // Buffer holding the std140 contents of uniform blocks, which is bound to
+  // a block's binding point for every program that declares the block.
+  //
+  // Copy is disabled. This prevents us from leaking or redeleting the
+  // OpenGL buffer resource.
+  class UniformBuffer {
+
+    public:
+
+      UniformBuffer() = default;
+      UniformBuffer(UniformBuffer& other) = delete;
+      ~UniformBuffer();
+      UniformBuffer& operator=(UniformBuffer& other) = delete;
+
+      // Replaces the buffer's storage with size bytes, copied from data if
+      // it isn't nullptr.
+      void Allocate(size_t size, const void *data = nullptr);
+
+      // Writes size bytes of data at an offset into the buffer's storage.
+      void Update(size_t offset, const void *data, size_t size);
+
+      // Binds a range of the buffer, or all of it, to a uniform block
+      // binding point.
+      void Bind(GLuint binding, size_t offset, size_t size) const;
+      void Bind(GLuint binding) const;
+
+      inline GLuint GetHandle() const {
+        return bufferHandle;
+      }
+      inline size_t GetSize() const {
+        return size;
+      }
+
+    private:
+
+      GLuint bufferHandle = 0;
+      size_t size = 0;
+
+  }; // class UniformBuffer
+
+} // namespace dg
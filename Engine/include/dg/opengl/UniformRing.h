@@ -0,0 +1,83 @@
+//
+//  opengl/UniformRing.h
+//
+
+#pragma once
+
+#include <cstddef>
+#include "dg/opengl/glad/glad.h"
+
+namespace dg {
+
+  // Ring buffer for uniform block data that changes from draw to draw, such
+  // as per-object matrices. Each write is copied into the next free range
+  // of the buffer, which is then bound by offset, so that no draw waits for
+  // the GPU to finish reading the data of an earlier one.
+  //
+  // The ring is split into a segment for each frame in flight. A frame only
+  // writes to its own segment, and BeginFrame() waits on a fence for the
+  // GPU to be done with the segment it's about to reuse, which by then it
+  // normally is. A frame that outgrows its segment moves the ring to a new
+  // buffer with segments twice as large.
+  //
+  // With GL 4.4 or ARB_buffer_storage, the buffer is persistently mapped,
+  // and writes are plain copies into it. Otherwise, each write is uploaded
+  // with glBufferSubData() into a range the GPU isn't reading.
+  //
+  // Copy is disabled. This prevents us from leaking or redeleting the
+  // OpenGL buffer resource.
+  class UniformRing {
+
+    public:
+
+      static const unsigned int FRAMES_IN_FLIGHT = 3;
+      static const size_t DEFAULT_SEGMENT_SIZE = 1 << 18;
+
+      UniformRing(size_t segmentSize = DEFAULT_SEGMENT_SIZE);
+      UniformRing(UniformRing& other) = delete;
+      ~UniformRing();
+      UniformRing& operator=(UniformRing& other) = delete;
+
+      // Moves on to the next frame's segment. Called once at the start of
+      // each frame.
+      void BeginFrame();
+
+      // Copies size bytes of data into the ring, and returns their offset
+      // in it, which is aligned for binding.
+      size_t Write(const void *data, size_t size);
+
+      // Binds a range of the ring returned by Write() to a uniform block
+      // binding point.
+      void Bind(GLuint binding, size_t offset, size_t size) const;
+
+      // Changes whenever the ring moves to a new buffer, which unbinds the
+      // ranges bound from the old one.
+      inline unsigned int GetGeneration() const {
+        return generation;
+      }
+
+    private:
+
+      void CreateBuffer(size_t segmentSize);
+      void DeleteBuffer();
+
+      GLuint bufferHandle = 0;
+      unsigned int generation = 0;
+
+      // Persistent mapping of the whole buffer, or nullptr if not mapped.
+      char *mapped = nullptr;
+
+      size_t segmentSize;
+      size_t alignment = 256;
+
+      // Segment of the current frame, and the end of what was written to it.
+      unsigned int segment = 0;
+      size_t offset = 0;
+
+      // Fences after the last commands reading each segment, or nullptr if
+      // the GPU is known to be done with it.
+      GLsync fences[FRAMES_IN_FLIGHT] = {};
+
+  }; // class UniformRing
+
+} // namespace dg
@@ -48,6 +48,11 @@ namespace dg {
       std::shared_ptr<FrameBuffer> GetFramebuffer(vr::EVREye eye) const;
       void SubmitFrame(vr::EVREye eye);
 
+      // Framebuffer holding both eyes side by side, left eye on the left,
+      // for single-pass stereo rendering. Created on first use.
+      std::shared_ptr<FrameBuffer> GetStereoFramebuffer();
+      void SubmitStereoFrame();
+
       void UpdateRenderModelList();
       std::shared_ptr<Mesh> GetRenderModelMesh(const std::string& name);
       std::shared_ptr<Texture> GetRenderModelTexture(const std::string& name);
@@ -71,6 +76,7 @@ namespace dg {
 
       std::shared_ptr<FrameBuffer> leftFramebuffer;
       std::shared_ptr<FrameBuffer> rightFramebuffer;
+      std::shared_ptr<FrameBuffer> stereoFramebuffer;
 
       std::shared_ptr<Mesh> leftHiddenAreaMesh = nullptr;
       std::shared_ptr<Mesh> rightHiddenAreaMesh = nullptr;
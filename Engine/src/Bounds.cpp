@@ -0,0 +1,113 @@
+//
+//  Bounds.cpp
+//
+
+#include "dg/Bounds.h"
+#include <cmath>
+#include <limits>
+
+#pragma region AABB
+
+dg::AABB dg::AABB::Empty() {
+  return AABB(glm::vec3(std::numeric_limits<float>::max()),
+              glm::vec3(-std::numeric_limits<float>::max()));
+}
+
+dg::AABB::AABB(glm::vec3 min, glm::vec3 max) : min(min), max(max) {}
+
+bool dg::AABB::IsEmpty() const {
+  return min.x > max.x || min.y > max.y || min.z > max.z;
+}
+
+glm::vec3 dg::AABB::Center() const {
+  return (min + max) * 0.5f;
+}
+
+glm::vec3 dg::AABB::Extents() const {
+  return (max - min) * 0.5f;
+}
+
+void dg::AABB::Encapsulate(glm::vec3 point) {
+  min = glm::min(min, point);
+  max = glm::max(max, point);
+}
+
+void dg::AABB::Encapsulate(const AABB &other) {
+  if (other.IsEmpty()) {
+    return;
+  }
+  min = glm::min(min, other.min);
+  max = glm::max(max, other.max);
+}
+
+dg::AABB dg::AABB::Transformed(const glm::mat4x4 &xf) const {
+  if (IsEmpty()) {
+    return *this;
+  }
+
+  // Transform the center, and project the extents onto each world axis
+  // using the absolute values of the rotation and scale components.
+  // (Arvo, "Transforming Axis-Aligned Bounding Boxes", Graphics Gems 1990.)
+  glm::vec3 center = glm::vec3(xf * glm::vec4(Center(), 1));
+  glm::vec3 extents = Extents();
+  glm::vec3 newExtents = glm::vec3(0);
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) {
+      newExtents[i] += std::abs(xf[j][i]) * extents[j];
+    }
+  }
+  return AABB(center - newExtents, center + newExtents);
+}
+
+#pragma endregion
+#pragma region Frustum
+
+dg::Frustum dg::Frustum::FromMatrix(const glm::mat4x4 &m) {
+  // Gribb and Hartmann, "Fast Extraction of Viewing Frustum Planes from the
+  // World-View-Projection Matrix". glm is column-major, so row i is
+  // (m[0][i], m[1][i], m[2][i], m[3][i]).
+  glm::vec4 rows[4];
+  for (int i = 0; i < 4; i++) {
+    rows[i] = glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+  }
+
+  Frustum frustum;
+  frustum.planes[0] = rows[3] + rows[0]; // Left
+  frustum.planes[1] = rows[3] - rows[0]; // Right
+  frustum.planes[2] = rows[3] + rows[1]; // Bottom
+  frustum.planes[3] = rows[3] - rows[1]; // Top
+  frustum.planes[4] = rows[3] + rows[2]; // Near
+  frustum.planes[5] = rows[3] - rows[2]; // Far
+  for (glm::vec4 &plane : frustum.planes) {
+    plane /= glm::length(glm::vec3(plane));
+  }
+  return frustum;
+}
+
+bool dg::Frustum::Intersects(const AABB &box) const {
+  if (box.IsEmpty()) {
+    return false;
+  }
+
+  glm::vec3 center = box.Center();
+  glm::vec3 extents = box.Extents();
+  for (const glm::vec4 &plane : planes) {
+    glm::vec3 normal = glm::vec3(plane);
+    float radius = glm::dot(extents, glm::abs(normal));
+    if (glm::dot(normal, center) + plane.w < -radius) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool dg::Frustum::Intersects(glm::vec3 center, float radius) const {
+  for (const glm::vec4 &plane : planes) {
+    if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) {
+      return false;
+    }
+  }
+  return true;
+}
+
+#pragma endregion
@@ -4,7 +4,9 @@
 
 #include "dg/Camera.h"
 
+#include <algorithm>
 #include <glm/gtc/matrix_transform.hpp>
+#include <limits>
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtc/constants.hpp>
 #include <glm/gtx/quaternion.hpp>
@@ -18,6 +20,61 @@
 using namespace DirectX;
 #endif
 
+namespace {
+
+  // Frustum enclosing both eyes' frustums, as the tangents of its edges as
+  // seen from `origin`, in head space. The origin is `recess` behind the
+  // midpoint between the eyes.
+  struct StereoFrustum {
+    glm::vec3 origin;
+    float recess;
+    float left;
+    float right;
+    float bottom;
+    float top;
+  };
+
+  StereoFrustum GetStereoFrustum(const dg::Camera &camera) {
+    StereoFrustum frustum;
+    frustum.left = frustum.bottom = std::numeric_limits<float>::max();
+    frustum.right = frustum.top = -std::numeric_limits<float>::max();
+    glm::vec3 eyePositions[2];
+    vr::EVREye eyes[2] = { vr::EVREye::Eye_Left, vr::EVREye::Eye_Right };
+    for (int i = 0; i < 2; i++) {
+      // Recover the tangents of each eye's (possibly asymmetric) frustum
+      // from its projection matrix.
+      glm::mat4x4 projection = camera.GetProjectionMatrix(eyes[i]);
+      frustum.left = std::min(
+          frustum.left, (projection[2][0] - 1) / projection[0][0]);
+      frustum.right = std::max(
+          frustum.right, (projection[2][0] + 1) / projection[0][0]);
+      frustum.bottom = std::min(
+          frustum.bottom, (projection[2][1] - 1) / projection[1][1]);
+      frustum.top = std::max(
+          frustum.top, (projection[2][1] + 1) / projection[1][1]);
+      eyePositions[i] = glm::vec3(
+          dg::OVR2GLM(vr::VRSystem()->GetEyeToHeadTransform(eyes[i]))[3]);
+    }
+
+    // Move the origin back from between the eyes until its frustum contains
+    // both eyes' frustums.
+    float halfSeparation =
+        glm::distance(eyePositions[0], eyePositions[1]) * 0.5f;
+    frustum.recess = 0;
+    if (frustum.left < 0) {
+      frustum.recess =
+          std::max(frustum.recess, halfSeparation / -frustum.left);
+    }
+    if (frustum.right > 0) {
+      frustum.recess =
+          std::max(frustum.recess, halfSeparation / frustum.right);
+    }
+    frustum.origin = (eyePositions[0] + eyePositions[1]) * 0.5f +
+                     glm::vec3(0, 0, frustum.recess);
+    return frustum;
+  }
+
+} // namespace
 
 dg::Camera::Camera() : SceneObject() {}
 
@@ -61,3 +118,17 @@ glm::mat4x4 dg::Camera::GetProjectionMatrix(vr::EVREye eye) const {
   return OVR2GLM(
     vr::VRSystem()->GetProjectionMatrix(eye, nearClip, farClip));
 }
+
+glm::mat4x4 dg::Camera::GetStereoViewMatrix() const {
+  StereoFrustum frustum = GetStereoFrustum(*this);
+  return glm::translate(glm::mat4x4(1), -frustum.origin) * GetViewMatrix();
+}
+
+glm::mat4x4 dg::Camera::GetStereoProjectionMatrix() const {
+  StereoFrustum frustum = GetStereoFrustum(*this);
+  float stereoNear = nearClip + frustum.recess;
+  float stereoFar = farClip + frustum.recess;
+  return glm::frustum(frustum.left * stereoNear, frustum.right * stereoNear,
+                      frustum.bottom * stereoNear, frustum.top * stereoNear,
+                      stereoNear, stereoFar);
+}
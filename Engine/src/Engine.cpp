@@ -3,7 +3,9 @@
 //
 
 #include "dg/Engine.h"
+#include "dg/FrameAllocator.h"
 #include "dg/Scene.h"
+#include "dg/Shader.h"
 #include "dg/Utils.h"
 #include "dg/Window.h"
 
@@ -49,6 +51,10 @@ void dg::BaseEngine::Update() {
     return;
   }
 
+  // Temporaries of the frame before last are no longer needed.
+  FrameMemory::BeginFrame();
+  Graphics::Instance->BeginFrame();
+
   dg::Time::Update();
   window->PollEvents();
 
@@ -131,6 +137,10 @@ void dg::BaseEngine::StartNextScene() {
   try {
     scene->SetWindow(window);
     scene->Initialize();
+
+    // The scene's shaders were all submitted to the driver while it
+    // initialized, so wait for them together.
+    Shader::FinishAll();
   } catch (const EngineError& e) {
     throw std::runtime_error("Failed to initialize scene: " +
                              std::string(e.what()));
@@ -3,11 +3,17 @@
 //
 
 #include "dg/FileUtils.h"
+#include <cerrno>
 #include <fstream>
 #include <sstream>
+#include <sys/stat.h>
 #include <vector>
 #include "dg/Exceptions.h"
 
+#if defined(_WIN32)
+#include <direct.h>
+#endif
+
 std::string dg::FileUtils::LoadFile(const std::string& path) {
   std::ifstream file;
   std::stringstream fileStream;
@@ -115,3 +121,12 @@ std::string dg::FileUtils::FlattenPath(const std::string &path) {
   }
   return newpath.str();
 }
+
+bool dg::FileUtils::MakeDirectory(const std::string &path) {
+#if defined(_WIN32)
+  int result = _mkdir(path.c_str());
+#else
+  int result = mkdir(path.c_str(), 0755);
+#endif
+  return result == 0 || errno == EEXIST;
+}
@@ -0,0 +1,77 @@
+//
+//  FrameAllocator.cpp
+//
+
+#include "dg/FrameAllocator.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+
+#pragma region FrameArena
+
+const size_t dg::FrameArena::DEFAULT_BLOCK_SIZE;
+
+dg::FrameArena::FrameArena(size_t blockSize) : blockSize(blockSize) {}
+
+void *dg::FrameArena::Allocate(size_t size, size_t alignment) {
+  assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+  bytesAllocated += size;
+
+  while (true) {
+    for (; blockIndex < blocks.size(); blockIndex++, offset = 0) {
+      Block &block = blocks[blockIndex];
+      uintptr_t base = (uintptr_t)block.memory.get();
+      uintptr_t aligned = (base + offset + alignment - 1) & ~(alignment - 1);
+      if (aligned + size <= base + block.size) {
+        offset = aligned + size - base;
+        return (void *)aligned;
+      }
+    }
+
+    // Nothing left fits, so add a block big enough for this allocation.
+    size_t newBlockSize = std::max(blockSize, size + alignment);
+    blocks.push_back({ std::unique_ptr<char[]>(new char[newBlockSize]),
+                       newBlockSize });
+  }
+}
+
+void dg::FrameArena::Reset() {
+  if (blocks.size() > 1) {
+    size_t capacity = GetCapacity();
+    blocks.clear();
+    blocks.push_back({ std::unique_ptr<char[]>(new char[capacity]),
+                       capacity });
+  }
+  blockIndex = 0;
+  offset = 0;
+  bytesAllocated = 0;
+}
+
+size_t dg::FrameArena::GetBytesAllocated() const {
+  return bytesAllocated;
+}
+
+size_t dg::FrameArena::GetCapacity() const {
+  size_t capacity = 0;
+  for (const Block &block : blocks) {
+    capacity += block.size;
+  }
+  return capacity;
+}
+
+#pragma endregion
+#pragma region FrameMemory
+
+dg::FrameArena dg::FrameMemory::arenas[2];
+unsigned int dg::FrameMemory::current = 0;
+
+void dg::FrameMemory::BeginFrame() {
+  current = 1 - current;
+  arenas[current].Reset();
+}
+
+dg::FrameArena &dg::FrameMemory::Current() {
+  return arenas[current];
+}
+
+#pragma endregion
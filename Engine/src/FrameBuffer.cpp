@@ -18,7 +18,7 @@ std::shared_ptr<dg::FrameBuffer> dg::BaseFrameBuffer::Create(Options options) {
 dg::BaseFrameBuffer::BaseFrameBuffer(Options options) : options(options) {
   // Ensure all textures are the same type.
   TextureType type = options.textureOptions.empty()
-                         ? TextureType::_2D
+                         ? options.type
                          : options.textureOptions[0].type;
   for (auto &texOpts : options.textureOptions) {
     if (texOpts.type != type) {
@@ -33,6 +33,7 @@ dg::BaseFrameBuffer::BaseFrameBuffer(Options options) : options(options) {
   depthTexOpts.type = type;
   depthTexOpts.width = options.width;
   depthTexOpts.height = options.height;
+  depthTexOpts.layers = options.layers;
   depthTexOpts.format = options.hasStencil ? TexturePixelFormat::DEPTH_STENCIL
                                       : TexturePixelFormat::DEPTH;
   depthTexOpts.pixelType =
@@ -45,8 +46,10 @@ dg::BaseFrameBuffer::BaseFrameBuffer(Options options) : options(options) {
   // one color texture definition, create a standard one.
   if (options.hasColor && options.textureOptions.empty()) {
     TextureOptions texOpts;
+    texOpts.type = type;
     texOpts.width = options.width;
     texOpts.height = options.height;
+    texOpts.layers = options.layers;
     texOpts.wrap = TextureWrap::CLAMP_EDGE;
     options.textureOptions.push_back(texOpts);
   }
@@ -109,9 +112,12 @@ dg::OpenGLFrameBuffer::OpenGLFrameBuffer(Options options)
                                GL_TEXTURE_2D, tex->GetHandle(), 0);
         break;
       case TextureType::CUBEMAP:
+      case TextureType::_2D_ARRAY:
         glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i,
                              tex->GetHandle(), 0);
         break;
+      default:
+        break;
     }
   }
 
@@ -122,9 +128,12 @@ dg::OpenGLFrameBuffer::OpenGLFrameBuffer(Options options)
       glFramebufferTexture2D(GL_FRAMEBUFFER, format, GL_TEXTURE_2D,
                              depthTexture->GetHandle(), 0);
     case TextureType::CUBEMAP:
+    case TextureType::_2D_ARRAY:
       glFramebufferTexture(GL_FRAMEBUFFER, format, depthTexture->GetHandle(),
                            0);
       break;
+    default:
+      break;
   }
 
   //glDrawBuffer(GL_NONE);
@@ -149,6 +158,39 @@ GLuint dg::OpenGLFrameBuffer::GetHandle() const {
   return bufferHandle;
 }
 
+void dg::OpenGLFrameBuffer::SelectLayer(int layer) {
+  TextureType type = depthTexture->GetType();
+  assert(type == TextureType::_2D_ARRAY || type == TextureType::CUBEMAP);
+
+  glBindFramebuffer(GL_FRAMEBUFFER, bufferHandle);
+  GLenum format =
+      options.hasStencil ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+  if (layer < 0) {
+    for (int i = 0; i < colorTextures.size(); i++) {
+      glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i,
+                           colorTextures[i]->GetHandle(), 0);
+    }
+    glFramebufferTexture(GL_FRAMEBUFFER, format, depthTexture->GetHandle(), 0);
+  } else if (type == TextureType::CUBEMAP) {
+    // Cubemap faces can't be attached with glFramebufferTextureLayer before
+    // OpenGL 4.5.
+    GLenum face = GL_TEXTURE_CUBE_MAP_POSITIVE_X + layer;
+    for (int i = 0; i < colorTextures.size(); i++) {
+      glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, face,
+                             colorTextures[i]->GetHandle(), 0);
+    }
+    glFramebufferTexture2D(GL_FRAMEBUFFER, format, face,
+                           depthTexture->GetHandle(), 0);
+  } else {
+    for (int i = 0; i < colorTextures.size(); i++) {
+      glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i,
+                                colorTextures[i]->GetHandle(), 0, layer);
+    }
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, format,
+                              depthTexture->GetHandle(), 0, layer);
+  }
+}
+
 #pragma endregion
 #elif defined(_DIRECTX)
 #pragma region DirectX FrameBuffer
@@ -3,7 +3,10 @@
 //
 
 #include "dg/Graphics.h"
+#include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <glm/gtc/matrix_transform.hpp>
 #include "dg/Exceptions.h"
 #include "dg/FrameBuffer.h"
 #include "dg/Mesh.h"
@@ -15,6 +18,16 @@
 #include <WindowsX.h>
 #endif
 
+#if defined(_OPENGL)
+// Anisotropic filtering is core in GL 4.6, which GLAD wasn't generated for.
+#ifndef GL_TEXTURE_MAX_ANISOTROPY
+#define GL_TEXTURE_MAX_ANISOTROPY 0x84FE
+#endif
+#ifndef GL_MAX_TEXTURE_MAX_ANISOTROPY
+#define GL_MAX_TEXTURE_MAX_ANISOTROPY 0x84FF
+#endif
+#endif
+
 #pragma region Base Class
 
 std::unique_ptr<dg::Graphics::graphics_class> dg::Graphics::Instance;
@@ -84,17 +97,70 @@ const std::string &dg::Graphics::GetAPIName() { return apiName; }
 
 const std::string dg::Graphics::apiName = "OpenGL";
 
+// NOTE: Keep these consistent with the block names in
+//       assets/shaders/includes/shared_head.glsl.
+const char *dg::OpenGLGraphics::VIEW_BLOCK_NAME = "_ViewBlock";
+const char *dg::OpenGLGraphics::OBJECT_BLOCK_NAME = "_ObjectBlock";
+
 dg::OpenGLGraphics::OpenGLGraphics(Window& window) {}
 
+dg::OpenGLGraphics::~OpenGLGraphics() {
+  for (auto &sampler : samplers) {
+    glDeleteSamplers(1, &sampler.second);
+  }
+  samplers.clear();
+}
+
 void dg::OpenGLGraphics::InitializeGraphics() {
   // Load GLAD procedures.
   if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
     throw std::runtime_error("Failed to initialize GLAD.");
   }
+
+  // GLAD only loads the extensions it was generated with, so gather the
+  // rest from the context.
+  GLint extensionCount = 0;
+  glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+  for (GLint i = 0; i < extensionCount; i++) {
+    extensions.insert((const char *)glGetStringi(GL_EXTENSIONS, i));
+  }
+
+  // Let the driver compile shaders on as many threads as it likes. Some
+  // drivers only compile in the background once asked to.
+  typedef void (APIENTRYP MaxShaderCompilerThreadsProc)(GLuint count);
+  MaxShaderCompilerThreadsProc maxShaderCompilerThreads = nullptr;
+  if (SupportsExtension("GL_KHR_parallel_shader_compile")) {
+    maxShaderCompilerThreads = (MaxShaderCompilerThreadsProc)
+        glfwGetProcAddress("glMaxShaderCompilerThreadsKHR");
+  } else if (SupportsExtension("GL_ARB_parallel_shader_compile")) {
+    maxShaderCompilerThreads = (MaxShaderCompilerThreadsProc)
+        glfwGetProcAddress("glMaxShaderCompilerThreadsARB");
+  }
+  if (maxShaderCompilerThreads != nullptr) {
+    maxShaderCompilerThreads(0xFFFFFFFF);
+  }
+
+  if (SupportsVersion(4, 3) ||
+      (SupportsExtension("GL_ARB_compute_shader") &&
+       SupportsExtension("GL_ARB_shader_storage_buffer_object") &&
+       SupportsExtension("GL_ARB_shader_image_load_store") &&
+       SupportsExtension("GL_ARB_program_interface_query"))) {
+    memoryBarrier =
+        (MemoryBarrierProc)glfwGetProcAddress("glMemoryBarrier");
+  }
+
+  if (SupportsVersion(4, 6) ||
+      SupportsExtension("GL_ARB_texture_filter_anisotropic") ||
+      SupportsExtension("GL_EXT_texture_filter_anisotropic")) {
+    glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &maxAnisotropy);
+  }
 }
 
 void dg::OpenGLGraphics::InitializeResources() {
   Graphics::InitializeResources();
+
+  viewBinding = OpenGLShader::GetUniformBlockBinding(VIEW_BLOCK_NAME);
+  objectBinding = OpenGLShader::GetUniformBlockBinding(OBJECT_BLOCK_NAME);
 }
 
 void dg::OpenGLGraphics::SetRenderTarget(FrameBuffer &frameBuffer) {
@@ -157,6 +223,193 @@ void dg::OpenGLGraphics::ClearDepthStencil(bool clearDepth, bool clearStencil) {
   glClear(clearBits);
 }
 
+void dg::OpenGLGraphics::SetScissor(int x, int y, int width, int height) {
+  glEnable(GL_SCISSOR_TEST);
+  glScissor(x, y, width, height);
+}
+
+void dg::OpenGLGraphics::DisableScissor() {
+  glDisable(GL_SCISSOR_TEST);
+}
+
+void dg::OpenGLGraphics::SetClipPlaneEnabled(unsigned int index,
+                                             bool enabled) {
+  if (enabled) {
+    glEnable(GL_CLIP_DISTANCE0 + index);
+  } else {
+    glDisable(GL_CLIP_DISTANCE0 + index);
+  }
+}
+
+void dg::OpenGLGraphics::CopyFrameBufferRegion(FrameBuffer &source,
+                                               FrameBuffer &destination,
+                                               int x, int y, int width,
+                                               int height) {
+  GLbitfield mask = GL_DEPTH_BUFFER_BIT;
+  if (source.GetOptions().hasStencil && destination.GetOptions().hasStencil) {
+    mask |= GL_STENCIL_BUFFER_BIT;
+  }
+  if (source.ColorTextureCount() > 0 && destination.ColorTextureCount() > 0) {
+    mask |= GL_COLOR_BUFFER_BIT;
+  }
+
+  // Blits are clipped by the scissor test, so make sure it's off.
+  glDisable(GL_SCISSOR_TEST);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, source.GetHandle());
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, destination.GetHandle());
+  glBlitFramebuffer(x, y, x + width, y + height, x, y, x + width, y + height,
+                    mask, GL_NEAREST);
+  SetRenderTarget(destination);
+}
+
+bool dg::OpenGLGraphics::SupportsVersion(int major, int minor) const {
+  return GLVersion.major > major ||
+         (GLVersion.major == major && GLVersion.minor >= minor);
+}
+
+bool dg::OpenGLGraphics::SupportsExtension(const std::string &name) const {
+  return extensions.find(name) != extensions.end();
+}
+
+bool dg::OpenGLGraphics::SupportsCompute() const {
+  return memoryBarrier != nullptr;
+}
+
+void dg::OpenGLGraphics::IssueMemoryBarrier(GLbitfield barriers) {
+  assert(SupportsCompute());
+  memoryBarrier(barriers);
+}
+
+void dg::OpenGLGraphics::BindTexture(unsigned int unit,
+                                     const Texture &texture) {
+  GLenum target = texture.GetOptions().GetOpenGLTarget();
+  GLuint handle = texture.GetHandle();
+  TextureUnit &bound = GetTextureUnit(unit);
+  if (bound.target != target || bound.texture != handle) {
+    SetActiveTextureUnit(unit);
+    glBindTexture(target, handle);
+    bound.target = target;
+    bound.texture = handle;
+  }
+
+  GLuint sampler = texture.GetSampler();
+  if (bound.sampler != sampler) {
+    glBindSampler(unit, sampler);
+    bound.sampler = sampler;
+  }
+}
+
+void dg::OpenGLGraphics::BindTextureToEdit(GLenum target, GLuint texture) {
+  TextureUnit &bound = GetTextureUnit(activeTextureUnit);
+  if (bound.target != target || bound.texture != texture) {
+    glBindTexture(target, texture);
+    bound.target = target;
+    bound.texture = texture;
+  }
+}
+
+void dg::OpenGLGraphics::ForgetTexture(GLuint texture) {
+  for (TextureUnit &bound : textureUnits) {
+    if (bound.texture == texture) {
+      bound.target = GL_NONE;
+      bound.texture = 0;
+    }
+  }
+}
+
+GLuint dg::OpenGLGraphics::GetSampler(const TextureOptions &options) {
+  unsigned int anisotropy = maxAnisotropy > 1
+      ? std::min(std::max(options.anisotropy, 1u), (unsigned int)maxAnisotropy)
+      : 1;
+  SamplerKey key(options.GetOpenGLWrap(), options.GetOpenGLMinFilter(),
+                 options.GetOpenGLMagFilter(), anisotropy);
+  auto it = samplers.find(key);
+  if (it != samplers.end()) {
+    return it->second;
+  }
+
+  GLuint sampler = 0;
+  glGenSamplers(1, &sampler);
+  GLenum wrap = std::get<0>(key);
+  glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, wrap);
+  glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, wrap);
+  glSamplerParameteri(sampler, GL_TEXTURE_WRAP_R, wrap);
+  glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, std::get<1>(key));
+  glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, std::get<2>(key));
+  if (anisotropy > 1) {
+    glSamplerParameterf(sampler, GL_TEXTURE_MAX_ANISOTROPY,
+                        (float)anisotropy);
+  }
+  samplers[key] = sampler;
+  return sampler;
+}
+
+void dg::OpenGLGraphics::SetActiveTextureUnit(unsigned int unit) {
+  if (activeTextureUnit != unit) {
+    glActiveTexture(GL_TEXTURE0 + unit);
+    activeTextureUnit = unit;
+  }
+}
+
+dg::OpenGLGraphics::TextureUnit &dg::OpenGLGraphics::GetTextureUnit(
+    unsigned int unit) {
+  if (unit >= textureUnits.size()) {
+    textureUnits.resize(unit + 1);
+  }
+  return textureUnits[unit];
+}
+
+void dg::OpenGLGraphics::BeginFrame() {
+  uniformRing.BeginFrame();
+  viewBound = false;
+}
+
+void dg::OpenGLGraphics::SetViewUniforms(const glm::mat4x4 &view,
+                                         const glm::mat4x4 &projection,
+                                         glm::vec3 cameraPosition) {
+  ViewUniforms uniforms;
+  uniforms.view = view;
+  uniforms.projection = projection;
+  uniforms.cameraPosition = cameraPosition;
+  uniforms.bufferDimensions = viewportDimensions;
+  if (viewBound && viewGeneration == uniformRing.GetGeneration() &&
+      memcmp(&uniforms, &currentView, sizeof(uniforms)) == 0) {
+    return;
+  }
+
+  size_t offset = uniformRing.Write(&uniforms, sizeof(uniforms));
+  uniformRing.Bind(viewBinding, offset, sizeof(uniforms));
+  currentView = uniforms;
+  viewBound = true;
+  viewGeneration = uniformRing.GetGeneration();
+}
+
+void dg::OpenGLGraphics::SetObjectUniforms(
+    const glm::mat4x4 &model, const glm::mat4x4 &normal,
+    const glm::mat4x4 &modelViewProjection) {
+  static const glm::mat4x4 xfFlipY =
+      glm::scale(glm::mat4x4(1), glm::vec3(1, -1, 1));
+
+  ObjectUniforms uniforms;
+  uniforms.modelViewProjection = modelViewProjection;
+  if (GetEffectiveRasterizerState()->GetFlipRenderY()) {
+    uniforms.modelViewProjection = xfFlipY * modelViewProjection;
+  }
+  uniforms.model = model;
+  uniforms.normal = normal;
+
+  size_t offset = uniformRing.Write(&uniforms, sizeof(uniforms));
+  uniformRing.Bind(objectBinding, offset, sizeof(uniforms));
+
+  // Moving the ring to a new buffer unbinds the view block, which this draw
+  // still needs.
+  if (viewBound && viewGeneration != uniformRing.GetGeneration()) {
+    offset = uniformRing.Write(&currentView, sizeof(currentView));
+    uniformRing.Bind(viewBinding, offset, sizeof(currentView));
+    viewGeneration = uniformRing.GetGeneration();
+  }
+}
+
 void dg::OpenGLGraphics::ApplyRasterizerState(const RasterizerState &state) {
   auto cullMode = state.GetCullMode();
   switch (cullMode) {
@@ -476,6 +729,27 @@ void dg::DirectXGraphics::ClearDepthStencil(bool clearDepth,
                                  0);
 }
 
+void dg::DirectXGraphics::SetScissor(int x, int y, int width, int height) {
+  throw EngineError("TODO: Scissor rects not yet implemented for DirectX.");
+}
+
+void dg::DirectXGraphics::DisableScissor() {}
+
+void dg::DirectXGraphics::SetClipPlaneEnabled(unsigned int index,
+                                              bool enabled) {
+  if (enabled) {
+    throw EngineError("TODO: Clip planes not yet implemented for DirectX.");
+  }
+}
+
+void dg::DirectXGraphics::CopyFrameBufferRegion(FrameBuffer &source,
+                                                FrameBuffer &destination,
+                                                int x, int y, int width,
+                                                int height) {
+  throw EngineError(
+      "TODO: Framebuffer region copies not yet implemented for DirectX.");
+}
+
 
 void dg::DirectXGraphics::ApplyRasterizerState(const RasterizerState &state) {
   auto hash = std::hash<RasterizerState>{}(state);
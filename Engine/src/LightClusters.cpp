@@ -0,0 +1,374 @@
+//
+//  LightClusters.cpp
+//
+
+#include "dg/LightClusters.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <glm/gtc/constants.hpp>
+#include <limits>
+
+// The light data buffer is a flat array of ShaderData, read as RGBA32F texels.
+static_assert(sizeof(dg::Light::ShaderData) % sizeof(glm::vec4) == 0,
+              "Light::ShaderData must be a whole number of vec4s.");
+
+// The grid buffer is the raw cluster array, read as RGBA32UI texels holding
+// two clusters each.
+static_assert(sizeof(dg::LightClusters::Cluster) == 2 * sizeof(uint32_t),
+              "LightClusters::Cluster must be two packed uint32s.");
+static_assert(dg::LightClusters::CLUSTER_COUNT % 2 == 0,
+              "Cluster count must be even to pack two clusters per texel.");
+
+const unsigned int dg::LightClusters::TILES_X;
+const unsigned int dg::LightClusters::TILES_Y;
+const unsigned int dg::LightClusters::SLICES;
+const unsigned int dg::LightClusters::CLUSTER_COUNT;
+const unsigned int dg::LightClusters::TEXELS_PER_LIGHT;
+const float dg::LightClusters::ATTENUATION_THRESHOLD = 1.f / 256.f;
+
+#pragma region Binning
+
+void dg::LightClusters::Build(const glm::mat4x4 &view,
+                              const glm::mat4x4 &projection, float nearClip,
+                              float farClip,
+                              const Light::ShaderData *lights,
+                              size_t lightCount) {
+  this->projection = projection;
+  this->nearClip = nearClip;
+  this->farClip = farClip;
+  perspective = (projection[2][3] != 0);
+
+  this->lights.clear();
+  indices.clear();
+  assignments.clear();
+  std::fill(clusters.begin(), clusters.end(), Cluster());
+
+  // Global lights go first, since the shader evaluates them for every
+  // fragment before walking the fragment's cluster.
+  for (size_t i = 0; i < lightCount; i++) {
+    const Light::ShaderData &light = lights[i];
+    if (light.type != Light::LightType::NONE &&
+        std::isinf(LightRange(light))) {
+      this->lights.push_back(light);
+    }
+  }
+  globalLightCount = (unsigned int)this->lights.size();
+
+  for (size_t i = 0; i < lightCount; i++) {
+    const Light::ShaderData &light = lights[i];
+    if (light.type == Light::LightType::NONE) {
+      continue;
+    }
+
+    float range = LightRange(light);
+    if (std::isinf(range) || range <= 0) {
+      continue;
+    }
+
+    glm::vec3 position = glm::vec3(view * glm::vec4(light.position, 1));
+    glm::vec3 center = position;
+    float radius = range;
+
+    // Spot lights are bounded by the smallest sphere containing their cone,
+    // and then tested against each cluster's bounding sphere with the cone
+    // itself. A spot light's ambient term isn't limited to its cone, so only
+    // do this if it has no ambient.
+    bool isSpot = (light.type == Light::LightType::SPOT &&
+                   std::max({light.ambient.r, light.ambient.g,
+                             light.ambient.b}) <= 0);
+    glm::vec3 direction;
+    float cosAngle = 0;
+    float sinAngle = 0;
+    if (isSpot) {
+      float angle = std::min(light.outerCutoff, glm::pi<float>() * 0.5f);
+      cosAngle = std::cos(angle);
+      sinAngle = std::sin(angle);
+      direction = glm::normalize(glm::mat3(view) * light.direction);
+      if (angle <= glm::pi<float>() * 0.25f) {
+        radius = range / (2.f * cosAngle);
+        center = position + direction * radius;
+      } else {
+        radius = range * sinAngle;
+        center = position + direction * (range * cosAngle);
+      }
+    }
+
+    float minDepth = -center.z - radius;
+    float maxDepth = -center.z + radius;
+    if (maxDepth < nearClip || minDepth > farClip) {
+      continue;
+    }
+    minDepth = std::max(minDepth, nearClip);
+    maxDepth = std::min(maxDepth, farClip);
+
+    glm::uvec2 minTile;
+    glm::uvec2 maxTile;
+    TileRange(center, radius, minDepth, maxDepth, minTile, maxTile);
+    unsigned int minSlice = DepthSlice(minDepth);
+    unsigned int maxSlice = DepthSlice(maxDepth);
+
+    uint32_t lightIndex = (uint32_t)this->lights.size();
+    bool assigned = false;
+    for (unsigned int z = minSlice; z <= maxSlice; z++) {
+      for (unsigned int y = minTile.y; y <= maxTile.y; y++) {
+        for (unsigned int x = minTile.x; x <= maxTile.x; x++) {
+          Bounds bounds = ClusterBounds(x, y, z);
+
+          // Sphere against cluster AABB.
+          glm::vec3 closest = glm::clamp(center, bounds.min, bounds.max);
+          glm::vec3 delta = closest - center;
+          if (glm::dot(delta, delta) > radius * radius) {
+            continue;
+          }
+
+          // Cone against cluster bounding sphere.
+          if (isSpot) {
+            glm::vec3 clusterCenter = (bounds.min + bounds.max) * 0.5f;
+            float clusterRadius = glm::length(bounds.max - clusterCenter);
+            glm::vec3 v = clusterCenter - position;
+            float lengthSq = glm::dot(v, v);
+            float v1 = glm::dot(v, direction);
+            float closestDist =
+                cosAngle * std::sqrt(std::max(lengthSq - v1 * v1, 0.f)) -
+                v1 * sinAngle;
+            if (closestDist > clusterRadius || v1 > clusterRadius + range ||
+                v1 < -clusterRadius) {
+              continue;
+            }
+          }
+
+          assignments.emplace_back(ClusterIndex(x, y, z), lightIndex);
+          assigned = true;
+        }
+      }
+    }
+
+    if (assigned) {
+      this->lights.push_back(light);
+    }
+  }
+
+  // Counting sort of the assignments into contiguous per-cluster lists.
+  for (auto &assignment : assignments) {
+    clusters[assignment.first].count++;
+  }
+  uint32_t offset = 0;
+  for (Cluster &cluster : clusters) {
+    cluster.offset = offset;
+    offset += cluster.count;
+    cluster.count = 0;
+  }
+  indices.resize(offset);
+  for (auto &assignment : assignments) {
+    Cluster &cluster = clusters[assignment.first];
+    indices[cluster.offset + cluster.count++] = assignment.second;
+  }
+}
+
+float dg::LightClusters::LightRange(const Light::ShaderData &light) {
+  if (light.type != Light::LightType::POINT &&
+      light.type != Light::LightType::SPOT) {
+    return std::numeric_limits<float>::infinity();
+  }
+
+  float intensity = std::max({
+      light.diffuse.r, light.diffuse.g, light.diffuse.b,
+      light.specular.r, light.specular.g, light.specular.b,
+      light.ambient.r, light.ambient.g, light.ambient.b,
+  });
+  if (intensity <= 0) {
+    return 0;
+  }
+
+  // Solve intensity / (c + l*d + q*d^2) = threshold for d.
+  float k = intensity / ATTENUATION_THRESHOLD;
+  float c = light.constantCoeff;
+  float l = light.linearCoeff;
+  float q = light.quadraticCoeff;
+  if (c >= k) {
+    return 0;
+  }
+  if (q > 0) {
+    return (-l + std::sqrt(l * l - 4.f * q * (c - k))) / (2.f * q);
+  }
+  if (l > 0) {
+    return (k - c) / l;
+  }
+  return std::numeric_limits<float>::infinity();
+}
+
+dg::LightClusters::Bounds dg::LightClusters::ClusterBounds(
+    unsigned int x, unsigned int y, unsigned int z) const {
+  float ndcX[2] = {
+    -1.f + 2.f * x / TILES_X,
+    -1.f + 2.f * (x + 1) / TILES_X,
+  };
+  float ndcY[2] = {
+    -1.f + 2.f * y / TILES_Y,
+    -1.f + 2.f * (y + 1) / TILES_Y,
+  };
+  float depths[2] = { SliceDepth(z), SliceDepth(z + 1) };
+
+  Bounds bounds;
+  bounds.min = glm::vec3(std::numeric_limits<float>::max());
+  bounds.max = glm::vec3(-std::numeric_limits<float>::max());
+  for (float depth : depths) {
+    for (int i = 0; i < 2; i++) {
+      glm::vec2 corner;
+      if (perspective) {
+        corner.x = depth * (ndcX[i] + projection[2][0]) / projection[0][0];
+        corner.y = depth * (ndcY[i] + projection[2][1]) / projection[1][1];
+      } else {
+        corner.x = (ndcX[i] - projection[3][0]) / projection[0][0];
+        corner.y = (ndcY[i] - projection[3][1]) / projection[1][1];
+      }
+      bounds.min = glm::min(bounds.min, glm::vec3(corner, -depth));
+      bounds.max = glm::max(bounds.max, glm::vec3(corner, -depth));
+    }
+  }
+  return bounds;
+}
+
+float dg::LightClusters::SliceDepth(unsigned int slice) const {
+  float t = (float)slice / SLICES;
+  if (perspective) {
+    return nearClip * std::pow(farClip / nearClip, t);
+  }
+  return nearClip + (farClip - nearClip) * t;
+}
+
+unsigned int dg::LightClusters::DepthSlice(float depth) const {
+  glm::vec3 slicing = GetDepthSlicing();
+  float slice = perspective
+      ? std::log(std::max(depth, std::numeric_limits<float>::min())) *
+            slicing.x + slicing.y
+      : depth * slicing.x + slicing.y;
+  return (unsigned int)glm::clamp((int)std::floor(slice), 0, (int)SLICES - 1);
+}
+
+void dg::LightClusters::TileRange(const glm::vec3 &center, float radius,
+                                  float minDepth, float maxDepth,
+                                  glm::uvec2 &min, glm::uvec2 &max) const {
+  // The sphere's view-space AABB projects to a screen-space rectangle whose
+  // extremes lie at its corners, since NDC is monotonic in both x and 1/depth.
+  glm::vec2 ndcMin = glm::vec2(std::numeric_limits<float>::max());
+  glm::vec2 ndcMax = glm::vec2(-std::numeric_limits<float>::max());
+  float depths[2] = { minDepth, maxDepth };
+  for (float depth : depths) {
+    for (float side = -1; side <= 1; side += 2) {
+      glm::vec2 point = glm::vec2(center) + glm::vec2(side * radius);
+      glm::vec2 ndc;
+      if (perspective) {
+        ndc.x = projection[0][0] * point.x / depth - projection[2][0];
+        ndc.y = projection[1][1] * point.y / depth - projection[2][1];
+      } else {
+        ndc.x = projection[0][0] * point.x + projection[3][0];
+        ndc.y = projection[1][1] * point.y + projection[3][1];
+      }
+      ndcMin = glm::min(ndcMin, ndc);
+      ndcMax = glm::max(ndcMax, ndc);
+    }
+  }
+
+  glm::vec2 tiles = glm::vec2(TILES_X, TILES_Y);
+  glm::ivec2 lastTile = glm::ivec2(TILES_X - 1, TILES_Y - 1);
+  min = glm::uvec2(glm::clamp(
+      glm::ivec2(glm::floor((ndcMin * 0.5f + 0.5f) * tiles)), glm::ivec2(0),
+      lastTile));
+  max = glm::uvec2(glm::clamp(
+      glm::ivec2(glm::floor((ndcMax * 0.5f + 0.5f) * tiles)), glm::ivec2(0),
+      lastTile));
+}
+
+#pragma endregion
+#pragma region Accessors
+
+const std::vector<dg::Light::ShaderData> &dg::LightClusters::GetLights()
+    const {
+  return lights;
+}
+
+unsigned int dg::LightClusters::GetGlobalLightCount() const {
+  return globalLightCount;
+}
+
+const std::vector<dg::LightClusters::Cluster> &
+dg::LightClusters::GetClusters() const {
+  return clusters;
+}
+
+const std::vector<uint32_t> &dg::LightClusters::GetIndices() const {
+  return indices;
+}
+
+glm::vec3 dg::LightClusters::GetDepthSlicing() const {
+  if (perspective) {
+    float scale = SLICES / std::log(farClip / nearClip);
+    return glm::vec3(scale, -std::log(nearClip) * scale, 1);
+  }
+  float scale = SLICES / (farClip - nearClip);
+  return glm::vec3(scale, -nearClip * scale, 0);
+}
+
+std::shared_ptr<dg::Texture> dg::LightClusters::GetLightDataTexture() const {
+  return lightDataTexture;
+}
+
+std::shared_ptr<dg::Texture> dg::LightClusters::GetGridTexture() const {
+  return gridTexture;
+}
+
+std::shared_ptr<dg::Texture> dg::LightClusters::GetIndexTexture() const {
+  return indexTexture;
+}
+
+#pragma endregion
+#pragma region GPU Upload
+
+void dg::LightClusters::UploadTextures() {
+  EnsureCapacity(lightDataTexture, TexturePixelType::FLOAT,
+                 (unsigned int)lights.size() * TEXELS_PER_LIGHT);
+  EnsureCapacity(gridTexture, TexturePixelType::INT, CLUSTER_COUNT / 2);
+  EnsureCapacity(indexTexture, TexturePixelType::INT,
+                 ((unsigned int)indices.size() + 3) / 4);
+
+#if defined(_OPENGL)
+  if (!lights.empty()) {
+    lightDataTexture->UpdateBufferData(
+        lights.data(), lights.size() * sizeof(Light::ShaderData));
+  }
+  gridTexture->UpdateBufferData(clusters.data(),
+                                clusters.size() * sizeof(Cluster));
+  if (!indices.empty()) {
+    indexTexture->UpdateBufferData(indices.data(),
+                                   indices.size() * sizeof(uint32_t));
+  }
+#endif
+}
+
+void dg::LightClusters::EnsureCapacity(std::shared_ptr<Texture> &texture,
+                                       TexturePixelType pixelType,
+                                       unsigned int texels) {
+  if (texture != nullptr && texture->GetWidth() >= texels) {
+    return;
+  }
+
+  // Grow geometrically so a slowly increasing light count doesn't reallocate
+  // every frame.
+  unsigned int capacity = 64;
+  while (capacity < texels) {
+    capacity *= 2;
+  }
+
+  TextureOptions options;
+  options.type = TextureType::BUFFER;
+  options.format = TexturePixelFormat::RGBA;
+  options.pixelType = pixelType;
+  options.mipmap = false;
+  options.width = capacity;
+  options.height = 1;
+  texture = Texture::Generate(options);
+}
+
+#pragma endregion
@@ -7,13 +7,14 @@
 #include "dg/Texture.h"
 
 // NOTE: Keep these consistent with MAX_LIGHTS in
-//       -> assets/shaders/includes/fragment_head.glsl.
+//       -> assets/shaders/includes/shared_head.glsl.
 //       -> assets/shaders/StandardPixelShader.hlsl.
 #if defined(_OPENGL)
 const char *dg::Light::LIGHTS_ARRAY_NAME = "_Lights";
 #elif defined(_DIRECTX)
 const char *dg::Light::LIGHTS_ARRAY_NAME = "lights";
 #endif
+const char *dg::Light::LIGHTS_BLOCK_NAME = "_LightBlock";
 const int dg::Light::MAX_LIGHTS;
 
 #pragma region Light
@@ -50,10 +51,18 @@ void dg::Light::SetCastShadows(bool castShadows) {
   this->castShadows = castShadows;
 }
 
+void dg::Light::SetShadowResolution(unsigned int resolution) {
+  shadowResolution = resolution;
+}
+
 void dg::Light::SetLightTransform(const glm::mat4x4 &xf) {
   data.lightTransform = xf;
 }
 
+void dg::Light::SetShadowIndex(int index) {
+  data.shadowIndex = index;
+}
+
 glm::vec3 dg::Light::GetAmbient() const {
   return data.ambient;
 }
@@ -74,6 +83,10 @@ bool dg::Light::GetCastShadows() const {
   return castShadows;
 }
 
+unsigned int dg::Light::GetShadowResolution() const {
+  return shadowResolution;
+}
+
 const glm::mat4x4 &dg::Light::GetLightTransform() const {
   return data.lightTransform;
 }
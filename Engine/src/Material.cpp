@@ -3,13 +3,67 @@
 //
 
 #include "dg/Material.h"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstring>
 #include <glm/gtc/matrix_transform.hpp>
+#include <string>
+#include "dg/Exceptions.h"
 #include "dg/Graphics.h"
+#include "dg/LightClusters.h"
+#include "dg/ShadowCascades.h"
+
+namespace {
+
+  // Name hashes of the elements of a uniform array, for keeping in a
+  // static so that the names are only built once.
+  template <size_t count>
+  std::array<uint64_t, count> ArrayElementHashes(const char *array) {
+    std::array<uint64_t, count> hashes;
+    for (size_t i = 0; i < count; i++) {
+      hashes[i] = dg::Shader::HashUniformName(
+          std::string(array) + "[" + std::to_string(i) + "]");
+    }
+    return hashes;
+  }
+
+  // Number of floats in each element of an array property type.
+  size_t ArrayElementFloats(dg::Material::PropertyType type) {
+    switch (type) {
+      case dg::Material::PropertyType::FLOAT_ARRAY:
+        return 1;
+      case dg::Material::PropertyType::VEC2_ARRAY:
+        return 2;
+      case dg::Material::PropertyType::VEC3_ARRAY:
+        return 3;
+      case dg::Material::PropertyType::VEC4_ARRAY:
+        return 4;
+      case dg::Material::PropertyType::MAT4X4_ARRAY:
+        return 16;
+      default:
+        return 0;
+    }
+  }
+
+  // Number of elements in an array property.
+  GLsizei ArrayLength(const dg::Material::Property &property) {
+    return (GLsizei)(property.array.size() /
+                     ArrayElementFloats(property.type));
+  }
+
+} // namespace
+
+const char *dg::Material::PROPERTY_BLOCK_NAME = "_Material";
+
+std::unordered_map<std::string, unsigned int> dg::Material::sharedTexUnits;
+unsigned int dg::Material::nextSharedTexUnit =
+    (unsigned int)TexUnitHints::END;
 
 dg::Material::Material(Material& other) {
   this->shader = other.shader;
   this->properties = other.properties;
-  this->highestTexUnitHint = other.highestTexUnitHint;
+  this->keywords = other.keywords;
   this->rasterizerOverride = other.rasterizerOverride;
   this->queue = other.queue;
 }
@@ -32,58 +86,67 @@ void dg::swap(Material& first, Material& second) {
   using std::swap;
   swap(first.shader, second.shader);
   swap(first.properties, second.properties);
-  swap(first.highestTexUnitHint, second.highestTexUnitHint);
+  swap(first.keywords, second.keywords);
+  swap(first.variant, second.variant);
+  swap(first.variantBase, second.variantBase);
   swap(first.rasterizerOverride, second.rasterizerOverride);
   swap(first.queue, second.queue);
+#if defined(_OPENGL)
+  swap(first.blockLayout, second.blockLayout);
+  swap(first.blockData, second.blockData);
+  swap(first.blockBuffer, second.blockBuffer);
+  swap(first.dirtyBegin, second.dirtyBegin);
+  swap(first.dirtyEnd, second.dirtyEnd);
+#endif
 }
 
 void dg::Material::SetProperty(const std::string& name, bool value) {
   Property prop;
   prop.type = PropertyType::BOOL;
   prop.value._bool = value;
-  properties.insert_or_assign(name, prop);
+  StoreProperty(name, prop);
 }
 
 void dg::Material::SetProperty(const std::string& name, int value) {
   Property prop;
   prop.type = PropertyType::INT;
   prop.value._int = value;
-  properties.insert_or_assign(name, prop);
+  StoreProperty(name, prop);
 }
 
 void dg::Material::SetProperty(const std::string& name, float value) {
   Property prop;
   prop.type = PropertyType::FLOAT;
   prop.value._float = value;
-  properties.insert_or_assign(name, prop);
+  StoreProperty(name, prop);
 }
 
 void dg::Material::SetProperty(const std::string& name, glm::vec2 value) {
   Property prop;
   prop.type = PropertyType::VEC2;
   prop.value._vec2 = value;
-  properties.insert_or_assign(name, prop);
+  StoreProperty(name, prop);
 }
 
 void dg::Material::SetProperty(const std::string& name, glm::vec3 value) {
   Property prop;
   prop.type = PropertyType::VEC3;
   prop.value._vec3 = value;
-  properties.insert_or_assign(name, prop);
+  StoreProperty(name, prop);
 }
 
 void dg::Material::SetProperty(const std::string& name, glm::vec4 value) {
   Property prop;
   prop.type = PropertyType::VEC4;
   prop.value._vec4 = value;
-  properties.insert_or_assign(name, prop);
+  StoreProperty(name, prop);
 }
 
 void dg::Material::SetProperty(const std::string& name, glm::mat4x4 value) {
   Property prop;
   prop.type = PropertyType::MAT4X4;
   prop.value._mat4x4 = value;
-  properties.insert_or_assign(name, prop);
+  StoreProperty(name, prop);
 }
 
 void dg::Material::SetProperty(
@@ -97,23 +160,159 @@ void dg::Material::SetProperty(
   Property prop;
   prop.type = PropertyType::TEXTURE;
   prop.texture = value;
-  prop.texUnitHint = texUnitHint;
-  if (texUnitHint > (int)highestTexUnitHint) {
-    highestTexUnitHint = texUnitHint;
+  if (texUnitHint >= 0) {
+    prop.texUnit = (unsigned int)texUnitHint;
+    nextSharedTexUnit = std::max(nextSharedTexUnit, prop.texUnit + 1);
+  } else {
+    prop.texUnit = GetSharedTexUnit(name);
+  }
+  StoreProperty(name, prop);
+}
+
+unsigned int dg::Material::GetSharedTexUnit(const std::string &name) {
+  auto it = sharedTexUnits.find(name);
+  if (it != sharedTexUnits.end()) {
+    return it->second;
   }
-  properties.insert_or_assign(name, prop);
+
+#if defined(_OPENGL)
+  GLint maxUnits = 0;
+  glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &maxUnits);
+  if (nextSharedTexUnit >= (unsigned int)maxUnits) {
+    throw EngineError("Too many distinct texture properties. Only " +
+                      std::to_string(maxUnits) +
+                      " texture units are available.");
+  }
+#endif
+  unsigned int unit = nextSharedTexUnit++;
+  sharedTexUnits[name] = unit;
+  return unit;
+}
+
+void dg::Material::SetProperty(const std::string& name,
+                               const std::vector<float>& values) {
+  StoreArrayProperty(name, PropertyType::FLOAT_ARRAY, values.data(),
+                     values.size());
+}
+
+void dg::Material::SetProperty(const std::string& name,
+                               const std::vector<glm::vec2>& values) {
+  StoreArrayProperty(name, PropertyType::VEC2_ARRAY, values.data(),
+                     values.size());
+}
+
+void dg::Material::SetProperty(const std::string& name,
+                               const std::vector<glm::vec3>& values) {
+  StoreArrayProperty(name, PropertyType::VEC3_ARRAY, values.data(),
+                     values.size());
+}
+
+void dg::Material::SetProperty(const std::string& name,
+                               const std::vector<glm::vec4>& values) {
+  StoreArrayProperty(name, PropertyType::VEC4_ARRAY, values.data(),
+                     values.size());
+}
+
+void dg::Material::SetProperty(const std::string& name,
+                               const std::vector<glm::mat4x4>& values) {
+  StoreArrayProperty(name, PropertyType::MAT4X4_ARRAY, values.data(),
+                     values.size());
+}
+
+void dg::Material::SetProperty(const std::string& name,
+                               const glm::mat4x4 *values, size_t count) {
+  StoreArrayProperty(name, PropertyType::MAT4X4_ARRAY, values, count);
+}
+
+template <typename T>
+void dg::Material::StoreArrayProperty(const std::string& name,
+                                      PropertyType type, const T *values,
+                                      size_t count) {
+  static_assert(sizeof(T) % sizeof(float) == 0,
+                "Array elements must be made of floats.");
+  assert(sizeof(T) / sizeof(float) == ArrayElementFloats(type));
+  const float *floats = reinterpret_cast<const float *>(values);
+  size_t floatCount = count * sizeof(T) / sizeof(float);
+
+  // Arrays set every frame overwrite their existing storage in place.
+  auto it = properties.find(name);
+  if (it != properties.end() && it->second.type == type) {
+    Property &prop = it->second;
+    prop.array.assign(floats, floats + floatCount);
+#if defined(_OPENGL)
+    if (blockLayout != nullptr) {
+      WriteBlockProperty(prop);
+    }
+#endif
+    return;
+  }
+
+  Property prop;
+  prop.type = type;
+  prop.array.assign(floats, floats + floatCount);
+  StoreProperty(name, prop);
+}
+
+void dg::Material::StoreProperty(const std::string& name, Property& property) {
+  property.nameHash = Shader::HashUniformName(name);
+#if defined(_OPENGL)
+  if (blockLayout != nullptr) {
+    WriteBlockProperty(property);
+  }
+#endif
+  properties.insert_or_assign(name, property);
 }
 
 void dg::Material::ClearProperty(const std::string& name) {
-  properties.erase(name);
+  auto it = properties.find(name);
+  if (it == properties.end()) {
+    return;
+  }
+
+#if defined(_OPENGL)
+  // Cleared block members go back to zero, as cleared uniforms would be.
+  if (it->second.inBlock) {
+    Property cleared = it->second;
+    cleared.value = PropertyValue();
+    std::fill(cleared.array.begin(), cleared.array.end(), 0.0f);
+    WriteBlockProperty(cleared);
+  }
+#endif
+
+  properties.erase(it);
+}
+
+void dg::Material::SetKeyword(const std::string& keyword, bool enabled) {
+  auto it = std::lower_bound(keywords.begin(), keywords.end(), keyword);
+  bool found = it != keywords.end() && *it == keyword;
+  if (enabled && !found) {
+    keywords.insert(it, keyword);
+    variant = nullptr;
+  } else if (!enabled && found) {
+    keywords.erase(it);
+    variant = nullptr;
+  }
+}
+
+bool dg::Material::HasKeyword(const std::string& keyword) const {
+  return std::binary_search(keywords.begin(), keywords.end(), keyword);
+}
+
+dg::Shader &dg::Material::GetActiveShader() const {
+  assert(shader != nullptr);
+  if (variant == nullptr || variantBase != shader) {
+    variantBase = shader;
+    variant = shader->GetVariant(keywords);
+  }
+  return *variant;
 }
 
 void dg::Material::SendBufferDimensions(glm::vec2 dimensions) {
-  shader->SetVec2("_BufferDimensions", dimensions);
+  GetActiveShader().SetVec2("_BufferDimensions", dimensions);
 }
 
 void dg::Material::SendCameraPosition(glm::vec3 position) {
-  shader->SetVec3("_CameraPosition", position);
+  GetActiveShader().SetVec3("_CameraPosition", position);
 }
 
 void dg::Material::SendMatrixMVP(glm::mat4x4 mvp) {
@@ -121,137 +320,417 @@ void dg::Material::SendMatrixMVP(glm::mat4x4 mvp) {
   if (Graphics::Instance->GetEffectiveRasterizerState()->GetFlipRenderY()) {
     mvp = xfFlipY * mvp;
   }
-  shader->SetMat4("_Matrix_MVP", mvp);
+  GetActiveShader().SetMat4("_Matrix_MVP", mvp);
 }
 
 void dg::Material::SendMatrixM(glm::mat4x4 m) {
-  shader->SetMat4("_Matrix_M", m);
+  GetActiveShader().SetMat4("_Matrix_M", m);
 }
 
 void dg::Material::SendMatrixV(glm::mat4x4 v) {
-  shader->SetMat4("_Matrix_V", v);
+  GetActiveShader().SetMat4("_Matrix_V", v);
 }
 
 void dg::Material::SendMatrixP(glm::mat4x4 p) {
-  shader->SetMat4("_Matrix_P", p);
+  GetActiveShader().SetMat4("_Matrix_P", p);
 }
 
 void dg::Material::SendMatrixNormal(glm::mat4x4 normal) {
-  shader->SetMat4("_Matrix_Normal", normal);
+  GetActiveShader().SetMat4("_Matrix_Normal", normal);
 }
 
+void dg::Material::SendLights(
+    const Light::ShaderData (&lights)[Light::MAX_LIGHTS]) {
 #if defined(_OPENGL)
-void dg::Material::SendLight(int index, const Light::ShaderData& data) {
-  shader->SetVec3(LightProperty(index, "diffuse"), data.diffuse);
-  shader->SetInt(LightProperty(index, "type"), (int)data.type);
-  shader->SetVec3(LightProperty(index, "ambient"), data.ambient);
-  shader->SetFloat(LightProperty(index, "innerCutoff"), data.innerCutoff);
-  shader->SetVec3(LightProperty(index, "specular"), data.specular);
-  shader->SetFloat(LightProperty(index, "outerCutoff"), data.outerCutoff);
-  shader->SetVec3(LightProperty(index, "position"), data.position);
-  shader->SetFloat(LightProperty(index, "constantCoeff"), data.constantCoeff);
-  shader->SetVec3(LightProperty(index, "direction"), data.direction);
-  shader->SetFloat(LightProperty(index, "linearCoeff"), data.linearCoeff);
-  shader->SetFloat(LightProperty(index, "quadraticCoeff"), data.quadraticCoeff);
-  shader->SetInt(LightProperty(index, "hasShadow"), data.hasShadow);
-  shader->SetMat4(LightProperty(index, "lightTransform"), data.lightTransform);
-}
-
-void dg::Material::ClearLights() {
-  for (int i = 0; i < Light::MAX_LIGHTS; i++) {
-    ClearLight(i);
-  }
+  // OpenGL shaders read lights from the light block, which the scene
+  // uploads and binds once per subrender.
+#elif defined(_DIRECTX)
+  GetActiveShader().SetData(Light::LIGHTS_ARRAY_NAME, lights);
+#endif
 }
 
-void dg::Material::ClearLight(int index) {
-  shader->SetInt(LightProperty(index, "type"), (int)Light::LightType::NONE);
+void dg::Material::SendShadowMap(std::shared_ptr<Texture> shadowMap) {
+#if defined(_OPENGL)
+  SetProperty("_ShadowMap", shadowMap, (int)TexUnitHints::SHADOWMAP);
+#elif defined(_DIRECTX)
+  // TODO
+#endif
 }
+
+void dg::Material::SendLightClusters(const LightClusters &clusters) {
+#if defined(_OPENGL)
+  // Engine uniforms are sent every draw, so they're looked up by hashes of
+  // their names computed once.
+  static const uint64_t lightDataHash = Shader::HashUniformName("_LightData");
+  static const uint64_t lightGridHash = Shader::HashUniformName("_LightGrid");
+  static const uint64_t lightIndicesHash =
+      Shader::HashUniformName("_LightIndices");
+  static const uint64_t globalCountHash =
+      Shader::HashUniformName("_LightClusters.globalCount");
+  static const uint64_t depthSlicingHash =
+      Shader::HashUniformName("_LightClusters.depthSlicing");
+
+  auto &glShader = static_cast<OpenGLShader &>(GetActiveShader());
+  glShader.SetTexture((int)TexUnitHints::LIGHT_DATA,
+                      glShader.GetUniformLocation(lightDataHash),
+                      clusters.GetLightDataTexture().get());
+  glShader.SetTexture((int)TexUnitHints::LIGHT_GRID,
+                      glShader.GetUniformLocation(lightGridHash),
+                      clusters.GetGridTexture().get());
+  glShader.SetTexture((int)TexUnitHints::LIGHT_INDICES,
+                      glShader.GetUniformLocation(lightIndicesHash),
+                      clusters.GetIndexTexture().get());
+  glShader.SetUniform(glShader.GetUniformLocation(globalCountHash),
+                      (int)clusters.GetGlobalLightCount());
+  glShader.SetUniform(glShader.GetUniformLocation(depthSlicingHash),
+                      clusters.GetDepthSlicing());
+#elif defined(_DIRECTX)
+  // TODO
 #endif
+}
 
-void dg::Material::SendLights(
-    const Light::ShaderData (&lights)[Light::MAX_LIGHTS]) {
+void dg::Material::SendShadowCascades(const ShadowCascades &cascades) {
 #if defined(_OPENGL)
-  ClearLights();
-  for (int i = 0; i < Light::MAX_LIGHTS; i++) {
-    if (lights[i].type != Light::LightType::NONE) {
-      SendLight(i, lights[i]);
-    } else {
-      ClearLight(i);
-    }
+  static const uint64_t shadowMapHash =
+      Shader::HashUniformName("_CascadedShadowMap");
+  static const uint64_t countHash = Shader::HashUniformName("_Cascades.count");
+  static const uint64_t splitsHash =
+      Shader::HashUniformName("_Cascades.splits");
+  static const auto transformHashes =
+      ArrayElementHashes<ShadowCascades::MAX_CASCADES>(
+          "_Cascades.transforms");
+
+  auto &glShader = static_cast<OpenGLShader &>(GetActiveShader());
+  GLint shadowMapLocation = glShader.GetUniformLocation(shadowMapHash);
+  std::shared_ptr<Texture> texture = cascades.GetTexture();
+  if (!cascades.IsActive() || texture == nullptr) {
+    // Even when unused, the array sampler must not share a texture unit with
+    // the 2D samplers, which unassigned samplers default to.
+    glShader.SetUniform(shadowMapLocation,
+                        (int)TexUnitHints::CASCADED_SHADOWMAP);
+    glShader.SetUniform(glShader.GetUniformLocation(countHash), 0);
+    return;
+  }
+
+  glShader.SetTexture((int)TexUnitHints::CASCADED_SHADOWMAP,
+                      shadowMapLocation, texture.get());
+  glShader.SetUniform(glShader.GetUniformLocation(countHash),
+                      (int)cascades.GetCount());
+  glShader.SetUniform(glShader.GetUniformLocation(splitsHash),
+                      cascades.GetSplitDepths());
+  for (unsigned int i = 0; i < cascades.GetCount(); i++) {
+    glShader.SetUniform(glShader.GetUniformLocation(transformHashes[i]),
+                        cascades.GetLightTransform(i));
   }
 #elif defined(_DIRECTX)
-  shader->SetData(Light::LIGHTS_ARRAY_NAME, lights);
+  // TODO
 #endif
 }
 
-const std::string dg::Material::LightProperty(
-    int index, const std::string& property) {
-  char buffer[128];
-  assert(index >= 0 && index < Light::MAX_LIGHTS);
-  assert(snprintf(
-        buffer, sizeof(buffer), "%s[%d].%s",
-        Light::LIGHTS_ARRAY_NAME, index, property.c_str()) >= 0);
-  return std::string(buffer);
+void dg::Material::SendPointShadowMaps(
+    const std::vector<std::shared_ptr<Texture>> &shadowMaps) {
+#if defined(_OPENGL)
+  static const auto shadowMapHashes =
+      ArrayElementHashes<PointShadowMap::MAX_SHADOWED_LIGHTS>(
+          "_PointShadowMaps");
+
+  auto &glShader = static_cast<OpenGLShader &>(GetActiveShader());
+  for (unsigned int i = 0; i < PointShadowMap::MAX_SHADOWED_LIGHTS; i++) {
+    GLint location = glShader.GetUniformLocation(shadowMapHashes[i]);
+    int unit = (int)TexUnitHints::POINT_SHADOWMAPS + i;
+    if (i < shadowMaps.size() && shadowMaps[i] != nullptr) {
+      glShader.SetTexture(unit, location, shadowMaps[i].get());
+    } else {
+      // Keep unused cube samplers off of the 2D samplers' texture units.
+      glShader.SetUniform(location, unit);
+    }
+  }
+#elif defined(_DIRECTX)
+  // TODO
+#endif
 }
 
-void dg::Material::SendShadowMap(std::shared_ptr<Texture> shadowMap) {
+void dg::Material::SendStereo(bool stereo,
+                              const glm::mat4x4 *reprojections) {
 #if defined(_OPENGL)
-  SetProperty("_ShadowMap", shadowMap, (int)TexUnitHints::SHADOWMAP);
+  static const uint64_t stereoHash = Shader::HashUniformName("_Stereo");
+  static const uint64_t reprojectionsHash =
+      Shader::HashUniformName("_Matrix_StereoReprojection");
+
+  auto &glShader = static_cast<OpenGLShader &>(GetActiveShader());
+  glShader.SetUniform(glShader.GetUniformLocation(stereoHash), stereo);
+  if (stereo) {
+    assert(reprojections != nullptr);
+    glShader.SetUniform(glShader.GetUniformLocation(reprojectionsHash),
+                        reprojections, 2);
+  }
 #elif defined(_DIRECTX)
-  // TODO
+  if (stereo) {
+    throw EngineError("TODO: Single-pass stereo not yet implemented for "
+                      "DirectX build.");
+  }
 #endif
 }
 
 void dg::Material::Use() const {
-  assert(shader != nullptr);
+  Shader &activeShader = GetActiveShader();
 
 #if defined(_OPENGL)
-  shader->Use();
+  activeShader.Use();
 #endif
 
   SendShaderProperties();
 
 #if defined(_DIRECTX)
-  shader->Use();
+  activeShader.Use();
 #endif
 }
 
 void dg::Material::SendShaderProperties() const {
-  unsigned int textureUnit = highestTexUnitHint + 1;
+  SendProperties(GetActiveShader());
+}
+
+void dg::Material::SendProperties(Shader &target) const {
+#if defined(_OPENGL)
+  static const uint64_t blockNameHash =
+      Shader::HashUniformName(PROPERTY_BLOCK_NAME);
+  OpenGLShader &glShader = static_cast<OpenGLShader &>(target);
+  auto layout = glShader.GetUniformBlock(blockNameHash);
+  if (layout != nullptr) {
+    if (blockLayout == nullptr ||
+        blockLayout->layoutHash != layout->layoutHash) {
+      BuildPropertyBlock(layout);
+    }
+    BindPropertyBlock();
+  }
+
+  // Properties outside of the block are set by the locations of their
+  // precomputed name hashes, and skipped if the shader doesn't have them.
+  for (auto it = properties.begin(); it != properties.end(); it++) {
+    const Property &property = it->second;
+    if (layout != nullptr && property.inBlock) {
+      continue;
+    }
+
+    GLint location = glShader.GetUniformLocation(property.nameHash);
+    if (location < 0) {
+      continue;
+    }
+
+    switch (property.type) {
+      case PropertyType::BOOL:
+        glShader.SetUniform(location, property.value._bool);
+        break;
+      case PropertyType::INT:
+        glShader.SetUniform(location, property.value._int);
+        break;
+      case PropertyType::FLOAT:
+        glShader.SetUniform(location, property.value._float);
+        break;
+      case PropertyType::VEC2:
+        glShader.SetUniform(location, property.value._vec2);
+        break;
+      case PropertyType::VEC3:
+        glShader.SetUniform(location, property.value._vec3);
+        break;
+      case PropertyType::VEC4:
+        glShader.SetUniform(location, property.value._vec4);
+        break;
+      case PropertyType::MAT4X4:
+        glShader.SetUniform(location, property.value._mat4x4);
+        break;
+      case PropertyType::TEXTURE:
+        glShader.SetTexture(property.texUnit, location,
+                            property.texture.get());
+        break;
+      case PropertyType::FLOAT_ARRAY:
+        glShader.SetUniform(location, property.array.data(),
+                            ArrayLength(property));
+        break;
+      case PropertyType::VEC2_ARRAY:
+        glShader.SetUniform(location,
+                            (const glm::vec2 *)property.array.data(),
+                            ArrayLength(property));
+        break;
+      case PropertyType::VEC3_ARRAY:
+        glShader.SetUniform(location,
+                            (const glm::vec3 *)property.array.data(),
+                            ArrayLength(property));
+        break;
+      case PropertyType::VEC4_ARRAY:
+        glShader.SetUniform(location,
+                            (const glm::vec4 *)property.array.data(),
+                            ArrayLength(property));
+        break;
+      case PropertyType::MAT4X4_ARRAY:
+        glShader.SetUniform(location,
+                            (const glm::mat4x4 *)property.array.data(),
+                            ArrayLength(property));
+        break;
+      default:
+        break;
+    }
+  }
+#elif defined(_DIRECTX)
   for (auto it = properties.begin(); it != properties.end(); it++) {
     switch (it->second.type) {
       case PropertyType::BOOL:
-        shader->SetBool(it->first, it->second.value._bool);
+        target.SetBool(it->first, it->second.value._bool);
         break;
       case PropertyType::INT:
-        shader->SetInt(it->first, it->second.value._int);
+        target.SetInt(it->first, it->second.value._int);
         break;
       case PropertyType::FLOAT:
-        shader->SetFloat(it->first, it->second.value._float);
+        target.SetFloat(it->first, it->second.value._float);
         break;
       case PropertyType::VEC2:
-        shader->SetVec2(it->first, it->second.value._vec2);
+        target.SetVec2(it->first, it->second.value._vec2);
         break;
       case PropertyType::VEC3:
-        shader->SetVec3(it->first, it->second.value._vec3);
+        target.SetVec3(it->first, it->second.value._vec3);
         break;
       case PropertyType::VEC4:
-        shader->SetVec4(it->first, it->second.value._vec4);
+        target.SetVec4(it->first, it->second.value._vec4);
         break;
       case PropertyType::MAT4X4:
-        shader->SetMat4(it->first, it->second.value._mat4x4);
+        target.SetMat4(it->first, it->second.value._mat4x4);
         break;
       case PropertyType::TEXTURE:
-        if (it->second.texUnitHint >= 0) {
-          shader->SetTexture(it->second.texUnitHint, it->first,
-                             it->second.texture.get());
-        } else {
-          shader->SetTexture(textureUnit, it->first, it->second.texture.get());
-          textureUnit++;
+        target.SetTexture(it->second.texUnit, it->first,
+                          it->second.texture.get());
+        break;
+      case PropertyType::FLOAT_ARRAY:
+      case PropertyType::VEC2_ARRAY:
+      case PropertyType::VEC3_ARRAY:
+      case PropertyType::VEC4_ARRAY: {
+        // Elements of HLSL arrays each start on a 16 byte boundary.
+        size_t floats = ArrayElementFloats(it->second.type);
+        std::vector<glm::vec4> padded(ArrayLength(it->second), glm::vec4(0));
+        for (size_t i = 0; i < padded.size(); i++) {
+          memcpy(&padded[i], &it->second.array[i * floats],
+                 floats * sizeof(float));
         }
+        target.SetData(it->first, padded.data(),
+                       padded.size() * sizeof(glm::vec4));
+        break;
+      }
+      case PropertyType::MAT4X4_ARRAY:
+        target.SetData(it->first, (void *)it->second.array.data(),
+                       it->second.array.size() * sizeof(float));
         break;
       default:
         break;
     }
   }
+#endif
+}
+
+#if defined(_OPENGL)
+void dg::Material::BuildPropertyBlock(
+    std::shared_ptr<const OpenGLShader::UniformBlock> layout) const {
+  blockLayout = layout;
+  blockData.assign(layout->size, 0);
+  for (auto it = properties.begin(); it != properties.end(); it++) {
+    WriteBlockProperty(it->second);
+  }
+  dirtyBegin = 0;
+  dirtyEnd = blockData.size();
+
+  if (blockBuffer == nullptr) {
+    blockBuffer = std::make_unique<UniformBuffer>();
+  }
+  blockBuffer->Allocate(blockData.size());
+}
+
+void dg::Material::WriteBlockProperty(const Property& property) const {
+  auto offset = blockLayout->offsets.find(property.nameHash);
+  property.inBlock = offset != blockLayout->offsets.end() &&
+                     property.type != PropertyType::NONE &&
+                     property.type != PropertyType::TEXTURE;
+  if (!property.inBlock) {
+    return;
+  }
+
+  // Array elements are each copied to the array's stride in std140.
+  size_t elementFloats = ArrayElementFloats(property.type);
+  if (elementFloats > 0) {
+    auto stride = blockLayout->arrayStrides.find(property.nameHash);
+    if (stride == blockLayout->arrayStrides.end()) {
+      property.inBlock = false;
+      return;
+    }
+    size_t begin = (size_t)offset->second;
+    size_t elementSize = elementFloats * sizeof(float);
+    size_t end = begin;
+    for (GLsizei i = 0; i < ArrayLength(property); i++) {
+      size_t elementOffset = begin + i * (size_t)stride->second;
+      if (elementOffset + elementSize > blockData.size()) {
+        break;
+      }
+      memcpy(blockData.data() + elementOffset,
+             &property.array[i * elementFloats], elementSize);
+      end = elementOffset + elementSize;
+    }
+    if (end > begin) {
+      MarkBlockDirty(begin, end);
+    }
+    return;
+  }
+
+  // Scalars and vectors are tightly packed in std140, and a mat4's columns
+  // are 16 bytes apart, so every type but bool is copied as it is.
+  const void *value = &property.value;
+  size_t size = 0;
+  int32_t boolValue = property.value._bool ? 1 : 0;
+  switch (property.type) {
+    case PropertyType::BOOL:
+      value = &boolValue;
+      size = sizeof(boolValue);
+      break;
+    case PropertyType::INT:
+      size = sizeof(int32_t);
+      break;
+    case PropertyType::FLOAT:
+      size = sizeof(float);
+      break;
+    case PropertyType::VEC2:
+      size = sizeof(glm::vec2);
+      break;
+    case PropertyType::VEC3:
+      size = sizeof(glm::vec3);
+      break;
+    case PropertyType::VEC4:
+      size = sizeof(glm::vec4);
+      break;
+    case PropertyType::MAT4X4:
+      size = sizeof(glm::mat4x4);
+      break;
+    default:
+      break;
+  }
+
+  size_t begin = (size_t)offset->second;
+  assert(begin + size <= blockData.size());
+  memcpy(blockData.data() + begin, value, size);
+  MarkBlockDirty(begin, begin + size);
+}
+
+void dg::Material::MarkBlockDirty(size_t begin, size_t end) const {
+  if (dirtyBegin >= dirtyEnd) {
+    dirtyBegin = begin;
+    dirtyEnd = end;
+  } else {
+    dirtyBegin = std::min(dirtyBegin, begin);
+    dirtyEnd = std::max(dirtyEnd, end);
+  }
 }
+
+void dg::Material::BindPropertyBlock() const {
+  if (dirtyBegin < dirtyEnd) {
+    blockBuffer->Update(dirtyBegin, blockData.data() + dirtyBegin,
+                        dirtyEnd - dirtyBegin);
+    dirtyBegin = dirtyEnd = 0;
+  }
+  blockBuffer->Bind(blockLayout->binding);
+}
+#endif
@@ -184,6 +184,7 @@ void dg::Mesh::AddTriangle(const Triangle &triangle) {
     if (pair == vertexMap.end()) {
       if (!!(attributes & Flag::POSITION)) {
         vertexPositions.push_back(v[i]->data.position);
+        bounds.Encapsulate(v[i]->data.position);
       }
       if (!!(attributes & Flag::NORMAL)) {
         vertexNormals.push_back(v[i]->data.normal);
@@ -219,7 +220,19 @@ const dg::Vertex dg::Mesh::GetVertex(int i) const {
   return vertex;
 }
 
-void dg::Mesh::Draw() const {
+const std::vector<glm::vec3> &dg::Mesh::GetPositions() const {
+  return vertexPositions;
+}
+
+const std::vector<unsigned int> &dg::Mesh::GetIndices() const {
+  return indices;
+}
+
+const dg::AABB &dg::Mesh::GetBounds() const {
+  return bounds;
+}
+
+void dg::Mesh::Draw(unsigned int instances) const {
   Graphics::Instance->ApplyCurrentRasterizerState();
 }
 
@@ -865,8 +878,8 @@ void dg::OpenGLMesh::FinishBuilding() {
   vertexMap.clear();
 }
 
-void dg::OpenGLMesh::Draw() const {
-  Mesh::Draw();
+void dg::OpenGLMesh::Draw(unsigned int instances) const {
+  Mesh::Draw(instances);
 
   glBindVertexArray(VAO);
   if (lastDrawnMesh != this) {
@@ -879,7 +892,12 @@ void dg::OpenGLMesh::Draw() const {
     }
     lastDrawnMesh = (Mesh*)this; // Although we're const, we'll allow this.
   }
-  glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, (void*)0);
+  if (instances == 1) {
+    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, (void*)0);
+  } else {
+    glDrawElementsInstanced(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT,
+                            (void*)0, instances);
+  }
 }
 
 bool dg::OpenGLMesh::IsDrawable() const {
@@ -943,11 +961,11 @@ void dg::DirectXMesh::FinishBuilding() {
   vertexMap.clear();
 }
 
-void dg::DirectXMesh::Draw() const {
+void dg::DirectXMesh::Draw(unsigned int instances) const {
   assert(vertexBuffer != nullptr);
   assert(indexBuffer != nullptr);
 
-  Mesh::Draw();
+  Mesh::Draw(instances);
 
   UINT stride = sizeof(Vertex::Data);
   UINT offset = 0;
@@ -956,7 +974,13 @@ void dg::DirectXMesh::Draw() const {
   Graphics::Instance->context->IASetIndexBuffer(
     indexBuffer, DXGI_FORMAT_R32_UINT, 0);
 
-  Graphics::Instance->context->DrawIndexed((unsigned int)indices.size(), 0, 0);
+  if (instances == 1) {
+    Graphics::Instance->context->DrawIndexed(
+        (unsigned int)indices.size(), 0, 0);
+  } else {
+    Graphics::Instance->context->DrawIndexedInstanced(
+        (unsigned int)indices.size(), instances, 0, 0, 0);
+  }
 }
 
 bool dg::DirectXMesh::IsDrawable() const {
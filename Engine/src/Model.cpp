@@ -18,6 +18,35 @@ dg::Model::Model(Model& other) : SceneObject(other) {
   this->mesh = other.mesh;
   this->material = other.material;
   this->layer = other.layer;
+  this->isStatic = other.isStatic;
+  this->occluder = other.occluder;
+}
+
+dg::AABB dg::Model::SceneBounds() const {
+  if (mesh == nullptr) {
+    return AABB::Empty();
+  }
+  return mesh->GetBounds().Transformed(ModelMatrix());
+}
+
+void dg::Model::SetCachedMatrices(const glm::mat4x4 *modelMatrix,
+                                  const glm::mat4x4 *normalMatrix) {
+  cachedModelMatrix = modelMatrix;
+  cachedNormalMatrix = normalMatrix;
+}
+
+glm::mat4x4 dg::Model::ModelMatrix() const {
+  if (cachedModelMatrix != nullptr) {
+    return *cachedModelMatrix;
+  }
+  return CachedSceneSpace().ToMat4();
+}
+
+glm::mat4x4 dg::Model::NormalMatrix() const {
+  if (cachedNormalMatrix != nullptr) {
+    return *cachedNormalMatrix;
+  }
+  return CachedSceneSpace().ToNormalMat4();
 }
 
 void dg::Model::Draw(glm::mat4x4 view, glm::mat4x4 projection,
@@ -33,7 +62,7 @@ void dg::Model::Draw(const DrawContext &context, Material *material) const {
     material = this->material.get();
   }
 
-  glm::mat4x4 xfMat = CachedSceneSpace().ToMat4();
+  glm::mat4x4 xfMat = ModelMatrix();
 
   if (material->rasterizerOverride.HasDeclaredAttributes()) {
     Graphics::Instance->PushRasterizerState(material->rasterizerOverride);
@@ -43,9 +72,23 @@ void dg::Model::Draw(const DrawContext &context, Material *material) const {
   material->Use();
 #endif
 
+#if defined(_OPENGL)
+  // The view block is only written when the view changes, and the object
+  // block is written into a ring buffer and bound by offset. Scene
+  // subrenders always give the camera position, so the view is only
+  // inverted here for draws outside a scene.
+  glm::vec3 cameraPos = context.cameraPos != nullptr
+                            ? *context.cameraPos
+                            : glm::vec3(glm::inverse(context.view)[3]);
+  Graphics::Instance->SetViewUniforms(context.view, context.projection,
+                                      cameraPos);
+  Graphics::Instance->SetObjectUniforms(
+      xfMat, NormalMatrix(), context.projection * context.view * xfMat);
+#elif defined(_DIRECTX)
   if (context.cameraPos != nullptr) {
     material->SendCameraPosition(*context.cameraPos);
   }
+#endif
 
   if (context.lights != nullptr) {
     material->SendLights(*context.lights);
@@ -55,18 +98,42 @@ void dg::Model::Draw(const DrawContext &context, Material *material) const {
     material->SendShadowMap(context.shadowMap);
   }
 
+  if (context.lightClusters != nullptr) {
+    material->SendLightClusters(*context.lightClusters);
+  }
+
+  if (context.shadowCascades != nullptr) {
+    material->SendShadowCascades(*context.shadowCascades);
+  }
+
+  if (context.pointShadowMaps != nullptr) {
+    material->SendPointShadowMaps(*context.pointShadowMaps);
+  }
+
+#if defined(_DIRECTX)
   material->SendBufferDimensions(Graphics::Instance->GetViewportDimensions());
-  material->SendMatrixNormal(glm::transpose(glm::inverse(xfMat)));
+  material->SendMatrixNormal(NormalMatrix());
   material->SendMatrixM(xfMat);
   material->SendMatrixV(context.view);
   material->SendMatrixP(context.projection);
   material->SendMatrixMVP(context.projection * context.view * xfMat);
 
-#if defined(_DIRECTX)
   material->Use();
 #endif
 
+#if defined(_OPENGL)
+  if (context.stereo) {
+    material->SendStereo(true, context.stereoReprojections);
+    Graphics::Instance->SetClipPlaneEnabled(0, true);
+    mesh->Draw(2);
+    Graphics::Instance->SetClipPlaneEnabled(0, false);
+    material->SendStereo(false);
+  } else {
+    mesh->Draw();
+  }
+#elif defined(_DIRECTX)
   mesh->Draw();
+#endif
 
   if (material->rasterizerOverride.HasDeclaredAttributes()) {
     Graphics::Instance->PopRasterizerState();
@@ -0,0 +1,397 @@
+//
+//  OcclusionCuller.cpp
+//
+
+#include "dg/OcclusionCuller.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include "dg/FrameAllocator.h"
+#include "dg/Mesh.h"
+
+#if defined(__SSE__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define DG_OCCLUSION_SIMD
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define DG_OCCLUSION_SIMD
+#endif
+
+#if defined(DG_OCCLUSION_SIMD)
+namespace {
+
+  // Four floats, one for each of four adjacent pixels in a row.
+#if defined(__aarch64__) || defined(_M_ARM64)
+  typedef float32x4_t float4;
+  inline float4 Load(const float *f) { return vld1q_f32(f); }
+  inline void Store(float *f, float4 v) { vst1q_f32(f, v); }
+  inline float4 Splat(float f) { return vdupq_n_f32(f); }
+  inline float4 Set(float a, float b, float c, float d) {
+    float f[4] = {a, b, c, d};
+    return vld1q_f32(f);
+  }
+  inline float4 Add(float4 a, float4 b) { return vaddq_f32(a, b); }
+  inline float4 Mul(float4 a, float4 b) { return vmulq_f32(a, b); }
+  inline float4 Div(float4 a, float4 b) { return vdivq_f32(a, b); }
+  inline float4 Min(float4 a, float4 b) { return vminq_f32(a, b); }
+  inline float4 Max(float4 a, float4 b) { return vmaxq_f32(a, b); }
+
+  // Lanes where every one of a, b and c is at least zero.
+  typedef uint32x4_t mask4;
+  inline mask4 AllNonNegative(float4 a, float4 b, float4 c) {
+    float32x4_t zero = vdupq_n_f32(0);
+    return vandq_u32(vandq_u32(vcgeq_f32(a, zero), vcgeq_f32(b, zero)),
+                     vcgeq_f32(c, zero));
+  }
+  inline bool Any(mask4 m) { return vmaxvq_u32(m) != 0; }
+  inline float4 Select(mask4 m, float4 a, float4 b) {
+    return vbslq_f32(m, a, b);
+  }
+#else
+  typedef __m128 float4;
+  inline float4 Load(const float *f) { return _mm_loadu_ps(f); }
+  inline void Store(float *f, float4 v) { _mm_storeu_ps(f, v); }
+  inline float4 Splat(float f) { return _mm_set1_ps(f); }
+  inline float4 Set(float a, float b, float c, float d) {
+    return _mm_setr_ps(a, b, c, d);
+  }
+  inline float4 Add(float4 a, float4 b) { return _mm_add_ps(a, b); }
+  inline float4 Mul(float4 a, float4 b) { return _mm_mul_ps(a, b); }
+  inline float4 Div(float4 a, float4 b) { return _mm_div_ps(a, b); }
+  inline float4 Min(float4 a, float4 b) { return _mm_min_ps(a, b); }
+  inline float4 Max(float4 a, float4 b) { return _mm_max_ps(a, b); }
+
+  // Lanes where every one of a, b and c is at least zero.
+  typedef __m128 mask4;
+  inline mask4 AllNonNegative(float4 a, float4 b, float4 c) {
+    __m128 zero = _mm_setzero_ps();
+    return _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(a, zero),
+                                 _mm_cmpge_ps(b, zero)),
+                      _mm_cmpge_ps(c, zero));
+  }
+  inline bool Any(mask4 m) { return _mm_movemask_ps(m) != 0; }
+  inline float4 Select(mask4 m, float4 a, float4 b) {
+    return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+  }
+#endif
+
+} // namespace
+#endif
+
+const unsigned int dg::OcclusionCuller::TILE_SIZE;
+
+void dg::OcclusionCuller::Begin(const glm::mat4x4 &viewProjection) {
+  assert((options.width & (options.width - 1)) == 0);
+  assert((options.height & (options.height - 1)) == 0);
+
+  this->viewProjection = viewProjection;
+  width = options.width;
+  height = options.height;
+  tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+  tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+
+  triangles.clear();
+  tileBins.resize(tilesX * tilesY);
+  for (auto &bin : tileBins) {
+    bin.clear();
+  }
+
+  // Allocate the pyramid, down to a single texel.
+  unsigned int levelCount = 1;
+  while ((width >> (levelCount - 1)) > 1 ||
+         (height >> (levelCount - 1)) > 1) {
+    levelCount++;
+  }
+  levels.resize(levelCount);
+  for (unsigned int i = 0; i < levelCount; i++) {
+    unsigned int levelWidth = std::max(1u, width >> i);
+    unsigned int levelHeight = std::max(1u, height >> i);
+    levels[i].assign(levelWidth * levelHeight, 1.f);
+  }
+}
+
+void dg::OcclusionCuller::RasterizeOccluder(const Mesh &mesh,
+                                            const glm::mat4x4 &modelMatrix) {
+  const std::vector<glm::vec3> &positions = mesh.GetPositions();
+  const std::vector<unsigned int> &indices = mesh.GetIndices();
+  glm::mat4x4 mvp = viewProjection * modelMatrix;
+
+  FrameVector<glm::vec4> clipPositions(positions.size());
+  for (size_t i = 0; i < positions.size(); i++) {
+    clipPositions[i] = mvp * glm::vec4(positions[i], 1);
+  }
+
+  for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+    glm::vec4 clip[3] = {
+        clipPositions[indices[i]],
+        clipPositions[indices[i + 1]],
+        clipPositions[indices[i + 2]],
+    };
+
+    // Clip against the near plane (z >= -w), which splits the triangle into
+    // up to two. The other planes are handled by clamping to the screen.
+    float distances[3];
+    int inside = 0;
+    for (int v = 0; v < 3; v++) {
+      distances[v] = clip[v].z + clip[v].w;
+      if (distances[v] >= 0) {
+        inside++;
+      }
+    }
+    if (inside == 3) {
+      SetUpTriangle(clip);
+      continue;
+    } else if (inside == 0) {
+      continue;
+    }
+
+    glm::vec4 polygon[4];
+    int polygonSize = 0;
+    for (int v = 0; v < 3; v++) {
+      int next = (v + 1) % 3;
+      if (distances[v] >= 0) {
+        polygon[polygonSize++] = clip[v];
+      }
+      if ((distances[v] >= 0) != (distances[next] >= 0)) {
+        float t = distances[v] / (distances[v] - distances[next]);
+        polygon[polygonSize++] = clip[v] + (clip[next] - clip[v]) * t;
+      }
+    }
+    for (int v = 1; v + 1 < polygonSize; v++) {
+      glm::vec4 fan[3] = { polygon[0], polygon[v], polygon[v + 1] };
+      SetUpTriangle(fan);
+    }
+  }
+}
+
+void dg::OcclusionCuller::SetUpTriangle(const glm::vec4 (&clip)[3]) {
+  ScreenTriangle triangle;
+  glm::vec2 min = glm::vec2(width, height);
+  glm::vec2 max = glm::vec2(0);
+  for (int v = 0; v < 3; v++) {
+    glm::vec3 ndc = glm::vec3(clip[v]) / clip[v].w;
+    glm::vec3 window = glm::vec3(
+        (ndc.x * 0.5f + 0.5f) * width,
+        (ndc.y * 0.5f + 0.5f) * height,
+        ndc.z * 0.5f + 0.5f);
+    triangle.vertices[v] = window;
+    min = glm::min(min, glm::vec2(window));
+    max = glm::max(max, glm::vec2(window));
+  }
+
+  // Both faces of occluders are drawn, so make every triangle
+  // counter-clockwise.
+  glm::vec3 *v = triangle.vertices;
+  float area = (v[1].x - v[0].x) * (v[2].y - v[0].y) -
+               (v[1].y - v[0].y) * (v[2].x - v[0].x);
+  if (area == 0) {
+    return;
+  } else if (area < 0) {
+    std::swap(v[1], v[2]);
+  }
+
+  // Pixels covered are those whose centers are inside the triangle.
+  triangle.min = glm::ivec2(
+      std::max(0, (int)std::floor(min.x)),
+      std::max(0, (int)std::floor(min.y)));
+  triangle.max = glm::ivec2(
+      std::min((int)width - 1, (int)std::ceil(max.x)),
+      std::min((int)height - 1, (int)std::ceil(max.y)));
+  if (triangle.min.x > triangle.max.x || triangle.min.y > triangle.max.y) {
+    return;
+  }
+
+  unsigned int index = (unsigned int)triangles.size();
+  triangles.push_back(triangle);
+  for (int y = triangle.min.y / TILE_SIZE; y <= triangle.max.y / TILE_SIZE;
+       y++) {
+    for (int x = triangle.min.x / TILE_SIZE;
+         x <= triangle.max.x / TILE_SIZE; x++) {
+      tileBins[y * tilesX + x].push_back(index);
+    }
+  }
+}
+
+void dg::OcclusionCuller::Finish() {
+  // Tiles write to separate parts of the depth buffer, so they don't depend
+  // on each other.
+  for (unsigned int y = 0; y < tilesY; y++) {
+    for (unsigned int x = 0; x < tilesX; x++) {
+      RasterizeTile(x, y);
+    }
+  }
+
+  // Each texel of a level is the farthest depth of the texels it covers in
+  // the level below.
+  for (size_t i = 1; i < levels.size(); i++) {
+    unsigned int belowWidth = std::max(1u, width >> (i - 1));
+    unsigned int belowHeight = std::max(1u, height >> (i - 1));
+    unsigned int levelWidth = std::max(1u, width >> i);
+    unsigned int levelHeight = std::max(1u, height >> i);
+    const std::vector<float> &below = levels[i - 1];
+    std::vector<float> &level = levels[i];
+    for (unsigned int y = 0; y < levelHeight; y++) {
+      unsigned int y0 = std::min(y * 2, belowHeight - 1);
+      unsigned int y1 = std::min(y * 2 + 1, belowHeight - 1);
+      for (unsigned int x = 0; x < levelWidth; x++) {
+        unsigned int x0 = std::min(x * 2, belowWidth - 1);
+        unsigned int x1 = std::min(x * 2 + 1, belowWidth - 1);
+        level[y * levelWidth + x] =
+            std::max(std::max(below[y0 * belowWidth + x0],
+                              below[y0 * belowWidth + x1]),
+                     std::max(below[y1 * belowWidth + x0],
+                              below[y1 * belowWidth + x1]));
+      }
+    }
+  }
+}
+
+void dg::OcclusionCuller::RasterizeTile(unsigned int tileX,
+                                        unsigned int tileY) {
+  int tileMinX = tileX * TILE_SIZE;
+  int tileMinY = tileY * TILE_SIZE;
+  int tileMaxX = std::min(tileMinX + (int)TILE_SIZE, (int)width) - 1;
+  int tileMaxY = std::min(tileMinY + (int)TILE_SIZE, (int)height) - 1;
+  std::vector<float> &depth = levels[0];
+
+  for (unsigned int index : tileBins[tileY * tilesX + tileX]) {
+    const ScreenTriangle &triangle = triangles[index];
+    const glm::vec3 *v = triangle.vertices;
+    int minX = std::max(triangle.min.x, tileMinX);
+    int minY = std::max(triangle.min.y, tileMinY);
+    int maxX = std::min(triangle.max.x, tileMaxX);
+    int maxY = std::min(triangle.max.y, tileMaxY);
+
+    // Edge functions, each positive inside the triangle and proportional to
+    // the barycentric weight of the opposite vertex. Each steps by a
+    // constant amount per pixel in x.
+    float area = (v[1].x - v[0].x) * (v[2].y - v[0].y) -
+                 (v[1].y - v[0].y) * (v[2].x - v[0].x);
+    float stepX[3];
+    for (int e = 0; e < 3; e++) {
+      const glm::vec3 &a = v[(e + 1) % 3];
+      const glm::vec3 &b = v[(e + 2) % 3];
+      stepX[e] = a.y - b.y;
+    }
+#if defined(DG_OCCLUSION_SIMD)
+    float4 z0 = Splat(v[0].z);
+    float4 z1 = Splat(v[1].z);
+    float4 z2 = Splat(v[2].z);
+    float4 areas = Splat(area);
+#endif
+
+    for (int y = minY; y <= maxY; y++) {
+      glm::vec2 p = glm::vec2(minX + 0.5f, y + 0.5f);
+      float edges[3];
+      for (int e = 0; e < 3; e++) {
+        const glm::vec3 &a = v[(e + 1) % 3];
+        const glm::vec3 &b = v[(e + 2) % 3];
+        edges[e] = (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x);
+      }
+      float *row = &depth[y * width];
+      int x = minX;
+#if defined(DG_OCCLUSION_SIMD)
+      // Four pixels at a time, keeping the nearer depth only in the lanes
+      // inside the triangle.
+      float4 edge0 = Set(edges[0], edges[0] + stepX[0],
+                         edges[0] + stepX[0] * 2, edges[0] + stepX[0] * 3);
+      float4 edge1 = Set(edges[1], edges[1] + stepX[1],
+                         edges[1] + stepX[1] * 2, edges[1] + stepX[1] * 3);
+      float4 edge2 = Set(edges[2], edges[2] + stepX[2],
+                         edges[2] + stepX[2] * 2, edges[2] + stepX[2] * 3);
+      float4 step0 = Splat(stepX[0] * 4);
+      float4 step1 = Splat(stepX[1] * 4);
+      float4 step2 = Splat(stepX[2] * 4);
+      for (; x + 3 <= maxX; x += 4) {
+        mask4 inside = AllNonNegative(edge0, edge1, edge2);
+        if (Any(inside)) {
+          float4 z = Div(Add(Add(Mul(edge0, z0), Mul(edge1, z1)),
+                             Mul(edge2, z2)), areas);
+          float4 old = Load(row + x);
+          float4 nearer = Min(old, Max(z, Splat(0)));
+          Store(row + x, Select(inside, nearer, old));
+        }
+        edge0 = Add(edge0, step0);
+        edge1 = Add(edge1, step1);
+        edge2 = Add(edge2, step2);
+      }
+      for (int e = 0; e < 3; e++) {
+        edges[e] += stepX[e] * (x - minX);
+      }
+#endif
+      for (; x <= maxX; x++) {
+        if (edges[0] >= 0 && edges[1] >= 0 && edges[2] >= 0) {
+          float z = (edges[0] * v[0].z + edges[1] * v[1].z +
+                     edges[2] * v[2].z) / area;
+          row[x] = std::min(row[x], std::max(z, 0.f));
+        }
+        edges[0] += stepX[0];
+        edges[1] += stepX[1];
+        edges[2] += stepX[2];
+      }
+    }
+  }
+}
+
+bool dg::OcclusionCuller::IsVisible(const AABB &bounds) const {
+  if (bounds.IsEmpty()) {
+    return true;
+  }
+
+  // Screen-space rectangle and nearest depth of the box.
+  glm::vec2 min = glm::vec2(std::numeric_limits<float>::max());
+  glm::vec2 max = glm::vec2(-std::numeric_limits<float>::max());
+  float nearestDepth = 1;
+  for (int corner = 0; corner < 8; corner++) {
+    glm::vec4 clip = viewProjection * glm::vec4(
+        (corner & 1) ? bounds.max.x : bounds.min.x,
+        (corner & 2) ? bounds.max.y : bounds.min.y,
+        (corner & 4) ? bounds.max.z : bounds.min.z, 1);
+
+    // Boxes crossing the near plane are too close to cull.
+    if (clip.z < -clip.w) {
+      return true;
+    }
+
+    glm::vec3 ndc = glm::vec3(clip) / clip.w;
+    min = glm::min(min, glm::vec2(ndc));
+    max = glm::max(max, glm::vec2(ndc));
+    nearestDepth = std::min(nearestDepth, ndc.z * 0.5f + 0.5f);
+  }
+
+  int minX = std::max(0, (int)std::floor((min.x * 0.5f + 0.5f) * width));
+  int minY = std::max(0, (int)std::floor((min.y * 0.5f + 0.5f) * height));
+  int maxX = std::min((int)width - 1,
+                      (int)std::floor((max.x * 0.5f + 0.5f) * width));
+  int maxY = std::min((int)height - 1,
+                      (int)std::floor((max.y * 0.5f + 0.5f) * height));
+  if (minX > maxX || minY > maxY) {
+    // Entirely off screen.
+    return false;
+  }
+
+  // Use the finest level at which the rectangle covers at most 4x4 texels.
+  unsigned int level = 0;
+  while (level + 1 < levels.size() &&
+         (((maxX >> level) - (minX >> level)) > 3 ||
+          ((maxY >> level) - (minY >> level)) > 3)) {
+    level++;
+  }
+
+  unsigned int levelWidth = std::max(1u, width >> level);
+  const std::vector<float> &depths = levels[level];
+  for (int y = minY >> level; y <= (maxY >> level); y++) {
+    for (int x = minX >> level; x <= (maxX >> level); x++) {
+      if (nearestDepth <= depths[y * levelWidth + x]) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+unsigned int dg::OcclusionCuller::GetTriangleCount() const {
+  return (unsigned int)triangles.size();
+}
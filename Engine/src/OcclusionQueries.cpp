@@ -0,0 +1,181 @@
+//
+//  OcclusionQueries.cpp
+//
+
+#include "dg/OcclusionQueries.h"
+#include <cassert>
+#include <glm/gtc/matrix_transform.hpp>
+#include "dg/Graphics.h"
+#include "dg/Mesh.h"
+#include "dg/Model.h"
+#include "dg/materials/UVMaterial.h"
+
+// Only in OpenGL 4.3 and GL_ARB_ES3_compatibility, which GLAD wasn't
+// generated with.
+#ifndef GL_ANY_SAMPLES_PASSED_CONSERVATIVE
+#define GL_ANY_SAMPLES_PASSED_CONSERVATIVE 0x8D6A
+#endif
+
+dg::OcclusionQueries::OcclusionQueries() {}
+
+dg::OcclusionQueries::~OcclusionQueries() {
+#if defined(_OPENGL)
+  for (auto &view : views) {
+    for (auto &pair : view.second) {
+      if (pair.second.handle != 0) {
+        freeHandles.push_back(pair.second.handle);
+      }
+    }
+  }
+  if (!freeHandles.empty()) {
+    glDeleteQueries((GLsizei)freeHandles.size(), freeHandles.data());
+  }
+#endif
+}
+
+void dg::OcclusionQueries::BeginView(const void *view) {
+#if defined(_OPENGL)
+  assert(currentView == nullptr);
+  currentView = &views[view];
+
+  if (boundsMaterial == nullptr) {
+    // The conservative query may count samples that wouldn't quite pass,
+    // but is cheaper to evaluate.
+    if (Graphics::Instance->SupportsVersion(4, 3) ||
+        Graphics::Instance->SupportsExtension("GL_ARB_ES3_compatibility")) {
+      target = GL_ANY_SAMPLES_PASSED_CONSERVATIVE;
+    }
+
+    boundsMaterial = std::make_shared<UVMaterial>();
+    boundsMaterial->rasterizerOverride.SetWriteDepth(false);
+    boundsMaterial->rasterizerOverride.SetCullMode(
+        RasterizerState::CullMode::OFF);
+  }
+#endif
+}
+
+bool dg::OcclusionQueries::IsQueried(const Model &model) const {
+  return model.mesh != nullptr &&
+         model.mesh->GetIndices().size() / 3 >= options.minTriangles;
+}
+
+void dg::OcclusionQueries::Draw(const Model &model,
+                                const glm::mat4x4 &viewProjection,
+                                const std::function<void()> &draw) {
+#if defined(_OPENGL)
+  assert(currentView != nullptr);
+  if (!IsQueried(model)) {
+    draw();
+    return;
+  }
+
+  Query &query = (*currentView)[&model];
+  query.drawn = true;
+
+  if (query.pending) {
+    GLuint available = GL_FALSE;
+    glGetQueryObjectuiv(query.handle, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available) {
+      GLuint passed = GL_FALSE;
+      glGetQueryObjectuiv(query.handle, GL_QUERY_RESULT, &passed);
+      query.visible = passed != GL_FALSE;
+      query.pending = false;
+    }
+  }
+
+  // A box crossing the near plane is clipped, so querying it could hide a
+  // model that surrounds the camera.
+  AABB bounds = model.SceneBounds();
+  if (bounds.IsEmpty()) {
+    draw();
+    return;
+  }
+  for (int corner = 0; corner < 8; corner++) {
+    glm::vec4 clip = viewProjection * glm::vec4(
+        (corner & 1) ? bounds.max.x : bounds.min.x,
+        (corner & 2) ? bounds.max.y : bounds.min.y,
+        (corner & 4) ? bounds.max.z : bounds.min.z, 1);
+    if (clip.z < -clip.w) {
+      query.visible = true;
+      draw();
+      return;
+    }
+  }
+
+  if (query.pending) {
+    // The last query is still in flight, so don't wait on it. If the model
+    // was hidden before it, let the GPU skip the model if the query finishes
+    // in time.
+    if (query.visible) {
+      draw();
+    } else {
+      glBeginConditionalRender(query.handle, GL_QUERY_NO_WAIT);
+      draw();
+      glEndConditionalRender();
+    }
+    return;
+  }
+
+  if (query.handle == 0) {
+    if (freeHandles.empty()) {
+      glGenQueries(1, &query.handle);
+    } else {
+      query.handle = freeHandles.back();
+      freeHandles.pop_back();
+    }
+  }
+
+  if (query.visible) {
+    // The model itself is a tighter occludee than its bounds.
+    glBeginQuery(target, query.handle);
+    draw();
+    glEndQuery(target);
+  } else {
+    glBeginQuery(target, query.handle);
+    DrawBounds(bounds, viewProjection);
+    glEndQuery(target);
+    glBeginConditionalRender(query.handle, GL_QUERY_NO_WAIT);
+    draw();
+    glEndConditionalRender();
+  }
+  query.pending = true;
+#else
+  draw();
+#endif
+}
+
+void dg::OcclusionQueries::EndView() {
+#if defined(_OPENGL)
+  assert(currentView != nullptr);
+  for (auto it = currentView->begin(); it != currentView->end();) {
+    if (it->second.drawn) {
+      it->second.drawn = false;
+      it++;
+    } else {
+      if (it->second.handle != 0) {
+        freeHandles.push_back(it->second.handle);
+      }
+      it = currentView->erase(it);
+    }
+  }
+  currentView = nullptr;
+#endif
+}
+
+#if defined(_OPENGL)
+void dg::OcclusionQueries::DrawBounds(const AABB &bounds,
+                                      const glm::mat4x4 &viewProjection) {
+  glm::mat4x4 boxMatrix =
+      glm::translate(glm::mat4x4(1), bounds.Center()) *
+      glm::scale(glm::mat4x4(1), bounds.Extents() * 2.f);
+
+  Graphics::Instance->PushRasterizerState(boundsMaterial->rasterizerOverride);
+  glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+  boundsMaterial->Use();
+  Graphics::Instance->SetObjectUniforms(boxMatrix, glm::mat4x4(1),
+                                        viewProjection * boxMatrix);
+  Mesh::Cube->Draw();
+  glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+  Graphics::Instance->PopRasterizerState();
+}
+#endif
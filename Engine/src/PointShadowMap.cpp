@@ -0,0 +1,86 @@
+//
+//  PointShadowMap.cpp
+//
+
+#include "dg/PointShadowMap.h"
+#include <glm/gtc/matrix_transform.hpp>
+
+const unsigned int dg::PointShadowMap::MAX_SHADOWED_LIGHTS;
+const int dg::PointShadowMap::FACE_COUNT;
+const float dg::PointShadowMap::NEAR_CLIP = 0.05f;
+
+dg::PointShadowMap::PointShadowMap(unsigned int resolution) {
+  FrameBuffer::Options options;
+  options.width = resolution;
+  options.height = resolution;
+  options.type = TextureType::CUBEMAP;
+  options.depthReadable = true;
+  options.hasColor = false;
+  options.hasStencil = false;
+  framebuffer = FrameBuffer::Create(options);
+}
+
+void dg::PointShadowMap::SetOrigin(glm::vec3 position, float farClip) {
+  if (position == this->position && farClip == this->farClip) {
+    return;
+  }
+  this->position = position;
+  this->farClip = farClip;
+  for (Face &face : faces) {
+    face.valid = false;
+  }
+}
+
+glm::vec3 dg::PointShadowMap::GetPosition() const {
+  return position;
+}
+
+float dg::PointShadowMap::GetFarClip() const {
+  return farClip;
+}
+
+unsigned int dg::PointShadowMap::GetResolution() const {
+  return framebuffer->GetWidth();
+}
+
+glm::mat4x4 dg::PointShadowMap::GetViewMatrix(TextureFace face) const {
+  // Orientations of the cubemap faces, as defined by the OpenGL spec.
+  switch (face) {
+    case TextureFace::Right:
+      return glm::lookAt(position, position + glm::vec3(1, 0, 0),
+                         glm::vec3(0, -1, 0));
+    case TextureFace::Left:
+      return glm::lookAt(position, position + glm::vec3(-1, 0, 0),
+                         glm::vec3(0, -1, 0));
+    case TextureFace::Top:
+      return glm::lookAt(position, position + glm::vec3(0, 1, 0),
+                         glm::vec3(0, 0, 1));
+    case TextureFace::Bottom:
+      return glm::lookAt(position, position + glm::vec3(0, -1, 0),
+                         glm::vec3(0, 0, -1));
+    case TextureFace::Back:
+      return glm::lookAt(position, position + glm::vec3(0, 0, 1),
+                         glm::vec3(0, -1, 0));
+    case TextureFace::Front:
+      return glm::lookAt(position, position + glm::vec3(0, 0, -1),
+                         glm::vec3(0, -1, 0));
+  }
+  return glm::mat4x4(1);
+}
+
+glm::mat4x4 dg::PointShadowMap::GetProjectionMatrix() const {
+  return glm::perspective(glm::radians(90.f), 1.f, NEAR_CLIP, farClip);
+}
+
+glm::mat4x4 dg::PointShadowMap::GetLightTransform() const {
+  return glm::scale(glm::mat4x4(1), glm::vec3(1.f / farClip)) *
+         glm::translate(glm::mat4x4(1), -position);
+}
+
+std::shared_ptr<dg::FrameBuffer> dg::PointShadowMap::GetFrameBuffer() const {
+  return framebuffer;
+}
+
+std::shared_ptr<dg::Texture> dg::PointShadowMap::GetTexture() const {
+  return framebuffer->GetDepthTexture();
+}
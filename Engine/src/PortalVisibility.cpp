@@ -0,0 +1,227 @@
+//
+//  PortalVisibility.cpp
+//
+
+#include "dg/PortalVisibility.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iterator>
+
+namespace {
+
+  // Distance from a portal's plane within which the camera is considered to
+  // be standing in the opening, which then doesn't narrow the view.
+  const float PORTAL_EPSILON = 0.001f;
+
+  bool Contains(const dg::AABB &box, glm::vec3 point) {
+    return glm::all(glm::greaterThanEqual(point, box.min)) &&
+           glm::all(glm::lessThanEqual(point, box.max));
+  }
+
+  bool Overlaps(const dg::AABB &a, const dg::AABB &b) {
+    return glm::all(glm::lessThanEqual(a.min, b.max)) &&
+           glm::all(glm::lessThanEqual(b.min, a.max));
+  }
+
+  // Sutherland-Hodgman clipping of a convex polygon, keeping the part on
+  // the inner side of a plane.
+  dg::FrameVector<glm::vec3> ClipPolygon(
+      const dg::FrameVector<glm::vec3> &polygon, const glm::vec4 &plane) {
+    dg::FrameVector<glm::vec3> clipped;
+    for (size_t i = 0; i < polygon.size(); i++) {
+      const glm::vec3 &a = polygon[i];
+      const glm::vec3 &b = polygon[(i + 1) % polygon.size()];
+      float distanceA = glm::dot(glm::vec3(plane), a) + plane.w;
+      float distanceB = glm::dot(glm::vec3(plane), b) + plane.w;
+      if (distanceA >= 0) {
+        clipped.push_back(a);
+      }
+      if ((distanceA >= 0) != (distanceB >= 0)) {
+        clipped.push_back(a + (b - a) * (distanceA / (distanceA - distanceB)));
+      }
+    }
+    return clipped;
+  }
+
+} // namespace
+
+unsigned int dg::PortalVisibility::AddCell(const AABB &bounds) {
+  Cell cell;
+  cell.bounds = bounds;
+  cells.push_back(cell);
+  return (unsigned int)cells.size() - 1;
+}
+
+void dg::PortalVisibility::AddPortal(unsigned int cellA, unsigned int cellB,
+                                     const std::vector<glm::vec3> &corners) {
+  assert(cellA < cells.size() && cellB < cells.size());
+  assert(corners.size() >= 3);
+
+  Portal portal;
+  portal.cells[0] = cellA;
+  portal.cells[1] = cellB;
+  portal.corners = corners;
+  glm::vec3 normal = glm::normalize(
+      glm::cross(corners[1] - corners[0], corners[2] - corners[0]));
+  portal.plane = glm::vec4(normal, -glm::dot(normal, corners[0]));
+
+  unsigned int index = (unsigned int)portals.size();
+  portals.push_back(portal);
+  cells[cellA].portals.push_back(index);
+  cells[cellB].portals.push_back(index);
+}
+
+void dg::PortalVisibility::AddPortal(unsigned int cellA, unsigned int cellB,
+                                     const Transform &quad) {
+  glm::mat4x4 xf = quad.ToMat4();
+  std::vector<glm::vec3> corners = {
+      glm::vec3(xf * glm::vec4(-0.5f, -0.5f, 0, 1)),
+      glm::vec3(xf * glm::vec4(-0.5f, +0.5f, 0, 1)),
+      glm::vec3(xf * glm::vec4(+0.5f, +0.5f, 0, 1)),
+      glm::vec3(xf * glm::vec4(+0.5f, -0.5f, 0, 1)),
+  };
+  AddPortal(cellA, cellB, corners);
+}
+
+void dg::PortalVisibility::Clear() {
+  cells.clear();
+  portals.clear();
+  inCell = false;
+}
+
+unsigned int dg::PortalVisibility::GetCellCount() const {
+  return (unsigned int)cells.size();
+}
+
+void dg::PortalVisibility::Update(glm::vec3 cameraPosition,
+                                  const glm::mat4x4 &viewProjection) {
+  this->cameraPosition = cameraPosition;
+  for (Cell &cell : cells) {
+    cell.volumeCount = 0;
+  }
+
+  Frustum frustum = Frustum::FromMatrix(viewProjection);
+  FrameVolume volume(std::begin(frustum.planes), std::end(frustum.planes));
+
+  // Cells may overlap, so flood from every cell the camera is in.
+  inCell = false;
+  for (unsigned int i = 0; i < cells.size(); i++) {
+    if (Contains(cells[i].bounds, cameraPosition)) {
+      inCell = true;
+      path.clear();
+      Flood(i, volume, 0);
+    }
+  }
+}
+
+void dg::PortalVisibility::Flood(unsigned int index,
+                                 const FrameVolume &volume,
+                                 unsigned int depth) {
+  Cell &cell = cells[index];
+  if (cell.volumeCount < cell.volumes.size()) {
+    cell.volumes[cell.volumeCount].assign(volume.begin(), volume.end());
+  } else {
+    cell.volumes.emplace_back(volume.begin(), volume.end());
+  }
+  cell.volumeCount++;
+  if (depth >= options.maxPortalDepth) {
+    return;
+  }
+
+  path.push_back(index);
+  for (unsigned int portalIndex : cell.portals) {
+    const Portal &portal = portals[portalIndex];
+    unsigned int next =
+        portal.cells[0] == index ? portal.cells[1] : portal.cells[0];
+    if (std::find(path.begin(), path.end(), next) != path.end()) {
+      continue;
+    }
+
+    // Clip the opening to the part of it seen through the current volume.
+    FrameVector<glm::vec3> polygon(portal.corners.begin(),
+                                   portal.corners.end());
+    for (const glm::vec4 &plane : volume) {
+      polygon = ClipPolygon(polygon, plane);
+      if (polygon.size() < 3) {
+        break;
+      }
+    }
+    if (polygon.size() < 3) {
+      continue;
+    }
+
+    float cameraDistance =
+        glm::dot(glm::vec3(portal.plane), cameraPosition) + portal.plane.w;
+    if (std::abs(cameraDistance) < PORTAL_EPSILON) {
+      Flood(next, volume, depth + 1);
+      continue;
+    }
+
+    // Narrow the volume to the planes through the camera and each edge of
+    // the visible opening, and to the far side of the opening.
+    FrameVolume narrowed = volume;
+    narrowed.push_back(cameraDistance > 0 ? -portal.plane : portal.plane);
+    glm::vec3 centroid = glm::vec3(0);
+    for (const glm::vec3 &corner : polygon) {
+      centroid += corner;
+    }
+    centroid /= (float)polygon.size();
+    for (size_t i = 0; i < polygon.size(); i++) {
+      glm::vec3 normal =
+          glm::cross(polygon[i] - cameraPosition,
+                     polygon[(i + 1) % polygon.size()] - cameraPosition);
+      float length = glm::length(normal);
+      if (length < PORTAL_EPSILON * PORTAL_EPSILON) {
+        continue;
+      }
+      normal /= length;
+      glm::vec4 plane = glm::vec4(normal, -glm::dot(normal, cameraPosition));
+      if (glm::dot(normal, centroid) + plane.w < 0) {
+        plane = -plane;
+      }
+      narrowed.push_back(plane);
+    }
+
+    Flood(next, narrowed, depth + 1);
+  }
+  path.pop_back();
+}
+
+bool dg::PortalVisibility::IsVisible(const AABB &bounds) const {
+  if (!inCell || bounds.IsEmpty()) {
+    return true;
+  }
+
+  bool inAnyCell = false;
+  for (const Cell &cell : cells) {
+    if (!Overlaps(cell.bounds, bounds)) {
+      continue;
+    }
+    inAnyCell = true;
+    for (size_t i = 0; i < cell.volumeCount; i++) {
+      if (Intersects(cell.volumes[i], bounds)) {
+        return true;
+      }
+    }
+  }
+  return !inAnyCell;
+}
+
+bool dg::PortalVisibility::IsCellVisible(unsigned int cell) const {
+  return cells[cell].volumeCount > 0;
+}
+
+bool dg::PortalVisibility::Intersects(const Volume &volume,
+                                      const AABB &box) {
+  glm::vec3 center = box.Center();
+  glm::vec3 extents = box.Extents();
+  for (const glm::vec4 &plane : volume) {
+    glm::vec3 normal = glm::vec3(plane);
+    float radius = glm::dot(extents, glm::abs(normal));
+    if (glm::dot(normal, center) + plane.w < -radius) {
+      return false;
+    }
+  }
+  return true;
+}
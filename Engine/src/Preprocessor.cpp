@@ -3,46 +3,160 @@
 //
 
 #include "dg/Preprocessor.h"
-#include <fstream>
-#include <sstream>
 #include <string>
 #include "dg/FileUtils.h"
 
-std::shared_ptr<dg::Preprocessor> dg::Preprocessor::ForFile(
+std::unordered_map<std::string, dg::Preprocessor::File>
+    dg::Preprocessor::files;
+std::unordered_map<std::string, std::set<std::string>>
+    dg::Preprocessor::includers;
+std::set<std::string> dg::Preprocessor::currentFilenames;
+
+std::shared_ptr<const std::string> dg::Preprocessor::Process(
+    const std::string &filename, const std::vector<std::string> &defines) {
+  File &file = GetFile(filename);
+  try {
+    GetProcessedContent(file);
+  } catch (...) {
+    currentFilenames.clear();
+    throw;
+  }
+  if (defines.empty()) {
+    return file.processedContent;
+  }
+
+  std::shared_ptr<const std::string> &definedContent =
+      file.definedContent[defines];
+  if (definedContent != nullptr) {
+    return definedContent;
+  }
+
+  // Defines must come after #version, which must be the first directive.
+  // A #line directive after them keeps the file's line numbers.
+  const std::string &content = *file.processedContent;
+  const std::string versionDirective = "#version";
+  size_t insertAt = 0;
+  int nextLine = 1;
+  if (content.compare(0, versionDirective.size(), versionDirective) == 0) {
+    insertAt = content.find('\n');
+    insertAt = insertAt == std::string::npos ? content.size() : insertAt + 1;
+    nextLine = 2;
+  }
+  std::string directives;
+  for (const std::string &define : defines) {
+    directives += "#define " + define + "\n";
+  }
+  directives += "#line " + std::to_string(nextLine) + " " +
+                std::to_string(file.id) + "\n";
+
+  std::string defined = content;
+  defined.insert(insertAt, directives);
+  definedContent = std::make_shared<const std::string>(std::move(defined));
+  return definedContent;
+}
+
+std::vector<std::string> dg::Preprocessor::GetDependents(
     const std::string &filename) {
-  auto pp = std::shared_ptr<Preprocessor>(new Preprocessor());
-  pp->filename = filename;
-  return pp;
+  std::vector<std::string> dependents;
+  std::set<std::string> visited = { filename };
+  std::vector<std::string> pending = { filename };
+  while (!pending.empty()) {
+    std::string current = pending.back();
+    pending.pop_back();
+    auto it = includers.find(current);
+    if (it == includers.end()) {
+      continue;
+    }
+    for (const std::string &includer : it->second) {
+      if (visited.insert(includer).second) {
+        dependents.push_back(includer);
+        pending.push_back(includer);
+      }
+    }
+  }
+  return dependents;
+}
+
+std::vector<std::string> dg::Preprocessor::Invalidate(
+    const std::string &filename) {
+  auto it = files.find(filename);
+  if (it == files.end()) {
+    return {};
+  }
+
+  File &file = it->second;
+  uint64_t oldHash = file.contentHash;
+  LoadFile(file);
+  if (file.contentHash == oldHash) {
+    return {};
+  }
+
+  std::vector<std::string> invalidated = GetDependents(filename);
+  invalidated.insert(invalidated.begin(), filename);
+  for (const std::string &name : invalidated) {
+    auto dependent = files.find(name);
+    if (dependent != files.end()) {
+      dependent->second.processedContent = nullptr;
+      dependent->second.definedContent.clear();
+    }
+  }
+  return invalidated;
 }
 
-const std::string &dg::Preprocessor::GetProcessedContent() {
-  return GetProcessedFile(GetFile(filename)).processedContent;
+void dg::Preprocessor::Clear() {
+  assert(currentFilenames.empty());
+  files.clear();
+  includers.clear();
 }
 
 dg::Preprocessor::File &dg::Preprocessor::GetFile(const std::string &filename) {
-  if (files.find(filename) == files.end()) {
-    files[filename] = {};
-    files[filename].filename = filename;
-    files[filename].id = nextFileID;
-    files[filename].lines = FileUtils::LoadFileLines(filename);
-    nextFileID++;
+  auto it = files.find(filename);
+  if (it != files.end()) {
+    return it->second;
   }
 
-  return files.at(filename);
+  File file;
+  file.filename = filename;
+
+  // The ID is a hash of the filename, rather than the order files were
+  // loaded in, so that processed content doesn't depend on which shaders
+  // were loaded before it. It's kept positive, as #line requires.
+  uint64_t nameHash = 14695981039346656037ull;
+  for (char c : filename) {
+    nameHash ^= (uint8_t)c;
+    nameHash *= 1099511628211ull;
+  }
+  file.id = (int)((nameHash ^ (nameHash >> 32)) & 0x7fffffff);
+  LoadFile(file);
+  return files.emplace(filename, std::move(file)).first->second;
 }
 
-dg::Preprocessor::File &dg::Preprocessor::GetProcessedFile(File &file) {
-  currentFilenames.insert(file.filename);
+void dg::Preprocessor::LoadFile(File &file) {
+  std::vector<std::string> lines = FileUtils::LoadFileLines(file.filename);
 
-  if (file.processed) {
-    return file;
+  // 64-bit FNV-1a of the lines.
+  uint64_t contentHash = 14695981039346656037ull;
+  for (const std::string &line : lines) {
+    for (char c : line) {
+      contentHash ^= (uint8_t)c;
+      contentHash *= 1099511628211ull;
+    }
+    contentHash ^= (uint8_t)'\n';
+    contentHash *= 1099511628211ull;
   }
 
-  std::stringstream content;
+  std::vector<Segment> segments(1);
+  auto appendLine = [&segments](const std::string &line) {
+    if (!segments.back().include.empty()) {
+      segments.push_back({});
+    }
+    segments.back().text += line;
+    segments.back().text += '\n';
+  };
 
   int lineNumber = 0;
   bool inComment = false;
-  for (std::string &line : file.lines) {
+  for (const std::string &line : lines) {
     lineNumber++;
 
     // FIXME: This is really sloppy naive parsing for comments, block comments,
@@ -69,7 +183,7 @@ dg::Preprocessor::File &dg::Preprocessor::GetProcessedFile(File &file) {
 
     size_t includeQuoteStart = line.find(includePatternPrefix);
     if (includeQuoteStart == std::string::npos) {
-      content << line << std::endl;
+      appendLine(line);
       continue;
     }
     includeQuoteStart += includePatternPrefix.length();
@@ -78,13 +192,13 @@ dg::Preprocessor::File &dg::Preprocessor::GetProcessedFile(File &file) {
     size_t lineCommentStart = line.find(lineCommentPrefix);
     if (lineCommentStart != std::string::npos &&
         lineCommentStart <= includeQuoteStart) {
-      content << line << std::endl;
+      appendLine(line);
       continue;
     }
 
     size_t includeQuoteEnd =
         line.find(includePatternSuffix, includeQuoteStart);
-    if (includeQuoteStart == std::string::npos) {
+    if (includeQuoteEnd == std::string::npos) {
       throw UnterminatedQuoteError(file, lineNumber);
     }
 
@@ -95,21 +209,58 @@ dg::Preprocessor::File &dg::Preprocessor::GetProcessedFile(File &file) {
     std::string includeFilename =
         line.substr(includeQuoteStart, includeQuoteEnd - includeQuoteStart);
 
-    std::string includeFilePath = FileUtils::FlattenPath(
+    Segment include;
+    include.include = FileUtils::FlattenPath(
         FileUtils::DirectoryPathOfFilePath(file.filename) + "/" +
         includeFilename);
+    include.line = lineNumber;
+    segments.push_back(include);
+  }
+
+  file.contentHash = contentHash;
+  file.segments = std::move(segments);
+}
+
+const std::string &dg::Preprocessor::GetProcessedContent(File &file) {
+  if (file.processedContent != nullptr) {
+    return *file.processedContent;
+  }
 
-    if (currentFilenames.count(includeFilePath) > 0) {
-      throw CycleError(file, lineNumber);
+  currentFilenames.insert(file.filename);
+
+  // Forget the includes of the file's last processing, in case they
+  // changed.
+  for (const std::string &include : file.includes) {
+    includers[include].erase(file.filename);
+  }
+  file.includes.clear();
+
+  std::string content;
+  for (const Segment &segment : file.segments) {
+    if (segment.include.empty()) {
+      content += segment.text;
+      continue;
     }
 
-    auto &includeFile = GetProcessedFile(GetFile(includeFilePath));
-    content << "#line 1 " << includeFile.id << std::endl;
-    content << includeFile.processedContent;
-    content << "#line " << (lineNumber + 1) << " " << file.id << std::endl;
+    if (currentFilenames.count(segment.include) > 0) {
+      throw CycleError(file, segment.line);
+    }
+
+    // Looking up the included file may add to files, but unordered_map
+    // keeps references to its elements valid.
+    File &includeFile = GetFile(segment.include);
+    const std::string &includeContent = GetProcessedContent(includeFile);
+    file.includes.push_back(segment.include);
+    includers[segment.include].insert(file.filename);
+
+    content += "#line 1 " + std::to_string(includeFile.id) + "\n";
+    content += includeContent;
+    content += "#line " + std::to_string(segment.line + 1) + " " +
+               std::to_string(file.id) + "\n";
   }
 
-  file.processedContent = content.str();
+  file.processedContent = std::make_shared<const std::string>(
+      std::move(content));
   currentFilenames.erase(file.filename);
-  return file;
+  return *file.processedContent;
 }
@@ -5,16 +5,21 @@
 #include "dg/Scene.h"
 #include <algorithm>
 #include <cassert>
-#include <deque>
 #include <iostream>
+#include <memory>
+#include <string>
 #include <vector>
+#include "dg/Bounds.h"
 #include "dg/Camera.h"
 #include "dg/Exceptions.h"
+#include "dg/FrameAllocator.h"
 #include "dg/FrameBuffer.h"
 #include "dg/Graphics.h"
 #include "dg/Lights.h"
 #include "dg/Model.h"
+#include "dg/PointShadowMap.h"
 #include "dg/RasterizerState.h"
+#include "dg/Shader.h"
 #include "dg/ShaderReplacedMaterial.h"
 #include "dg/Skybox.h"
 #include "dg/Window.h"
@@ -23,6 +28,38 @@
 #include "dg/vr/VRRenderModel.h"
 #include "dg/vr/VRTrackedObject.h"
 
+namespace {
+
+  // Draws a model for a scene-drawing subrender, applying the subrender's
+  // material override and shader replacements.
+  void DrawModel(dg::Model &model, const dg::Model::DrawContext &context,
+                 const dg::Scene::Subrender &subrender) {
+    using namespace dg;
+
+    // Use either the model's assigned material or the subrender's material
+    // override if not null.
+    const std::shared_ptr<Material> &sharedMaterial =
+        subrender.material == nullptr ? model.material : subrender.material;
+    Material *material = sharedMaterial.get();
+
+    // Check to see if this subrender intends to replace the chosen material's
+    // shader with another shader.
+    if (!subrender.shaderReplacements.empty()) {
+      auto shaderReplacement =
+          subrender.shaderReplacements.find(sharedMaterial->shader.get());
+      if (shaderReplacement != subrender.shaderReplacements.end()) {
+        material = ShaderReplacedMaterial::Get(sharedMaterial,
+                                               shaderReplacement->second)
+                       .get();
+      }
+    }
+
+    // Draw the model with the context and material.
+    model.Draw(context, material);
+  }
+
+} // namespace
+
 dg::Scene::Scene() : SceneObject() {}
 dg::Scene::~Scene() {}
 
@@ -55,9 +92,30 @@ void dg::Scene::Initialize() {
 
   // Create subrender state for light shadowmap, if any. If a depth map
   // is eventually rendered, the framebuffer resource will be created only at
-  // that time.
+  // that time. Only depth is written, so lights aren't sent.
   subrenders.light.outputType = Subrender::OutputType::Depthmap;
   subrenders.light.camera = std::make_shared<Camera>();
+  subrenders.light.sendLights = false;
+
+  // Create subrender state for the directional light's shadow cascades,
+  // whose framebuffer is owned by shadowCascades. Only depth is written, so
+  // lights aren't sent.
+  subrenders.cascades.outputType = Subrender::OutputType::Depthmap;
+  subrenders.cascades.camera = std::make_shared<Camera>();
+  subrenders.cascades.sendLights = false;
+
+  // Create subrender state for point light shadow cubemaps, which are drawn
+  // with a layered-rendering shader that writes distance to the light.
+#if defined(_OPENGL)
+  subrenders.pointLight.outputType = Subrender::OutputType::Depthmap;
+  subrenders.pointLight.camera = std::make_shared<Camera>();
+  subrenders.pointLight.sendLights = false;
+  subrenders.pointLight.material = std::make_shared<Material>();
+  subrenders.pointLight.material->shader =
+      Shader::FromFiles("assets/shaders/pointshadow.v.glsl",
+                        "assets/shaders/pointshadow.g.glsl",
+                        "assets/shaders/pointshadow.f.glsl");
+#endif
 
   // If we're set up for VR, create subrender configurations for each eye.
   // Its camera is set each frame instead of now in case cameras.vr changes.
@@ -69,6 +127,8 @@ void dg::Scene::Initialize() {
       subrenders.eyes[i].framebuffer =
           VRManager::Instance->GetFramebuffer(subrenders.eyes[i].eye);
     }
+    subrenders.stereo.outputType =
+        Subrender::OutputType::StereoscopicInstanced;
   }
 }
 
@@ -146,6 +206,14 @@ void dg::Scene::DrawSkybox() {
       skybox->Draw(*currentRender.subrender->camera,
                    currentRender.subrender->eye);
       break;
+    case Subrender::OutputType::StereoscopicInstanced:
+      for (int i = 0; i < 2; i++) {
+        SetStereoViewport(i);
+        skybox->Draw(*currentRender.subrender->camera,
+                     i == 0 ? vr::EVREye::Eye_Left : vr::EVREye::Eye_Right);
+      }
+      SetStereoViewport(-1);
+      break;
     default:
       break;
   }
@@ -204,8 +272,10 @@ void dg::Scene::SetupSubrender(Subrender &subrender) {
   rasterizerState += subrender.rasterizerState;
   Graphics::Instance->PushRasterizerState(rasterizerState);
 
-  // Clear the background and depth and stencil buffers.
-  if (subrender.clearBuffer) {
+  // Clear the background and depth and stencil buffers. Depthmap subrenders
+  // render to the shadow atlas, whose regions are cleared individually.
+  if (subrender.clearBuffer &&
+      subrender.outputType != Subrender::OutputType::Depthmap) {
     ClearBuffer();
   }
 
@@ -213,6 +283,13 @@ void dg::Scene::SetupSubrender(Subrender &subrender) {
   // pixels we won't see due to the HMD's optics.
   if (subrender.outputType == Subrender::OutputType::Stereoscopic) {
     DrawHiddenAreaMesh(subrender.eye);
+  } else if (subrender.outputType ==
+             Subrender::OutputType::StereoscopicInstanced) {
+    SetStereoViewport(0);
+    DrawHiddenAreaMesh(vr::EVREye::Eye_Left);
+    SetStereoViewport(1);
+    DrawHiddenAreaMesh(vr::EVREye::Eye_Right);
+    SetStereoViewport(-1);
   }
 }
 
@@ -220,6 +297,9 @@ void dg::Scene::TeardownSubrender() {
   if (currentRender.subrender->outputType ==
       Subrender::OutputType::Stereoscopic) {
     VRManager::Instance->SubmitFrame(currentRender.subrender->eye);
+  } else if (currentRender.subrender->outputType ==
+             Subrender::OutputType::StereoscopicInstanced) {
+    VRManager::Instance->SubmitStereoFrame();
   }
   Graphics::Instance->PopRasterizerState();
   currentRender.subrender = nullptr;
@@ -229,9 +309,19 @@ void dg::Scene::TeardownRender() {
   if (vr.enabled) {
     VRManager::Instance->RenderFinished();
   }
+  for (SortedModel &sortedModel : currentRender.models) {
+    sortedModel.model->SetCachedMatrices(nullptr, nullptr);
+  }
   currentRender.models.clear();
+  currentRender.modelMatrices.clear();
+  currentRender.normalMatrices.clear();
   currentRender.lights.clear();
-  currentRender.shadowCastingLight = nullptr;
+  currentRender.shadowCastingLights.clear();
+  currentRender.shadowMap = nullptr;
+  currentRender.cascadedShadowLight = nullptr;
+  currentRender.pointShadowLights.clear();
+  currentRender.pointShadowMaps.clear();
+  shadowCascades.SetActive(false);
   currentRender.rendering = false;
 }
 
@@ -239,9 +329,21 @@ void dg::Scene::RenderFrame() {
   subrenders.main.camera = cameras.main;
   PreRender();
   SetupRender();
-  RenderLightShadowMap();
+  RenderLightShadowMaps();
+  RenderCascadedShadowMaps();
+  RenderPointShadowMaps();
   RenderFramebuffers();
-  if (vr.enabled) {
+#if defined(_OPENGL)
+  bool singlePassStereo = vr.singlePassStereo;
+#else
+  bool singlePassStereo = false;
+#endif
+  if (vr.enabled && singlePassStereo) {
+    subrenders.stereo.camera = cameras.vr;
+    subrenders.stereo.framebuffer =
+        VRManager::Instance->GetStereoFramebuffer();
+    PerformSubrender(subrenders.stereo);
+  } else if (vr.enabled) {
     for (int i = 0; i < 2; i++) {
       subrenders.eyes[i].camera = cameras.vr;
       PerformSubrender(subrenders.eyes[i]);
@@ -278,6 +380,8 @@ void dg::Scene::PerformSubrender(Subrender &subrender) {
         context.view = subrender.camera->GetViewMatrix();
         context.projection = subrender.camera->GetProjectionMatrix();
       } else {
+        cameraPos = glm::vec3(0);
+        context.cameraPos = &cameraPos;
         context.view = glm::mat4x4(1);
         context.projection = glm::mat4x4(1);
       }
@@ -298,24 +402,27 @@ void dg::Scene::ProcessSceneHierarchy() {
 
   // Traverse scene tree and sort out different types of objects
   // into their own lists.
-  std::deque<SceneObject*> remainingObjects;
-  remainingObjects.push_front((SceneObject*)this);
+  FrameVector<SceneObject*> remainingObjects;
+  remainingObjects.push_back((SceneObject*)this);
   while (!remainingObjects.empty()) {
-    SceneObject *obj = remainingObjects.front();
-    remainingObjects.pop_front();
+    SceneObject *obj = remainingObjects.back();
+    remainingObjects.pop_back();
     for (auto child = obj->Children().begin();
          child != obj->Children().end();
          child++) {
       if (!(*child)->enabled) continue;
-      remainingObjects.push_front(child->get());
-      if (auto model = std::dynamic_pointer_cast<Model>(*child)) {
+      remainingObjects.push_back(child->get());
+      if (auto model = dynamic_cast<Model *>(child->get())) {
         currentRender.models.push_back(SortedModel(*model));
-      } else if (auto light = std::dynamic_pointer_cast<Light>(*child)) {
-        currentRender.lights.push_front(light.get());
+      } else if (auto light = dynamic_cast<Light *>(child->get())) {
+        currentRender.lights.push_back(light);
       }
     }
   }
 
+  // Lights were found in reverse order of the traversal.
+  std::reverse(currentRender.lights.begin(), currentRender.lights.end());
+
   // Compute all models' distances to camera.
   glm::vec3 cameraPos = cameras.main->CachedSceneSpace().translation;
   for (SortedModel &sortedModel : currentRender.models) {
@@ -342,66 +449,456 @@ void dg::Scene::ProcessSceneHierarchy() {
          }
        });
 
-  // Reset light shadows.
-  bool foundShadowLight = false;
-  currentRender.shadowCastingLight = nullptr;
+  // Compute every model's matrices once for all of this frame's subrenders,
+  // in draw order so that they're read sequentially.
+  size_t modelCount = currentRender.models.size();
+  FrameVector<Transform> sceneSpaces(modelCount);
+  for (size_t i = 0; i < modelCount; i++) {
+    sceneSpaces[i] = currentRender.models[i].model->CachedSceneSpace();
+  }
+  currentRender.modelMatrices.resize(modelCount);
+  currentRender.normalMatrices.resize(modelCount);
+  Transform::ToMat4(sceneSpaces.data(), currentRender.modelMatrices.data(),
+                    modelCount);
+  Transform::ToNormalMat4(sceneSpaces.data(),
+                          currentRender.normalMatrices.data(), modelCount);
+  for (size_t i = 0; i < modelCount; i++) {
+    currentRender.models[i].model->SetCachedMatrices(
+        &currentRender.modelMatrices[i], &currentRender.normalMatrices[i]);
+  }
+
+  // Reset light shadows, and find the lights that will cast shadows.
+  currentRender.shadowCastingLights.clear();
+  currentRender.cascadedShadowLight = nullptr;
+  currentRender.pointShadowLights.clear();
   for (auto &light : currentRender.lights) {
     light->SetShadowMap(nullptr);
-    if (light->GetCastShadows()) {
-      if (foundShadowLight) {
-        std::cerr
-            << "Warning: More than one light wants to cast shadows, but only "
-               "one shadow is supported at a time."
-            << std::endl;
-      } else {
-        foundShadowLight = true;
-        currentRender.shadowCastingLight = light;
-      }
+    if (!light->GetCastShadows()) {
+      continue;
+    }
+    switch (light->GetShaderData().type) {
+      case Light::LightType::NONE:
+        break;
+      case Light::LightType::POINT:
+#if defined(_OPENGL)
+        if (currentRender.pointShadowLights.size() <
+            PointShadowMap::MAX_SHADOWED_LIGHTS) {
+          currentRender.pointShadowLights.push_back(light);
+        } else {
+          std::cerr << "Warning: Only "
+                    << PointShadowMap::MAX_SHADOWED_LIGHTS
+                    << " PointLights can cast shadows at a time." << std::endl;
+        }
+#elif defined(_DIRECTX)
+        std::cerr << "Error: Shadows are not implemented for PointLight."
+                  << std::endl;
+#endif
+        break;
+      case Light::LightType::SPOT:
+        currentRender.shadowCastingLights.push_back(light);
+        break;
+      case Light::LightType::DIRECTIONAL:
+#if defined(_OPENGL)
+        if (currentRender.cascadedShadowLight == nullptr) {
+          currentRender.cascadedShadowLight = light;
+        } else {
+          std::cerr << "Warning: Only one DirectionalLight can cast shadows "
+                       "at a time."
+                    << std::endl;
+        }
+#elif defined(_DIRECTX)
+        std::cerr << "Error: Shadows are not implemented for DirectionalLight."
+                  << std::endl;
+#endif
+        break;
     }
   }
 }
 
-void dg::Scene::RenderLightShadowMap() {
-  if (currentRender.shadowCastingLight == nullptr) {
+void dg::Scene::RenderLightShadowMaps() {
+  if (currentRender.shadowCastingLights.empty()) {
     return;
   }
 
-  switch (currentRender.shadowCastingLight->GetShaderData().type) {
-    case Light::LightType::NONE:
-      return;
-    case Light::LightType::POINT:
-      std::cerr << "Error: Shadows are not implemented for PointLight."
-                << std::endl;
-      return;
-    case Light::LightType::SPOT:
-      break;
-    case Light::LightType::DIRECTIONAL:
-      std::cerr << "Error: Shadows are not implemented for DirectionalLight."
-                << std::endl;
-      return;
-  }
-
   if (subrenders.light.framebuffer == nullptr) {
     FrameBuffer::Options options;
-    options.width = 2048;
-    options.height = 2048;
+    options.width = shadowAtlasSize;
+    options.height = shadowAtlasSize;
     options.depthReadable = true;
     options.hasColor = false;
     options.hasStencil = false;
     subrenders.light.framebuffer = FrameBuffer::Create(options);
   }
 
-  auto *spotlight = static_cast<SpotLight *>(currentRender.shadowCastingLight);
+  FrameBuffer &atlasFramebuffer = *subrenders.light.framebuffer;
+  if (atlasFramebuffer.GetWidth() != atlasFramebuffer.GetHeight()) {
+    throw EngineError(
+        "The light subrender's framebuffer must be square to hold the shadow "
+        "atlas.");
+  }
+
+  // (Re)create the atlas for the current framebuffer. On OpenGL, also create
+  // the static layer for caching static casters' depth.
+  if (shadowCache.framebuffer != subrenders.light.framebuffer) {
+    shadowCache.framebuffer = subrenders.light.framebuffer;
+    shadowCache.atlas =
+        std::make_unique<ShadowAtlas>(atlasFramebuffer.GetWidth());
+    shadowCache.staticLayer = nullptr;
+#if defined(_OPENGL)
+    shadowCache.staticLayer =
+        FrameBuffer::Create(atlasFramebuffer.GetOptions());
+#endif
+  }
+
+  FrameVector<ShadowAtlas::Request> requests;
+  requests.reserve(currentRender.shadowCastingLights.size());
+  for (Light *light : currentRender.shadowCastingLights) {
+    requests.push_back({ light, light->GetShadowResolution() });
+  }
+  shadowCache.atlas->Pack(requests.data(), requests.size());
+
+  SetupSubrender(subrenders.light);
+  PreSubrender(subrenders.light);
+
+  // Without a static layer, there's nothing to restore unchanged regions
+  // from, so the whole atlas is cleared and redrawn.
+  if (shadowCache.staticLayer == nullptr) {
+    ClearBuffer();
+  }
+
+  for (ShadowAtlas::Region &region : shadowCache.atlas->GetRegions()) {
+    RenderShadowRegion(region);
+  }
+
+  Graphics::Instance->DisableScissor();
+  Graphics::Instance->SetRenderTarget(atlasFramebuffer);
+  PostSubrender(subrenders.light);
+  TeardownSubrender();
+
+  // Only enable the shadows once all regions are drawn, so that no region is
+  // drawn with a shader sampling the atlas it's rendering to.
+  currentRender.shadowMap = atlasFramebuffer.GetDepthTexture();
+  for (ShadowAtlas::Region &region : shadowCache.atlas->GetRegions()) {
+    region.light->SetShadowMap(currentRender.shadowMap);
+  }
+}
+
+void dg::Scene::RenderShadowRegion(ShadowAtlas::Region &region) {
+  auto *spotlight = static_cast<SpotLight *>(region.light);
   auto camera = subrenders.light.camera;
   camera->transform = spotlight->CachedSceneSpace();
   camera->fov = spotlight->GetCutoff() * 2;
   camera->nearClip = 0.01f;
   camera->farClip = 100;
-  currentRender.shadowCastingLight->SetLightTransform(
-      camera->GetProjectionMatrix() * camera->GetViewMatrix());
-  PerformSubrender(subrenders.light);
-  currentRender.shadowCastingLight->SetShadowMap(
-      subrenders.light.framebuffer->GetDepthTexture());
+  glm::mat4x4 view = camera->GetViewMatrix();
+  glm::mat4x4 projection = camera->GetProjectionMatrix();
+  glm::mat4x4 viewProjection = projection * view;
+
+  // Shaders sample the atlas with the light transform, so fold in the
+  // mapping to this light's region.
+  region.light->SetLightTransform(
+      shadowCache.atlas->RegionTransform(region) * viewProjection);
+
+  // Find the casters within the light's frustum, split into static casters
+  // (which can be cached) and dynamic casters (which are drawn every frame).
+  Frustum frustum = Frustum::FromMatrix(viewProjection);
+  FrameVector<Model *> staticCasters;
+  FrameVector<Model *> dynamicCasters;
+  std::size_t staticCasterHash = 0;
+  for (SortedModel &sortedModel : currentRender.models) {
+    Model *model = sortedModel.model;
+    if (!(model->layer & subrenders.light.layerMask) ||
+        !frustum.Intersects(model->SceneBounds())) {
+      continue;
+    }
+    if (model->isStatic) {
+      staticCasters.push_back(model);
+      std::hash_combine(staticCasterHash, model);
+      std::hash_combine(staticCasterHash, model->ModelMatrix());
+    } else {
+      dynamicCasters.push_back(model);
+    }
+  }
+
+  bool staticChanged = !region.staticValid ||
+                       region.viewProjection != viewProjection ||
+                       region.staticCasterHash != staticCasterHash;
+  bool dynamicChanged = !dynamicCasters.empty() || region.hadDynamicCasters;
+  if (shadowCache.staticLayer != nullptr && !staticChanged &&
+      !dynamicChanged) {
+    return;
+  }
+
+  glm::vec3 cameraPos = camera->transform.translation;
+  Model::DrawContext context;
+  context.view = view;
+  context.projection = projection;
+  context.cameraPos = &cameraPos;
+#if defined(_OPENGL)
+  context.shadowCascades = &shadowCascades;
+  context.pointShadowMaps = &currentRender.pointShadowMaps;
+#endif
+
+  int x = (int)region.x;
+  int y = (int)region.y;
+  int size = (int)region.size;
+
+  if (shadowCache.staticLayer == nullptr) {
+    // The atlas has already been cleared, so just draw all casters.
+    Graphics::Instance->SetViewport(x, y, size, size);
+    for (Model *model : staticCasters) {
+      DrawModel(*model, context, subrenders.light);
+    }
+    for (Model *model : dynamicCasters) {
+      DrawModel(*model, context, subrenders.light);
+    }
+  } else {
+    if (staticChanged) {
+      Graphics::Instance->SetRenderTarget(*shadowCache.staticLayer);
+      Graphics::Instance->SetViewport(x, y, size, size);
+      Graphics::Instance->SetScissor(x, y, size, size);
+      ClearBuffer();
+      for (Model *model : staticCasters) {
+        DrawModel(*model, context, subrenders.light);
+      }
+      region.staticValid = true;
+      region.staticCasterHash = staticCasterHash;
+    }
+
+    // Restore the region from the static layer, then draw the dynamic
+    // casters over it.
+    Graphics::Instance->CopyFrameBufferRegion(
+        *shadowCache.staticLayer, *subrenders.light.framebuffer, x, y, size,
+        size);
+    if (!dynamicCasters.empty()) {
+      Graphics::Instance->SetViewport(x, y, size, size);
+      Graphics::Instance->SetScissor(x, y, size, size);
+      for (Model *model : dynamicCasters) {
+        DrawModel(*model, context, subrenders.light);
+      }
+    }
+  }
+
+  region.viewProjection = viewProjection;
+  region.hadDynamicCasters = !dynamicCasters.empty();
+}
+
+void dg::Scene::RenderCascadedShadowMaps() {
+#if defined(_OPENGL)
+  Light *light = currentRender.cascadedShadowLight;
+  if (light == nullptr) {
+    return;
+  }
+
+  // Casters outside the view can still shadow it, so the cascades extend
+  // towards the light to cover every caster.
+  AABB casterBounds = AABB::Empty();
+  for (SortedModel &sortedModel : currentRender.models) {
+    if (sortedModel.model->layer & subrenders.cascades.layerMask) {
+      casterBounds.Encapsulate(sortedModel.model->SceneBounds());
+    }
+  }
+  shadowCascades.Fit(*cameras.main, window->GetAspectRatio(),
+                     light->GetShaderData().direction, casterBounds);
+
+  std::shared_ptr<FrameBuffer> framebuffer = shadowCascades.GetFrameBuffer();
+  subrenders.cascades.framebuffer = framebuffer;
+  SetupSubrender(subrenders.cascades);
+  PreSubrender(subrenders.cascades);
+
+  // The light's view is the same for every cascade and caster, so its
+  // position is found once instead of by each draw.
+  Model::DrawContext context;
+  context.view = shadowCascades.GetViewMatrix();
+  glm::vec3 cameraPos = glm::vec3(glm::inverse(context.view)[3]);
+  context.cameraPos = &cameraPos;
+  context.shadowCascades = &shadowCascades;
+  context.pointShadowMaps = &currentRender.pointShadowMaps;
+  for (unsigned int i = 0; i < shadowCascades.GetCount(); i++) {
+    if (!shadowCascades.NeedsRender(i)) {
+      continue;
+    }
+
+    framebuffer->SelectLayer(i);
+    Graphics::Instance->SetRenderTarget(*framebuffer);
+    ClearBuffer();
+
+    context.projection = shadowCascades.GetProjectionMatrix(i);
+    Frustum frustum = Frustum::FromMatrix(shadowCascades.GetLightTransform(i));
+    for (SortedModel &sortedModel : currentRender.models) {
+      Model *model = sortedModel.model;
+      if (!(model->layer & subrenders.cascades.layerMask) ||
+          !frustum.Intersects(model->SceneBounds())) {
+        continue;
+      }
+      DrawModel(*model, context, subrenders.cascades);
+    }
+  }
+  framebuffer->SelectLayer(-1);
+
+  PostSubrender(subrenders.cascades);
+  TeardownSubrender();
+
+  // Only enable the cascades once they're all drawn, so that none is drawn
+  // with a shader sampling the texture it's rendering to.
+  shadowCascades.SetActive(true);
+  light->SetShadowMap(shadowCascades.GetTexture());
+  light->SetLightTransform(shadowCascades.GetLightTransform(0));
+#endif
+}
+
+void dg::Scene::RenderPointShadowMaps() {
+#if defined(_OPENGL)
+  // Release the shadow maps of lights that no longer cast shadows.
+  auto &lights = currentRender.pointShadowLights;
+  for (auto it = pointShadowCache.begin(); it != pointShadowCache.end();) {
+    if (std::find(lights.begin(), lights.end(), it->first) == lights.end()) {
+      it = pointShadowCache.erase(it);
+    } else {
+      it++;
+    }
+  }
+
+  for (unsigned int i = 0; i < lights.size(); i++) {
+    Light *light = lights[i];
+    std::unique_ptr<PointShadowMap> &shadowMap = pointShadowCache[light];
+    if (shadowMap == nullptr ||
+        shadowMap->GetResolution() != light->GetShadowResolution()) {
+      shadowMap =
+          std::make_unique<PointShadowMap>(light->GetShadowResolution());
+    }
+
+    RenderPointShadowMap(*light, *shadowMap);
+
+    currentRender.pointShadowMaps.push_back(shadowMap->GetTexture());
+    light->SetShadowMap(shadowMap->GetTexture());
+    light->SetShadowIndex((int)i);
+    light->SetLightTransform(shadowMap->GetLightTransform());
+  }
+#endif
+}
+
+void dg::Scene::RenderPointShadowMap(Light &light,
+                                     PointShadowMap &shadowMap) {
+#if defined(_OPENGL)
+  glm::vec3 position = light.CachedSceneSpace().translation;
+  float farClip =
+      std::min(LightClusters::LightRange(light.GetShaderData()), 100.f);
+  shadowMap.SetOrigin(position, farClip);
+
+  glm::mat4x4 projection = shadowMap.GetProjectionMatrix();
+  glm::mat4x4 faceMatrices[PointShadowMap::FACE_COUNT];
+  Frustum faceFrustums[PointShadowMap::FACE_COUNT];
+  for (int face = 0; face < PointShadowMap::FACE_COUNT; face++) {
+    faceMatrices[face] =
+        projection * shadowMap.GetViewMatrix((TextureFace)face);
+    faceFrustums[face] = Frustum::FromMatrix(faceMatrices[face]);
+  }
+
+  // Find the faces each caster is visible to, and hash the static casters of
+  // each face to find which faces have changed.
+  struct Caster {
+    Model *model;
+    int faceMask;
+  };
+  FrameVector<Caster> casters;
+  std::size_t staticCasterHashes[PointShadowMap::FACE_COUNT] = {};
+  int dynamicFaces = 0;
+  for (SortedModel &sortedModel : currentRender.models) {
+    Model *model = sortedModel.model;
+    if (!(model->layer & subrenders.pointLight.layerMask)) {
+      continue;
+    }
+
+    // Casters enclosing the light, such as a model of the bulb itself,
+    // would shadow everything.
+    AABB bounds = model->SceneBounds();
+    if (bounds.IsEmpty() ||
+        (glm::all(glm::greaterThanEqual(position, bounds.min)) &&
+         glm::all(glm::lessThanEqual(position, bounds.max)))) {
+      continue;
+    }
+
+    int faceMask = 0;
+    for (int face = 0; face < PointShadowMap::FACE_COUNT; face++) {
+      if (faceFrustums[face].Intersects(bounds)) {
+        faceMask |= 1 << face;
+      }
+    }
+    if (faceMask == 0) {
+      continue;
+    }
+    casters.push_back({ model, faceMask });
+
+    if (!model->isStatic) {
+      dynamicFaces |= faceMask;
+      continue;
+    }
+    std::size_t casterHash = 0;
+    std::hash_combine(casterHash, model);
+    std::hash_combine(casterHash, model->ModelMatrix());
+    for (int face = 0; face < PointShadowMap::FACE_COUNT; face++) {
+      if (faceMask & (1 << face)) {
+        std::hash_combine(staticCasterHashes[face], casterHash);
+      }
+    }
+  }
+
+  int changedFaces = 0;
+  for (int face = 0; face < PointShadowMap::FACE_COUNT; face++) {
+    PointShadowMap::Face &faceCache = shadowMap.faces[face];
+    bool hasDynamicCasters = (dynamicFaces & (1 << face)) != 0;
+    if (!faceCache.valid ||
+        faceCache.staticCasterHash != staticCasterHashes[face] ||
+        hasDynamicCasters || faceCache.hadDynamicCasters) {
+      changedFaces |= 1 << face;
+    }
+    faceCache.valid = true;
+    faceCache.staticCasterHash = staticCasterHashes[face];
+    faceCache.hadDynamicCasters = hasDynamicCasters;
+  }
+  if (changedFaces == 0) {
+    return;
+  }
+
+  std::shared_ptr<FrameBuffer> framebuffer = shadowMap.GetFrameBuffer();
+  subrenders.pointLight.framebuffer = framebuffer;
+  SetupSubrender(subrenders.pointLight);
+  PreSubrender(subrenders.pointLight);
+
+  for (int face = 0; face < PointShadowMap::FACE_COUNT; face++) {
+    if (changedFaces & (1 << face)) {
+      framebuffer->SelectLayer(face);
+      Graphics::Instance->SetRenderTarget(*framebuffer);
+      ClearBuffer();
+    }
+  }
+  framebuffer->SelectLayer(-1);
+  Graphics::Instance->SetRenderTarget(*framebuffer);
+
+  Material &material = *subrenders.pointLight.material;
+  material.SetProperty("_FaceMatrices", faceMatrices,
+                       PointShadowMap::FACE_COUNT);
+  material.SetProperty("_LightPosition", position);
+  material.SetProperty("_FarClip", farClip);
+
+  // Each face's view is applied by the geometry shader, and every face
+  // looks out from the light.
+  Model::DrawContext context;
+  context.projection = projection;
+  context.cameraPos = &position;
+  for (const Caster &caster : casters) {
+    int faceMask = caster.faceMask & changedFaces;
+    if (faceMask == 0) {
+      continue;
+    }
+    material.SetProperty("_FaceMask", faceMask);
+    DrawModel(*caster.model, context, subrenders.pointLight);
+  }
+
+  PostSubrender(subrenders.pointLight);
+  TeardownSubrender();
+#endif
 }
 
 void dg::Scene::DrawScene() {
@@ -416,6 +913,8 @@ void dg::Scene::DrawScene() {
   // Set up view.
   glm::mat4x4 view;
   glm::mat4x4 projection;
+  float nearClip = currentRender.subrender->camera->nearClip;
+  float farClip = currentRender.subrender->camera->farClip;
   switch (currentRender.subrender->outputType) {
     case Subrender::OutputType::Stereoscopic:
       view = currentRender.subrender->camera->GetViewMatrix(
@@ -423,6 +922,14 @@ void dg::Scene::DrawScene() {
       projection = currentRender.subrender->camera->GetProjectionMatrix(
           currentRender.subrender->eye);
       break;
+    case Subrender::OutputType::StereoscopicInstanced:
+      view = currentRender.subrender->camera->GetStereoViewMatrix();
+      projection = currentRender.subrender->camera->GetStereoProjectionMatrix();
+      // The combined frustum's origin is behind the eyes, so its clip
+      // distances are farther than the camera's.
+      nearClip = projection[3][2] / (projection[2][2] - 1);
+      farClip = projection[3][2] / (projection[2][2] + 1);
+      break;
     default:
       view = currentRender.subrender->camera->GetViewMatrix();
       projection = currentRender.subrender->camera->GetProjectionMatrix();
@@ -430,15 +937,8 @@ void dg::Scene::DrawScene() {
   }
 
   // Prepare light data.
-  Light::ShaderData lightArray[Light::MAX_LIGHTS];
-  int lightIdx = 0;
   if (currentRender.subrender->sendLights) {
-    for (auto &light : currentRender.lights) {
-      if (lightIdx >= Light::MAX_LIGHTS) {
-        break;
-      }
-      lightArray[lightIdx++] = (*light).GetShaderData();
-    }
+    PrepareLights(view, projection, nearClip, farClip);
   }
 
   // Gather non-persistent data we'll send to each model's shader once per draw.
@@ -450,12 +950,76 @@ void dg::Scene::DrawScene() {
   context.cameraPos = &cameraPos;
   if (currentRender.subrender->sendLights) {
     context.lights = &lightArray;
-    if (currentRender.shadowCastingLight != nullptr) {
-      auto texture = currentRender.shadowCastingLight->GetShadowMap();
-      if (texture != nullptr) {
-        context.shadowMap = texture;
+#if defined(_OPENGL)
+    context.lightClusters = &lightClusters;
+#endif
+    context.shadowMap = currentRender.shadowMap;
+  }
+#if defined(_OPENGL)
+  context.shadowCascades = &shadowCascades;
+  context.pointShadowMaps = &currentRender.pointShadowMaps;
+#endif
+
+  // For single-pass stereo, every model is drawn once for both eyes, and
+  // culled once against the frustum enclosing both. Each eye's clip space is
+  // reached from the combined one, computed in double precision since the
+  // combined frustum is nearly the same as each eye's.
+  bool stereo = currentRender.subrender->outputType ==
+                Subrender::OutputType::StereoscopicInstanced;
+  Frustum stereoFrustum;
+  if (stereo) {
+    context.stereo = true;
+    glm::dmat4 inverseViewProjection =
+        glm::inverse(glm::dmat4(projection * view));
+    for (int i = 0; i < 2; i++) {
+      vr::EVREye eye = i == 0 ? vr::EVREye::Eye_Left : vr::EVREye::Eye_Right;
+      glm::mat4x4 eyeViewProjection =
+          currentRender.subrender->camera->GetProjectionMatrix(eye) *
+          currentRender.subrender->camera->GetViewMatrix(eye);
+      context.stereoReprojections[i] = glm::mat4x4(
+          glm::dmat4(eyeViewProjection) * inverseViewProjection);
+    }
+    stereoFrustum = Frustum::FromMatrix(projection * view);
+  }
+
+  // Find what's seen through the portals of the camera's cell. Shadow maps
+  // aren't portal culled, since lights may see what the camera doesn't, and
+  // neither is single-pass stereo, whose combined frustum's origin isn't
+  // where either eye looks through portals from.
+  bool portalCulling =
+      portalVisibility.GetCellCount() > 0 && !stereo &&
+      currentRender.subrender->outputType != Subrender::OutputType::Depthmap;
+  if (portalCulling) {
+    portalVisibility.Update(cameraPos, projection * view);
+  }
+
+  // Rasterize the occluders on the CPU for occlusion culling. This isn't
+  // done for shadow maps, or for single-pass stereo, where the combined
+  // view doesn't see around occluders quite like either eye does.
+  bool occlusionCulling =
+      occlusionCuller.options.enabled && !stereo &&
+      currentRender.subrender->outputType != Subrender::OutputType::Depthmap;
+  if (occlusionCulling) {
+    occlusionCuller.Begin(projection * view);
+    for (auto &currentModel : currentRender.models) {
+      Model *model = currentModel.model;
+      if (model->occluder == nullptr ||
+          !(model->layer & currentRender.subrender->layerMask)) {
+        continue;
       }
+      occlusionCuller.RasterizeOccluder(*model->occluder,
+                                        model->ModelMatrix());
     }
+    occlusionCuller.Finish();
+  }
+
+  // Likewise, GPU occlusion queries are only issued for camera views drawn
+  // one eye at a time.
+  bool occlusionQuerying =
+      occlusionQueries.options.enabled && !stereo &&
+      currentRender.subrender->outputType != Subrender::OutputType::Depthmap;
+  if (occlusionQuerying) {
+    occlusionQueries.BeginView(currentRender.subrender);
   }
 
   // Render models.
@@ -466,37 +1030,83 @@ void dg::Scene::DrawScene() {
       continue;
     }
 
-    // Use either the model's assigned material or the subrender's material
-    // override if not null.
-    std::shared_ptr<Material> sharedMaterial;
-    if (currentRender.subrender->material == nullptr) {
-      sharedMaterial = (*currentModel.model).material;
-    } else {
-      sharedMaterial = currentRender.subrender->material;
+    if (stereo &&
+        !stereoFrustum.Intersects(currentModel.model->SceneBounds())) {
+      continue;
     }
-    Material *material = sharedMaterial.get();
 
-    // Check to see if this subrender intends to replace the chosen material's
-    // shader with another shader.
-    auto shaderReplacement = currentRender.subrender->shaderReplacements.find(
-        sharedMaterial->shader.get());
-    ShaderReplacedMaterial shaderReplacedMaterial;
-    if (shaderReplacement !=
-        currentRender.subrender->shaderReplacements.end()) {
-      shaderReplacedMaterial =
-          ShaderReplacedMaterial(sharedMaterial, shaderReplacement->second);
-      material = &shaderReplacedMaterial;
+    if (portalCulling &&
+        !portalVisibility.IsVisible(currentModel.model->SceneBounds())) {
+      continue;
     }
 
-    // Draw the model with the context and material.
-    (*currentModel.model).Draw(context, material);
+    if (occlusionCulling &&
+        !occlusionCuller.IsVisible(currentModel.model->SceneBounds())) {
+      continue;
+    }
+
+    if (occlusionQuerying) {
+      occlusionQueries.Draw(*currentModel.model, projection * view, [&]() {
+        DrawModel(*currentModel.model, context, *currentRender.subrender);
+      });
+    } else {
+      DrawModel(*currentModel.model, context, *currentRender.subrender);
+    }
+  }
+
+  if (occlusionQuerying) {
+    occlusionQueries.EndView();
   }
 }
 
+void dg::Scene::PrepareLights(const glm::mat4x4 &view,
+                              const glm::mat4x4 &projection, float nearClip,
+                              float farClip) {
+  // The fixed-size light array is still sent for shaders that don't use
+  // clustered lighting, and holds only the first MAX_LIGHTS.
+  FrameVector<Light::ShaderData> allLights;
+  allLights.reserve(currentRender.lights.size());
+  int lightIdx = 0;
+  for (auto &light : currentRender.lights) {
+    allLights.push_back((*light).GetShaderData());
+    if (lightIdx < Light::MAX_LIGHTS) {
+      lightArray[lightIdx++] = allLights.back();
+    }
+  }
+  for (; lightIdx < Light::MAX_LIGHTS; lightIdx++) {
+    lightArray[lightIdx] = Light::ShaderData();
+  }
+
+#if defined(_OPENGL)
+  // Upload the light array once for every model drawn in this subrender.
+  // Allocating new storage lets the driver keep the previous subrender's
+  // lights alive for draws still in flight, instead of waiting on them.
+  lightBuffer.Allocate(sizeof(lightArray), lightArray);
+  lightBuffer.Bind(
+      OpenGLShader::GetUniformBlockBinding(Light::LIGHTS_BLOCK_NAME));
+
+  // Assign all lights to clusters of this view for the clustered shaders.
+  lightClusters.Build(view, projection, nearClip, farClip, allLights.data(),
+                      allLights.size());
+  lightClusters.UploadTextures();
+#endif
+}
+
 bool dg::Scene::AutomaticWindowTitle() const {
   return true;
 }
 
+void dg::Scene::SetStereoViewport(int eye) {
+  const FrameBuffer &framebuffer = *currentRender.subrender->framebuffer;
+  int width = framebuffer.GetWidth();
+  int height = framebuffer.GetHeight();
+  if (eye < 0) {
+    Graphics::Instance->SetViewport(0, 0, width, height);
+  } else {
+    Graphics::Instance->SetViewport(eye * width / 2, 0, width / 2, height);
+  }
+}
+
 void dg::Scene::DrawHiddenAreaMesh(vr::EVREye eye) {
   auto mesh = VRManager::Instance->GetHiddenAreaMesh(eye);
   if (mesh != nullptr && mesh->IsDrawable()) {
@@ -4,10 +4,12 @@
 
 #include "dg/SceneObject.h"
 
+#include <vector>
 #include <glm/gtc/matrix_transform.hpp>
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/quaternion.hpp>
 #include <glm/gtc/constants.hpp>
+#include "dg/FrameAllocator.h"
 
 dg::SceneObject::SceneObject(Transform transform) : transform(transform) {}
 
@@ -64,8 +66,34 @@ void dg::SceneObject::CacheSceneSpace() {
     xfCachedSceneSpace = parent->xfCachedSceneSpace * transform;
   }
 
+  // Cache the descendants one level of the hierarchy at a time, so that each
+  // level's transforms are composed together in one batch.
+  FrameVector<SceneObject *> level;
+  FrameVector<SceneObject *> nextLevel;
+  FrameVector<Transform> parentSpaces;
+  FrameVector<Transform> localSpaces;
   for (auto &child : children) {
-    child->CacheSceneSpace();
+    level.push_back(child.get());
+  }
+  while (!level.empty()) {
+    size_t count = level.size();
+    parentSpaces.resize(count);
+    localSpaces.resize(count);
+    for (size_t i = 0; i < count; i++) {
+      parentSpaces[i] = level[i]->parent->xfCachedSceneSpace;
+      localSpaces[i] = level[i]->transform;
+    }
+    Transform::Multiply(parentSpaces.data(), localSpaces.data(),
+                        parentSpaces.data(), count);
+
+    nextLevel.clear();
+    for (size_t i = 0; i < count; i++) {
+      level[i]->xfCachedSceneSpace = parentSpaces[i];
+      for (auto &child : level[i]->children) {
+        nextLevel.push_back(child.get());
+      }
+    }
+    level.swap(nextLevel);
   }
 }
 
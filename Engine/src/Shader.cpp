@@ -3,6 +3,7 @@
 //
 
 #include "dg/Shader.h"
+#include <algorithm>
 #include <cassert>
 #include <glm/gtc/type_ptr.hpp>
 #include <memory>
@@ -10,6 +11,105 @@
 #include "dg/FileUtils.h"
 #include "dg/Utils.h"
 
+#if defined(_OPENGL)
+#include "dg/Graphics.h"
+#include "dg/opengl/ProgramBinaryCache.h"
+
+// Parallel shader compilation isn't in GLAD's GL 3.3 headers.
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+// Compute shaders, image load/store and program interface queries are core
+// in GL 4.3, which GLAD wasn't generated for either.
+#ifndef GL_COMPUTE_SHADER
+#define GL_COMPUTE_SHADER 0x91B9
+#endif
+#ifndef GL_SHADER_STORAGE_BLOCK
+#define GL_SHADER_STORAGE_BLOCK 0x92E6
+#endif
+#ifndef GL_ACTIVE_RESOURCES
+#define GL_ACTIVE_RESOURCES 0x92F5
+#endif
+#ifndef GL_MAX_NAME_LENGTH
+#define GL_MAX_NAME_LENGTH 0x92F6
+#endif
+#ifndef GL_MAX_SHADER_STORAGE_BUFFER_BINDINGS
+#define GL_MAX_SHADER_STORAGE_BUFFER_BINDINGS 0x90DD
+#endif
+
+namespace {
+
+  typedef void (APIENTRYP DispatchComputeProc)(GLuint numGroupsX,
+                                               GLuint numGroupsY,
+                                               GLuint numGroupsZ);
+  typedef void (APIENTRYP BindImageTextureProc)(GLuint unit, GLuint texture,
+                                                GLint level,
+                                                GLboolean layered,
+                                                GLint layer, GLenum access,
+                                                GLenum format);
+  typedef void (APIENTRYP GetProgramInterfaceivProc)(GLuint program,
+                                                     GLenum programInterface,
+                                                     GLenum pname,
+                                                     GLint *params);
+  typedef void (APIENTRYP GetProgramResourceNameProc)(
+      GLuint program, GLenum programInterface, GLuint index, GLsizei bufSize,
+      GLsizei *length, GLchar *name);
+  typedef void (APIENTRYP ShaderStorageBlockBindingProc)(
+      GLuint program, GLuint storageBlockIndex,
+      GLuint storageBlockBinding);
+
+  struct ComputeProcs {
+    DispatchComputeProc dispatchCompute = nullptr;
+    BindImageTextureProc bindImageTexture = nullptr;
+    GetProgramInterfaceivProc getProgramInterfaceiv = nullptr;
+    GetProgramResourceNameProc getProgramResourceName = nullptr;
+    ShaderStorageBlockBindingProc shaderStorageBlockBinding = nullptr;
+  };
+
+  // Compute, image and storage block functions, all nullptr if the context
+  // doesn't support them.
+  const ComputeProcs &GetComputeProcs() {
+    static ComputeProcs procs = []() {
+      ComputeProcs procs;
+      if (!dg::Graphics::Instance->SupportsCompute()) {
+        return procs;
+      }
+      procs.dispatchCompute =
+          (DispatchComputeProc)glfwGetProcAddress("glDispatchCompute");
+      procs.bindImageTexture =
+          (BindImageTextureProc)glfwGetProcAddress("glBindImageTexture");
+      procs.getProgramInterfaceiv = (GetProgramInterfaceivProc)
+          glfwGetProcAddress("glGetProgramInterfaceiv");
+      procs.getProgramResourceName = (GetProgramResourceNameProc)
+          glfwGetProcAddress("glGetProgramResourceName");
+      procs.shaderStorageBlockBinding = (ShaderStorageBlockBindingProc)
+          glfwGetProcAddress("glShaderStorageBlockBinding");
+      if (procs.dispatchCompute == nullptr ||
+          procs.bindImageTexture == nullptr ||
+          procs.getProgramInterfaceiv == nullptr ||
+          procs.getProgramResourceName == nullptr ||
+          procs.shaderStorageBlockBinding == nullptr) {
+        procs = ComputeProcs();
+      }
+      return procs;
+    }();
+    return procs;
+  }
+
+  // Whether the driver can report a program's completion without waiting.
+  bool SupportsParallelCompile() {
+    static const bool supported =
+        dg::Graphics::Instance->SupportsExtension(
+            "GL_KHR_parallel_shader_compile") ||
+        dg::Graphics::Instance->SupportsExtension(
+            "GL_ARB_parallel_shader_compile");
+    return supported;
+  }
+
+} // namespace
+#endif
+
 #if defined(_DIRECTX)
 // For the DirectX Math library
 using namespace DirectX;
@@ -17,53 +117,117 @@ using namespace DirectX;
 
 #pragma region Base Class
 
+std::map<dg::Shader::ProgramKey, std::weak_ptr<dg::Shader>>
+    dg::Shader::programs;
+
 std::shared_ptr<dg::Shader> dg::Shader::FromFiles(
     const std::string& vertexPath, const std::string& fragmentPath) {
-#if defined(_OPENGL)
-  return std::static_pointer_cast<Shader>(
-    OpenGLShader::FromFiles(vertexPath, fragmentPath));
-#elif defined(_DIRECTX)
-  return std::static_pointer_cast<Shader>(
-    DirectXShader::FromFiles(vertexPath, fragmentPath));
-#endif
+  return Load(ProgramKey(vertexPath, std::string(), fragmentPath,
+                         std::string(), {}));
 }
 
 std::shared_ptr<dg::Shader> dg::Shader::FromFiles(
     const std::string &vertexPath, const std::string &geometryPath,
     const std::string &fragmentPath) {
 #if defined(_OPENGL)
-  return std::static_pointer_cast<Shader>(
-    OpenGLShader::FromFiles(vertexPath, geometryPath, fragmentPath));
+  return Load(ProgramKey(vertexPath, geometryPath, fragmentPath,
+                         std::string(), {}));
 #elif defined(_DIRECTX)
   throw EngineError("TODO: Implement support for DirectX geometry shaders.");
 #endif
 }
 
-#pragma endregion
+std::shared_ptr<dg::Shader> dg::Shader::FromComputeFile(
+    const std::string& computePath) {
+#if defined(_OPENGL)
+  if (!Graphics::Instance->SupportsCompute()) {
+    throw EngineError("Compute shaders require OpenGL 4.3, or the "
+                      "ARB_compute_shader family of extensions.");
+  }
+  return Load(ProgramKey(std::string(), std::string(), std::string(),
+                         computePath, {}));
+#elif defined(_DIRECTX)
+  throw EngineError("TODO: Implement support for DirectX compute shaders.");
+#endif
+}
+
+std::shared_ptr<dg::Shader> dg::Shader::Load(const ProgramKey& key) {
+  std::weak_ptr<Shader> &entry = programs[key];
+  std::shared_ptr<Shader> shader = entry.lock();
+  if (shader != nullptr) {
+    return shader;
+  }
+
+  // Drop the entries of other shaders no longer in use while here, since
+  // new shaders are rarely built.
+  for (auto it = programs.begin(); it != programs.end();) {
+    if (&it->second != &entry && it->second.expired()) {
+      it = programs.erase(it);
+    } else {
+      it++;
+    }
+  }
 
 #if defined(_OPENGL)
-#pragma region OpenGL Shader
+  auto glShader = std::make_shared<OpenGLShader>();
+  glShader->vertexPath = std::get<0>(key);
+  glShader->geometryPath = std::get<1>(key);
+  glShader->fragmentPath = std::get<2>(key);
+  glShader->computePath = std::get<3>(key);
+  glShader->keywords = std::get<4>(key);
+  glShader->CreateProgram();
+  shader = glShader;
+#elif defined(_DIRECTX)
+  shader = DirectXShader::FromFiles(std::get<0>(key), std::get<2>(key));
+#endif
 
-std::shared_ptr<dg::OpenGLShader> dg::OpenGLShader::FromFiles(
-    const std::string& vertexPath, const std::string& fragmentPath) {
-  auto shader = std::make_shared<OpenGLShader>();
-  shader->vertexPath = vertexPath;
-  shader->fragmentPath = fragmentPath;
-  shader->CreateProgram();
+  entry = shader;
   return shader;
 }
 
-std::shared_ptr<dg::OpenGLShader> dg::OpenGLShader::FromFiles(
-    const std::string &vertexPath, const std::string &geometryPath,
-    const std::string &fragmentPath) {
-  auto shader = std::make_shared<OpenGLShader>();
-  shader->vertexPath = vertexPath;
-  shader->geometryPath = geometryPath;
-  shader->fragmentPath = fragmentPath;
-  shader->CreateProgram();
-  return shader;
+uint64_t dg::Shader::HashUniformName(const std::string& name) {
+  // 64-bit FNV-1a.
+  uint64_t hash = 14695981039346656037ull;
+  for (char c : name) {
+    hash ^= (uint8_t)c;
+    hash *= 1099511628211ull;
+  }
+  return hash == 0 ? 1 : hash;
+}
+
+void dg::Shader::FinishAll() {
+  for (auto &program : programs) {
+    std::shared_ptr<Shader> shader = program.second.lock();
+    if (shader != nullptr) {
+      shader->Finish();
+    }
+  }
 }
 
+std::shared_ptr<dg::Shader> dg::Shader::GetVariant(
+    const std::vector<std::string>& keywords) {
+  assert(std::is_sorted(keywords.begin(), keywords.end()));
+#if defined(_OPENGL)
+  if (keywords.empty() || keywords == this->keywords) {
+    return shared_from_this();
+  }
+
+  std::shared_ptr<Shader> &variant = variants[keywords];
+  if (variant == nullptr) {
+    variant = Load(ProgramKey(vertexPath, geometryPath, fragmentPath,
+                              computePath, keywords));
+  }
+  return variant;
+#elif defined(_DIRECTX)
+  return shared_from_this();
+#endif
+}
+
+#pragma endregion
+
+#if defined(_OPENGL)
+#pragma region OpenGL Shader
+
 dg::OpenGLShader::~OpenGLShader() {
   if (programHandle != 0) {
     glDeleteProgram(programHandle);
@@ -75,20 +239,74 @@ void dg::OpenGLShader::CreateProgram() {
   assert(programHandle == 0);
 
   std::vector<std::shared_ptr<ShaderSource>> sources;
-  sources.push_back(dg::ShaderSource::FromFile(GL_VERTEX_SHADER, vertexPath));
-  if (!geometryPath.empty()) {
+  if (!computePath.empty()) {
+    sources.push_back(dg::ShaderSource::FromFile(GL_COMPUTE_SHADER,
+                                                 computePath, keywords));
+  } else {
     sources.push_back(
-        dg::ShaderSource::FromFile(GL_GEOMETRY_SHADER, geometryPath));
+        dg::ShaderSource::FromFile(GL_VERTEX_SHADER, vertexPath, keywords));
+    if (!geometryPath.empty()) {
+      sources.push_back(dg::ShaderSource::FromFile(GL_GEOMETRY_SHADER,
+                                                   geometryPath, keywords));
+    }
+    sources.push_back(dg::ShaderSource::FromFile(GL_FRAGMENT_SHADER,
+                                                 fragmentPath, keywords));
   }
-  sources.push_back(
-      dg::ShaderSource::FromFile(GL_FRAGMENT_SHADER, fragmentPath));
 
+  cacheKey = ProgramBinaryCache::GetKey(sources);
+  programHandle = glCreateProgram();
+  if (ProgramBinaryCache::Load(programHandle, cacheKey)) {
+    Finish();
+    return;
+  }
+
+  // A program the driver failed to load a binary into is left unlinked,
+  // so start over with a fresh one.
+  glDeleteProgram(programHandle);
   programHandle = glCreateProgram();
   for (auto &source : sources) {
+    source->Compile();
     glAttachShader(programHandle, source->GetHandle());
   }
+  ProgramBinaryCache::PrepareToLink(programHandle);
   glLinkProgram(programHandle);
-  CheckLinkErrors();
+  pendingSources = sources;
+}
+
+bool dg::OpenGLShader::IsReady() {
+  if (finished) {
+    return true;
+  }
+  if (!SupportsParallelCompile()) {
+    return false;
+  }
+  GLint completed = 0;
+  glGetProgramiv(programHandle, GL_COMPLETION_STATUS_KHR, &completed);
+  return completed != 0;
+}
+
+void dg::OpenGLShader::Finish() {
+  if (finished) {
+    return;
+  }
+
+  GLint success = 0;
+  glGetProgramiv(programHandle, GL_LINK_STATUS, &success);
+  if (!success) {
+    // Report the first stage that failed to compile, if any did, since
+    // that's what failed the link.
+    for (auto &source : pendingSources) {
+      source->CheckCompileErrors();
+    }
+    CheckLinkErrors();
+  }
+
+  if (!pendingSources.empty()) {
+    ProgramBinaryCache::Store(programHandle, cacheKey);
+    pendingSources.clear();
+  }
+  ReflectUniforms();
+  finished = true;
 }
 
 void dg::OpenGLShader::CheckLinkErrors() {
@@ -102,11 +320,249 @@ void dg::OpenGLShader::CheckLinkErrors() {
 }
 
 void dg::OpenGLShader::Use() {
+  Finish();
   glUseProgram(programHandle);
 }
 
+void dg::OpenGLShader::Dispatch(unsigned int groupsX, unsigned int groupsY,
+                                unsigned int groupsZ) {
+  assert(!computePath.empty());
+  Use();
+  GetComputeProcs().dispatchCompute(groupsX, groupsY, groupsZ);
+}
+
+void dg::OpenGLShader::ReflectUniforms() {
+  ReflectUniformBlocks();
+  ReflectStorageBlocks();
+
+  GLint count = 0;
+  GLint maxLength = 0;
+  glGetProgramiv(programHandle, GL_ACTIVE_UNIFORMS, &count);
+  glGetProgramiv(programHandle, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+  std::vector<GLchar> buffer(std::max(maxLength, 1));
+
+  std::vector<std::pair<std::string, GLint>> uniforms;
+  for (GLint i = 0; i < count; i++) {
+    GLsizei length = 0;
+    GLint size = 0;
+    GLenum type = 0;
+    glGetActiveUniform(programHandle, i, (GLsizei)buffer.size(), &length,
+                       &size, &type, buffer.data());
+    std::string name(buffer.data(), length);
+
+    // Arrays are listed once, as "name[0]". Their elements may also be set
+    // as "name[i]", and the first as just "name".
+    const std::string firstElement = "[0]";
+    std::string arrayName;
+    if (name.size() > firstElement.size() &&
+        name.compare(name.size() - firstElement.size(), firstElement.size(),
+                     firstElement) == 0) {
+      arrayName = name.substr(0, name.size() - firstElement.size());
+    }
+
+    // Members of uniform blocks have no location, but an offset into their
+    // block's buffer.
+    GLuint index = (GLuint)i;
+    GLint blockIndex = -1;
+    glGetActiveUniformsiv(programHandle, 1, &index, GL_UNIFORM_BLOCK_INDEX,
+                          &blockIndex);
+    if (blockIndex >= 0) {
+      GLint offset = 0;
+      GLint arrayStride = 0;
+      glGetActiveUniformsiv(programHandle, 1, &index, GL_UNIFORM_OFFSET,
+                            &offset);
+      glGetActiveUniformsiv(programHandle, 1, &index,
+                            GL_UNIFORM_ARRAY_STRIDE, &arrayStride);
+      UniformBlock &block = *uniformBlocks[blockIndex];
+      block.offsets[HashUniformName(name)] = offset;
+      if (!arrayName.empty()) {
+        block.offsets[HashUniformName(arrayName)] = offset;
+        block.arrayStrides[HashUniformName(arrayName)] = arrayStride;
+        for (GLint element = 1; element < size; element++) {
+          std::string elementName =
+              arrayName + "[" + std::to_string(element) + "]";
+          block.offsets[HashUniformName(elementName)] =
+              offset + element * arrayStride;
+        }
+      }
+      continue;
+    }
+
+    GLint location = glGetUniformLocation(programHandle, name.c_str());
+    if (location < 0) {
+      continue;
+    }
+    uniforms.push_back({ name, location });
+
+    if (!arrayName.empty()) {
+      uniforms.push_back({ arrayName, location });
+      for (GLint element = 1; element < size; element++) {
+        std::string elementName =
+            arrayName + "[" + std::to_string(element) + "]";
+        GLint elementLocation =
+            glGetUniformLocation(programHandle, elementName.c_str());
+        if (elementLocation >= 0) {
+          uniforms.push_back({ elementName, elementLocation });
+        }
+      }
+    }
+  }
+
+  // Blocks declared the same way in different programs get the same
+  // layout hash, regardless of the order their members were listed in.
+  for (auto &block : uniformBlocks) {
+    std::vector<std::pair<uint64_t, GLint>> members(block->offsets.begin(),
+                                                   block->offsets.end());
+    std::sort(members.begin(), members.end());
+    size_t layoutHash = std::hash<uint64_t>()(block->nameHash);
+    std::hash_combine(layoutHash, block->size);
+    for (auto &member : members) {
+      std::hash_combine(layoutHash, member.first);
+      std::hash_combine(layoutHash, member.second);
+    }
+    block->layoutHash = (uint64_t)layoutHash;
+  }
+
+  size_t slotCount = 16;
+  while (slotCount < uniforms.size() * 2) {
+    slotCount *= 2;
+  }
+  uniformSlots.assign(slotCount, UniformSlot());
+  for (auto &uniform : uniforms) {
+    uint64_t nameHash = HashUniformName(uniform.first);
+    size_t i = nameHash & (slotCount - 1);
+    while (uniformSlots[i].nameHash != 0) {
+      assert(uniformSlots[i].nameHash != nameHash);
+      i = (i + 1) & (slotCount - 1);
+    }
+    uniformSlots[i].nameHash = nameHash;
+    uniformSlots[i].location = uniform.second;
+  }
+}
+
+void dg::OpenGLShader::ReflectUniformBlocks() {
+  GLint count = 0;
+  GLint maxLength = 0;
+  glGetProgramiv(programHandle, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+  glGetProgramiv(programHandle, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH,
+                 &maxLength);
+  std::vector<GLchar> buffer(std::max(maxLength, 1));
+
+  for (GLint i = 0; i < count; i++) {
+    GLsizei length = 0;
+    glGetActiveUniformBlockName(programHandle, i, (GLsizei)buffer.size(),
+                                &length, buffer.data());
+    GLint size = 0;
+    glGetActiveUniformBlockiv(programHandle, i, GL_UNIFORM_BLOCK_DATA_SIZE,
+                              &size);
+
+    auto block = std::make_shared<UniformBlock>();
+    block->name = std::string(buffer.data(), length);
+    block->nameHash = HashUniformName(block->name);
+    block->index = (GLuint)i;
+    block->binding = GetUniformBlockBinding(block->name);
+    block->size = size;
+    glUniformBlockBinding(programHandle, block->index, block->binding);
+    uniformBlocks.push_back(block);
+    blockBuffers.push_back(nullptr);
+  }
+}
+
+void dg::OpenGLShader::ReflectStorageBlocks() {
+  const ComputeProcs &procs = GetComputeProcs();
+  if (procs.getProgramInterfaceiv == nullptr) {
+    return;
+  }
+
+  GLint count = 0;
+  GLint maxLength = 0;
+  procs.getProgramInterfaceiv(programHandle, GL_SHADER_STORAGE_BLOCK,
+                              GL_ACTIVE_RESOURCES, &count);
+  procs.getProgramInterfaceiv(programHandle, GL_SHADER_STORAGE_BLOCK,
+                              GL_MAX_NAME_LENGTH, &maxLength);
+  std::vector<GLchar> buffer(std::max(maxLength, 1));
+
+  for (GLint i = 0; i < count; i++) {
+    GLsizei length = 0;
+    procs.getProgramResourceName(programHandle, GL_SHADER_STORAGE_BLOCK, i,
+                                 (GLsizei)buffer.size(), &length,
+                                 buffer.data());
+    std::string name(buffer.data(), length);
+    GLuint binding = GetStorageBlockBinding(name);
+    procs.shaderStorageBlockBinding(programHandle, (GLuint)i, binding);
+    storageBlockBindings[HashUniformName(name)] = binding;
+  }
+}
+
+GLuint dg::OpenGLShader::GetUniformBlockBinding(
+    const std::string &blockName) {
+  static std::unordered_map<std::string, GLuint> bindings;
+  auto it = bindings.find(blockName);
+  if (it != bindings.end()) {
+    return it->second;
+  }
+
+  GLint maxBindings = 0;
+  glGetIntegerv(GL_MAX_UNIFORM_BUFFER_BINDINGS, &maxBindings);
+  if (bindings.size() >= (size_t)maxBindings) {
+    throw EngineError("Too many distinct uniform blocks. Only " +
+                      std::to_string(maxBindings) +
+                      " binding points are available.");
+  }
+  GLuint binding = (GLuint)bindings.size();
+  bindings[blockName] = binding;
+  return binding;
+}
+
+GLuint dg::OpenGLShader::GetStorageBlockBinding(
+    const std::string &blockName) {
+  static std::unordered_map<std::string, GLuint> bindings;
+  auto it = bindings.find(blockName);
+  if (it != bindings.end()) {
+    return it->second;
+  }
+
+  GLint maxBindings = 0;
+  glGetIntegerv(GL_MAX_SHADER_STORAGE_BUFFER_BINDINGS, &maxBindings);
+  if (bindings.size() >= (size_t)maxBindings) {
+    throw EngineError("Too many distinct storage blocks. Only " +
+                      std::to_string(maxBindings) +
+                      " binding points are available.");
+  }
+  GLuint binding = (GLuint)bindings.size();
+  bindings[blockName] = binding;
+  return binding;
+}
+
+std::shared_ptr<const dg::OpenGLShader::UniformBlock>
+dg::OpenGLShader::GetUniformBlock(uint64_t nameHash) const {
+  assert(finished);
+  for (auto &block : uniformBlocks) {
+    if (block->nameHash == nameHash) {
+      return block;
+    }
+  }
+  return nullptr;
+}
+
 GLint dg::OpenGLShader::GetUniformLocation(const std::string& name) const {
-  return glGetUniformLocation(programHandle, name.c_str());
+  return GetUniformLocation(HashUniformName(name));
+}
+
+GLint dg::OpenGLShader::GetUniformLocation(uint64_t nameHash) const {
+  assert(finished);
+  if (uniformSlots.empty()) {
+    return -1;
+  }
+  size_t mask = uniformSlots.size() - 1;
+  for (size_t i = nameHash & mask;; i = (i + 1) & mask) {
+    const UniformSlot &slot = uniformSlots[i];
+    if (slot.nameHash == nameHash) {
+      return slot.location;
+    } else if (slot.nameHash == 0) {
+      return -1;
+    }
+  }
 }
 
 GLint dg::OpenGLShader::GetAttributeLocation(const std::string& name) const {
@@ -114,34 +570,33 @@ GLint dg::OpenGLShader::GetAttributeLocation(const std::string& name) const {
 }
 
 void dg::OpenGLShader::SetBool(const std::string& name, bool value) {
-  glUniform1i(GetUniformLocation(name), (int)value);
+  SetUniform(GetUniformLocation(name), value);
 }
 
 void dg::OpenGLShader::SetInt(const std::string& name, int value) {
-  glUniform1i(GetUniformLocation(name), (int)value);
+  SetUniform(GetUniformLocation(name), value);
 }
 
 void dg::OpenGLShader::SetFloat(const std::string& name, float value) {
-  glUniform1f(GetUniformLocation(name), value);
+  SetUniform(GetUniformLocation(name), value);
 }
 
 void dg::OpenGLShader::SetVec2(
     const std::string& name, const glm::vec2& value) {
-  glUniform2fv(GetUniformLocation(name), 1, glm::value_ptr(value));
+  SetUniform(GetUniformLocation(name), value);
 }
 
 void dg::OpenGLShader::SetVec3(
     const std::string& name, const glm::vec3& value) {
-  glUniform3fv(GetUniformLocation(name), 1, glm::value_ptr(value));
+  SetUniform(GetUniformLocation(name), value);
 }
 
 void dg::OpenGLShader::SetVec4(const std::string& name, const glm::vec4& value) {
-  glUniform4fv(GetUniformLocation(name), 1, glm::value_ptr(value));
+  SetUniform(GetUniformLocation(name), value);
 }
 
 void dg::OpenGLShader::SetMat4(const std::string& name, const glm::mat4& mat) {
-  glUniformMatrix4fv(
-      GetUniformLocation(name), 1, GL_FALSE, glm::value_ptr(mat));
+  SetUniform(GetUniformLocation(name), mat);
 }
 
 void dg::OpenGLShader::SetMat4(
@@ -152,16 +607,156 @@ void dg::OpenGLShader::SetMat4(
 
 void dg::OpenGLShader::SetTexture(
     unsigned int textureUnit, const std::string& name, const Texture *texture) {
+  SetTexture(textureUnit, GetUniformLocation(name), texture);
+}
+
+void dg::OpenGLShader::SetUniform(GLint location, bool value) {
+  if (location >= 0) {
+    glUniform1i(location, (int)value);
+  }
+}
+
+void dg::OpenGLShader::SetUniform(GLint location, int value) {
+  if (location >= 0) {
+    glUniform1i(location, value);
+  }
+}
+
+void dg::OpenGLShader::SetUniform(GLint location, float value) {
+  if (location >= 0) {
+    glUniform1f(location, value);
+  }
+}
+
+void dg::OpenGLShader::SetUniform(GLint location, const glm::vec2& value) {
+  if (location >= 0) {
+    glUniform2fv(location, 1, glm::value_ptr(value));
+  }
+}
+
+void dg::OpenGLShader::SetUniform(GLint location, const glm::vec3& value) {
+  if (location >= 0) {
+    glUniform3fv(location, 1, glm::value_ptr(value));
+  }
+}
+
+void dg::OpenGLShader::SetUniform(GLint location, const glm::vec4& value) {
+  if (location >= 0) {
+    glUniform4fv(location, 1, glm::value_ptr(value));
+  }
+}
+
+void dg::OpenGLShader::SetUniform(GLint location, const glm::mat4& mat) {
+  if (location >= 0) {
+    glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(mat));
+  }
+}
+
+void dg::OpenGLShader::SetUniform(GLint location, const float *values,
+                                  GLsizei count) {
+  if (location >= 0) {
+    glUniform1fv(location, count, values);
+  }
+}
+
+void dg::OpenGLShader::SetUniform(GLint location, const glm::vec2 *values,
+                                  GLsizei count) {
+  if (location >= 0) {
+    glUniform2fv(location, count, (const GLfloat *)values);
+  }
+}
+
+void dg::OpenGLShader::SetUniform(GLint location, const glm::vec3 *values,
+                                  GLsizei count) {
+  if (location >= 0) {
+    glUniform3fv(location, count, (const GLfloat *)values);
+  }
+}
+
+void dg::OpenGLShader::SetUniform(GLint location, const glm::vec4 *values,
+                                  GLsizei count) {
+  if (location >= 0) {
+    glUniform4fv(location, count, (const GLfloat *)values);
+  }
+}
+
+void dg::OpenGLShader::SetUniform(GLint location, const glm::mat4 *mats,
+                                  GLsizei count) {
+  if (location >= 0) {
+    glUniformMatrix4fv(location, count, GL_FALSE, (const GLfloat *)mats);
+  }
+}
+
+void dg::OpenGLShader::SetTexture(unsigned int textureUnit, GLint location,
+                                  const Texture *texture) {
   assert(texture != nullptr);
 
-  glActiveTexture(GL_TEXTURE0 + textureUnit);
-  glBindTexture(texture->GetOptions().GetOpenGLTarget(), texture->GetHandle());
-  glUniform1i(GetUniformLocation(name), textureUnit);
+  // Textures of samplers the program doesn't have aren't bound at all.
+  if (location < 0) {
+    return;
+  }
+
+  Graphics::Instance->BindTexture(textureUnit, *texture);
+  glUniform1i(location, textureUnit);
+}
+
+void dg::OpenGLShader::SetImage(unsigned int imageUnit, GLint location,
+                                const Texture *texture, GLenum access,
+                                int level) {
+  assert(texture != nullptr);
+  assert(GetComputeProcs().bindImageTexture != nullptr);
+  if (location < 0) {
+    return;
+  }
+
+  // Cubemaps and arrays are bound with all their faces or layers.
+  TextureType type = texture->GetType();
+  GLboolean layered =
+      type == TextureType::CUBEMAP || type == TextureType::_2D_ARRAY;
+  GetComputeProcs().bindImageTexture(
+      imageUnit, texture->GetHandle(), level, layered, 0, access,
+      texture->GetOptions().GetOpenGLImageFormat());
+  glUniform1i(location, imageUnit);
+}
+
+void dg::OpenGLShader::SetImage(unsigned int imageUnit,
+                                const std::string& name,
+                                const Texture *texture, GLenum access,
+                                int level) {
+  SetImage(imageUnit, GetUniformLocation(name), texture, access, level);
+}
+
+void dg::OpenGLShader::SetStorageBuffer(const std::string& blockName,
+                                        const StorageBuffer& buffer) {
+  Finish();
+  auto it = storageBlockBindings.find(HashUniformName(blockName));
+  if (it != storageBlockBindings.end()) {
+    buffer.Bind(it->second);
+  }
 }
 
 void dg::OpenGLShader::SetData(
     const std::string& name, void *data, size_t size) {
-  throw std::runtime_error("OpenGLShader::SetData() not implemented.");
+  Finish();
+  uint64_t nameHash = HashUniformName(name);
+  for (size_t i = 0; i < uniformBlocks.size(); i++) {
+    const UniformBlock &block = *uniformBlocks[i];
+    if (block.nameHash != nameHash) {
+      continue;
+    }
+
+    // The data must already be laid out as std140, and may leave off the
+    // end of the block.
+    assert(size <= (size_t)block.size);
+    std::unique_ptr<UniformBuffer> &buffer = blockBuffers[i];
+    if (buffer == nullptr) {
+      buffer = std::make_unique<UniformBuffer>();
+      buffer->Allocate(block.size);
+    }
+    buffer->Update(0, data, size);
+    buffer->Bind(block.binding);
+    return;
+  }
 }
 
 #pragma endregion
@@ -197,6 +792,11 @@ void dg::DirectXShader::Use() {
   pixelShader->CopyAllBufferData();
 }
 
+void dg::DirectXShader::Dispatch(unsigned int groupsX, unsigned int groupsY,
+                                 unsigned int groupsZ) {
+  throw EngineError("TODO: Implement support for DirectX compute shaders.");
+}
+
 void dg::DirectXShader::SetBool(const std::string& name, bool value) {
   vertexShader->SetInt(name, value);
   pixelShader->SetInt(name, value);
@@ -3,6 +3,46 @@
 //
 
 #include "dg/ShaderReplacedMaterial.h"
+#include "dg/Utils.h"
+
+std::unordered_map<dg::ShaderReplacedMaterial::VariantKey,
+                   dg::ShaderReplacedMaterial::Variant,
+                   dg::ShaderReplacedMaterial::VariantKeyHash>
+    dg::ShaderReplacedMaterial::variants;
+
+std::size_t dg::ShaderReplacedMaterial::VariantKeyHash::operator()(
+    const VariantKey &key) const {
+  std::size_t hash = 0;
+  std::hash_combine(hash, key.first);
+  std::hash_combine(hash, key.second);
+  return hash;
+}
+
+const std::shared_ptr<dg::ShaderReplacedMaterial> &
+dg::ShaderReplacedMaterial::Get(const std::shared_ptr<Material> &material,
+                                const std::shared_ptr<Shader> &newShader) {
+  Variant &variant = variants[VariantKey(material.get(), newShader.get())];
+
+  // An expired source means this is a new material at the address of a
+  // destroyed one.
+  if (variant.material == nullptr || variant.source.expired()) {
+    // Drop the variants of other destroyed materials while here, since new
+    // variants are rarely created.
+    for (auto it = variants.begin(); it != variants.end();) {
+      if (&it->second != &variant && it->second.source.expired()) {
+        it = variants.erase(it);
+      } else {
+        it++;
+      }
+    }
+
+    variant.source = material;
+    variant.material =
+        std::make_shared<ShaderReplacedMaterial>(material, newShader);
+  }
+
+  return variant.material;
+}
 
 dg::ShaderReplacedMaterial::ShaderReplacedMaterial(
     std::shared_ptr<Material> material, std::shared_ptr<Shader> newShader)
@@ -12,7 +52,7 @@ dg::ShaderReplacedMaterial::ShaderReplacedMaterial(
 
 dg::ShaderReplacedMaterial::ShaderReplacedMaterial(
     ShaderReplacedMaterial &other)
-    : Material(other) {}
+    : Material(other), material(other.material) {}
 
 dg::ShaderReplacedMaterial::ShaderReplacedMaterial(
     ShaderReplacedMaterial &&other) {
@@ -38,5 +78,10 @@ void dg::swap(ShaderReplacedMaterial &first, ShaderReplacedMaterial &second) {
 }
 
 void dg::ShaderReplacedMaterial::SendShaderProperties() const {
-  (*material).SendShaderProperties();
+  // The source's properties are sent to this material's shader, not the
+  // source's.
+  std::shared_ptr<Material> source = material.lock();
+  if (source != nullptr) {
+    source->SendProperties(GetActiveShader());
+  }
 }
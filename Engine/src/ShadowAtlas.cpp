@@ -0,0 +1,143 @@
+//
+//  ShadowAtlas.cpp
+//
+
+#include "dg/ShadowAtlas.h"
+#include <algorithm>
+#include <glm/gtc/matrix_transform.hpp>
+#include <iostream>
+
+namespace {
+
+  // Largest power of two less than or equal to x, or 0 if x is 0.
+  unsigned int FloorPowerOfTwo(unsigned int x) {
+    unsigned int result = 0;
+    for (unsigned int p = 1; p != 0 && p <= x; p <<= 1) {
+      result = p;
+    }
+    return result;
+  }
+
+} // namespace
+
+const unsigned int dg::ShadowAtlas::MIN_REGION_SIZE;
+
+dg::ShadowAtlas::ShadowAtlas(unsigned int size) : size(size) {}
+
+bool dg::ShadowAtlas::Pack(const Request *requests, size_t count) {
+  bool unchanged =
+      count == packedRequests.size() &&
+      std::equal(requests, requests + count, packedRequests.begin(),
+                 [](const Request &a, const Request &b) {
+                   return a.light == b.light && a.resolution == b.resolution;
+                 });
+  if (unchanged) {
+    return false;
+  }
+  packedRequests.assign(requests, requests + count);
+
+  // Allocate the largest regions first so smaller ones fill in the gaps.
+  std::vector<Request> sorted = packedRequests;
+  std::stable_sort(sorted.begin(), sorted.end(),
+                   [](const Request &a, const Request &b) {
+                     return a.resolution > b.resolution;
+                   });
+
+  regions.clear();
+  freeSquares.clear();
+  unsigned int rootSize = FloorPowerOfTwo(size);
+  if (rootSize >= MIN_REGION_SIZE) {
+    freeSquares.push_back({ 0, 0, rootSize });
+  }
+
+  for (const Request &request : sorted) {
+    unsigned int resolution = std::min(
+        FloorPowerOfTwo(std::max(request.resolution, MIN_REGION_SIZE)),
+        rootSize);
+
+    Square square;
+    bool allocated = Allocate(resolution, square);
+    while (!allocated && resolution > MIN_REGION_SIZE) {
+      resolution /= 2;
+      allocated = Allocate(resolution, square);
+    }
+
+    if (!allocated) {
+      std::cerr << "Warning: Shadow atlas is full. A light will not cast "
+                   "shadows."
+                << std::endl;
+      continue;
+    }
+
+    if (square.size < request.resolution) {
+      std::cerr << "Warning: Shadow atlas is too full for a "
+                << request.resolution << "x" << request.resolution
+                << " shadow map. Reduced to " << square.size << "x"
+                << square.size << "." << std::endl;
+    }
+
+    Region region;
+    region.light = request.light;
+    region.x = square.x;
+    region.y = square.y;
+    region.size = square.size;
+    regions.push_back(region);
+  }
+
+  return true;
+}
+
+void dg::ShadowAtlas::Invalidate() {
+  for (Region &region : regions) {
+    region.staticValid = false;
+  }
+}
+
+unsigned int dg::ShadowAtlas::GetSize() const {
+  return size;
+}
+
+std::vector<dg::ShadowAtlas::Region> &dg::ShadowAtlas::GetRegions() {
+  return regions;
+}
+
+glm::mat4x4 dg::ShadowAtlas::RegionTransform(const Region &region) const {
+  // A light's NDC x in [-1, 1] maps to atlas texture coordinate
+  // offset + (x * 0.5 + 0.5) * scale, which in the atlas's NDC is
+  // x * scale + (2 * offset + scale - 1). Depth is left untouched.
+  float scale = (float)region.size / size;
+  glm::vec2 offset = glm::vec2(region.x, region.y) / (float)size;
+  glm::vec2 translation = 2.f * offset + glm::vec2(scale - 1);
+  return glm::translate(glm::mat4x4(1), glm::vec3(translation, 0)) *
+         glm::scale(glm::mat4x4(1), glm::vec3(scale, scale, 1));
+}
+
+bool dg::ShadowAtlas::Allocate(unsigned int squareSize, Square &square) {
+  // Take the smallest free square that fits, to keep large squares intact
+  // for later requests.
+  auto best = freeSquares.end();
+  for (auto it = freeSquares.begin(); it != freeSquares.end(); it++) {
+    if (it->size >= squareSize &&
+        (best == freeSquares.end() || it->size < best->size)) {
+      best = it;
+    }
+  }
+  if (best == freeSquares.end()) {
+    return false;
+  }
+
+  square = *best;
+  freeSquares.erase(best);
+
+  // Split down to the requested size, freeing the other three quadrants at
+  // each level.
+  while (square.size > squareSize) {
+    unsigned int half = square.size / 2;
+    freeSquares.push_back({ square.x + half, square.y, half });
+    freeSquares.push_back({ square.x, square.y + half, half });
+    freeSquares.push_back({ square.x + half, square.y + half, half });
+    square.size = half;
+  }
+
+  return true;
+}
@@ -0,0 +1,199 @@
+//
+//  ShadowCascades.cpp
+//
+
+#include "dg/ShadowCascades.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
+#include <limits>
+#include "dg/Camera.h"
+
+const unsigned int dg::ShadowCascades::MAX_CASCADES;
+
+void dg::ShadowCascades::Fit(const Camera &camera, float aspectRatio,
+                             glm::vec3 lightDirection,
+                             const AABB &casterBounds) {
+  unsigned int newCount =
+      std::max(1u, std::min(options.count, MAX_CASCADES));
+  lightDirection = glm::normalize(lightDirection);
+
+  // Everything must be rendered again if the shadow maps were recreated or
+  // the light turned, since no cascade's cached depths are usable.
+  bool renderAll =
+      newCount != count || lightDirection != this->lightDirection;
+  if (framebuffer != nullptr &&
+      (framebuffer->GetOptions().layers != newCount ||
+       framebuffer->GetWidth() != options.resolution)) {
+    framebuffer = nullptr;
+  }
+  if (framebuffer == nullptr) {
+    renderAll = true;
+  }
+
+  count = newCount;
+  this->lightDirection = lightDirection;
+
+  glm::vec3 up = std::abs(lightDirection.y) > 0.99f ? glm::vec3(0, 0, 1)
+                                                    : glm::vec3(0, 1, 0);
+  view = glm::lookAt(glm::vec3(0), lightDirection, up);
+
+  // Split distances using the "practical split scheme" (Zhang et al.,
+  // "Parallel-Split Shadow Maps for Large-scale Virtual Environments").
+  float nearClip = camera.nearClip;
+  float farClip = std::max(nearClip, std::min(camera.farClip,
+                                              options.maxDistance));
+  for (unsigned int i = 0; i < count; i++) {
+    float fraction = (float)(i + 1) / count;
+    float logSplit = nearClip * std::pow(farClip / nearClip, fraction);
+    float uniformSplit = nearClip + (farClip - nearClip) * fraction;
+    cascades[i].splitDepth = options.splitLambda * logSplit +
+                             (1 - options.splitLambda) * uniformSplit;
+  }
+  for (unsigned int i = count; i < MAX_CASCADES; i++) {
+    cascades[i].splitDepth = 0;
+  }
+
+  // Half-extents of the camera's view at a distance of 1 for perspective
+  // cameras, or at any distance for orthographic cameras.
+  glm::vec2 halfExtents;
+  bool perspective = camera.projection == Camera::Projection::Perspective;
+  if (perspective) {
+    float tanHalfFov = std::tan(camera.fov * 0.5f);
+    halfExtents = glm::vec2(tanHalfFov * aspectRatio, tanHalfFov);
+  } else {
+    halfExtents = glm::vec2(camera.orthoWidth, camera.orthoHeight) * 0.5f;
+  }
+  glm::mat4x4 cameraToScene = camera.CachedSceneSpace().ToMat4();
+
+  // Light-space depth of the caster bounds nearest to the light.
+  float casterNearDepth = std::numeric_limits<float>::max();
+  if (!casterBounds.IsEmpty()) {
+    for (int corner = 0; corner < 8; corner++) {
+      glm::vec3 point = glm::vec3(
+          (corner & 1) ? casterBounds.max.x : casterBounds.min.x,
+          (corner & 2) ? casterBounds.max.y : casterBounds.min.y,
+          (corner & 4) ? casterBounds.max.z : casterBounds.min.z);
+      float depth = -(view * glm::vec4(point, 1)).z;
+      casterNearDepth = std::min(casterNearDepth, depth);
+    }
+  }
+
+  unsigned int interval = std::max(1u, options.distantUpdateInterval);
+  for (unsigned int i = 0; i < count; i++) {
+    Cascade &cascade = cascades[i];
+    cascade.needsRender =
+        renderAll || i == 0 || (frame + i) % interval == 0;
+    if (!cascade.needsRender) {
+      continue;
+    }
+
+    // Bounding sphere of this cascade's slice of the view frustum.
+    float sliceDepths[2] = {
+        i == 0 ? nearClip : cascades[i - 1].splitDepth,
+        cascade.splitDepth,
+    };
+    glm::vec3 corners[8];
+    glm::vec3 center = glm::vec3(0);
+    for (int corner = 0; corner < 8; corner++) {
+      float depth = sliceDepths[corner / 4];
+      glm::vec2 extents = perspective ? halfExtents * depth : halfExtents;
+      glm::vec3 viewPoint = glm::vec3(
+          (corner & 1) ? extents.x : -extents.x,
+          (corner & 2) ? extents.y : -extents.y, -depth);
+      corners[corner] = glm::vec3(cameraToScene * glm::vec4(viewPoint, 1));
+      center += corners[corner];
+    }
+    center /= 8.f;
+    float radius = 0;
+    for (const glm::vec3 &corner : corners) {
+      radius = std::max(radius, glm::distance(corner, center));
+    }
+
+    // Quantize the radius so that floating point error doesn't change the
+    // size of a texel from frame to frame, then snap the center to whole
+    // texels in light space.
+    radius = std::ceil(radius * 16.f) / 16.f;
+    float texelSize = 2.f * radius / options.resolution;
+    glm::vec3 lightCenter = glm::vec3(view * glm::vec4(center, 1));
+    lightCenter.x = std::floor(lightCenter.x / texelSize) * texelSize;
+    lightCenter.y = std::floor(lightCenter.y / texelSize) * texelSize;
+
+    // Pull the near plane back towards the light to include every caster
+    // that could shadow this cascade.
+    float nearDepth = -lightCenter.z - radius;
+    float farDepth = -lightCenter.z + radius;
+    nearDepth = std::min(nearDepth, casterNearDepth);
+
+    cascade.projection = glm::ortho(
+        lightCenter.x - radius, lightCenter.x + radius,
+        lightCenter.y - radius, lightCenter.y + radius, nearDepth, farDepth);
+    cascade.lightTransform = cascade.projection * view;
+  }
+
+  frame++;
+}
+
+void dg::ShadowCascades::SetActive(bool active) {
+  this->active = active;
+}
+
+bool dg::ShadowCascades::IsActive() const {
+  return active;
+}
+
+unsigned int dg::ShadowCascades::GetCount() const {
+  return count;
+}
+
+bool dg::ShadowCascades::NeedsRender(unsigned int cascade) const {
+  assert(cascade < count);
+  return cascades[cascade].needsRender;
+}
+
+glm::mat4x4 dg::ShadowCascades::GetViewMatrix() const {
+  return view;
+}
+
+glm::mat4x4 dg::ShadowCascades::GetProjectionMatrix(
+    unsigned int cascade) const {
+  assert(cascade < count);
+  return cascades[cascade].projection;
+}
+
+glm::mat4x4 dg::ShadowCascades::GetLightTransform(
+    unsigned int cascade) const {
+  assert(cascade < count);
+  return cascades[cascade].lightTransform;
+}
+
+glm::vec4 dg::ShadowCascades::GetSplitDepths() const {
+  glm::vec4 splits = glm::vec4(0);
+  for (unsigned int i = 0; i < count; i++) {
+    splits[i] = cascades[i].splitDepth;
+  }
+  return splits;
+}
+
+std::shared_ptr<dg::FrameBuffer> dg::ShadowCascades::GetFrameBuffer() {
+  if (framebuffer == nullptr) {
+    FrameBuffer::Options fbOptions;
+    fbOptions.width = options.resolution;
+    fbOptions.height = options.resolution;
+    fbOptions.type = TextureType::_2D_ARRAY;
+    fbOptions.layers = count;
+    fbOptions.depthReadable = true;
+    fbOptions.hasColor = false;
+    fbOptions.hasStencil = false;
+    framebuffer = FrameBuffer::Create(fbOptions);
+  }
+  return framebuffer;
+}
+
+std::shared_ptr<dg::Texture> dg::ShadowCascades::GetTexture() const {
+  if (framebuffer == nullptr) {
+    return nullptr;
+  }
+  return framebuffer->GetDepthTexture();
+}
@@ -7,14 +7,37 @@
 #include <iostream>
 #include <string>
 #include "dg/Exceptions.h"
+#include "dg/FileUtils.h"
 #include "dg/Graphics.h"
 #include "dg/Image.h"
 
+namespace {
+
+  // Bytes of storage of a texture of RGBA bytes, including its mip chain,
+  // which adds a third.
+  size_t StorageSize(const dg::TextureOptions &options) {
+    size_t faces = options.type == dg::TextureType::CUBEMAP ? 6 : 1;
+    size_t size = (size_t)options.width * options.height * 4 * faces;
+    return options.mipmap ? size + size / 3 : size;
+  }
+
+} // namespace
+
 #pragma region Texture Base Class
 
+std::unordered_map<std::string, std::weak_ptr<dg::Texture>>
+    dg::BaseTexture::fileMap;
+dg::BaseTexture::CacheStats dg::BaseTexture::cacheStats;
+
 std::shared_ptr<dg::Texture> dg::BaseTexture::FromPath(
     const std::string &path) {
-  return FromImage(Image::FromPath(path));
+  std::string key = FileUtils::FlattenPath(path);
+  std::shared_ptr<Texture> texture = FindLoaded(key);
+  if (texture == nullptr) {
+    texture = FromImage(Image::FromPath(path));
+    fileMap.insert_or_assign(key, texture);
+  }
+  return texture;
 }
 
 std::shared_ptr<dg::Texture> dg::BaseTexture::FromImage(
@@ -35,10 +58,42 @@ std::shared_ptr<dg::Texture> dg::BaseTexture::FromPaths(
     const std::string &right, const std::string &left, const std::string &top,
     const std::string &bottom, const std::string &back,
     const std::string &front) {
-  return FromImages(Image::FromPath(right, false), Image::FromPath(left, false),
-                    Image::FromPath(top, false), Image::FromPath(bottom, false),
-                    Image::FromPath(back, false),
-                    Image::FromPath(front, false));
+  // Cubemaps are keyed by all six paths, separated by newlines so that they
+  // can't be mistaken for the path of a 2D texture.
+  std::string key;
+  for (const std::string *path : { &right, &left, &top, &bottom, &back,
+                                   &front }) {
+    key += FileUtils::FlattenPath(*path) + "\n";
+  }
+  std::shared_ptr<Texture> texture = FindLoaded(key);
+  if (texture == nullptr) {
+    texture = FromImages(
+        Image::FromPath(right, false), Image::FromPath(left, false),
+        Image::FromPath(top, false), Image::FromPath(bottom, false),
+        Image::FromPath(back, false), Image::FromPath(front, false));
+    fileMap.insert_or_assign(key, texture);
+  }
+  return texture;
+}
+
+const dg::BaseTexture::CacheStats &dg::BaseTexture::GetCacheStats() {
+  return cacheStats;
+}
+
+std::shared_ptr<dg::Texture> dg::BaseTexture::FindLoaded(
+    const std::string &key) {
+  auto found = fileMap.find(key);
+  if (found != fileMap.end()) {
+    std::shared_ptr<Texture> texture = found->second.lock();
+    if (texture != nullptr) {
+      cacheStats.hits++;
+      cacheStats.bytesSaved += StorageSize(texture->options);
+      return texture;
+    }
+    fileMap.erase(found);
+  }
+  cacheStats.misses++;
+  return nullptr;
 }
 
 std::shared_ptr<dg::Texture> dg::BaseTexture::FromImages(
@@ -101,6 +156,20 @@ dg::BaseTexture::BaseTexture(TextureOptions options) : options(options) {
           "Cannot create a depth-only Texture with int type. Must use float.");
     }
   }
+  if (options.type == TextureType::_2D_ARRAY && options.layers == 0) {
+    throw EngineError("Cannot create an array Texture with no layers.");
+  }
+  if (options.type == TextureType::BUFFER) {
+    if (options.format != TexturePixelFormat::RGBA) {
+      throw EngineError("Cannot create a buffer Texture with a depth format.");
+    }
+    if (options.mipmap) {
+      throw EngineError("Cannot create a buffer Texture with mipmap enabled.");
+    }
+    if (options.height != 1) {
+      throw EngineError("Cannot create a buffer Texture with height != 1.");
+    }
+  }
 }
 
 const dg::TextureOptions dg::BaseTexture::GetOptions() const {
@@ -146,38 +215,68 @@ dg::OpenGLTexture::OpenGLTexture(TextureOptions options)
 
 GLuint dg::OpenGLTexture::GetHandle() const { return textureHandle; }
 
+GLuint dg::OpenGLTexture::GetSampler() const {
+  if (samplerHandle == 0 && options.type != TextureType::BUFFER) {
+    samplerHandle = Graphics::Instance->GetSampler(options);
+  }
+  return samplerHandle;
+}
+
 dg::OpenGLTexture::~OpenGLTexture() {
   if (textureHandle != 0) {
+    if (Graphics::Instance != nullptr) {
+      Graphics::Instance->ForgetTexture(textureHandle);
+    }
     glDeleteTextures(1, &textureHandle);
     textureHandle = 0;
   }
+  if (bufferHandle != 0) {
+    glDeleteBuffers(1, &bufferHandle);
+    bufferHandle = 0;
+  }
 }
 
 void dg::OpenGLTexture::Bind() const {
   assert(textureHandle != 0);
-  glBindTexture(options.GetOpenGLTarget(), textureHandle);
-}
-
-void dg::OpenGLTexture::Unbind() const {
-  glBindTexture(options.GetOpenGLTarget(), GL_NONE);
+  Graphics::Instance->BindTextureToEdit(options.GetOpenGLTarget(),
+                                        textureHandle);
 }
 
 void dg::OpenGLTexture::UpdateData(const void *pixels, bool genMipMap) {
+  if (options.type == TextureType::BUFFER) {
+    UpdateBufferData(pixels, GetWidth() * options.GetOpenGLBytesPerPixel());
+    return;
+  }
+
   Bind();
-  glTexSubImage2D(
-      GL_TEXTURE_2D,
-      0,
-      0,
-      0,
-      GetWidth(),
-      GetHeight(),
-      options.GetOpenGLInternalFormat(),
-      options.GetOpenGLType(),
-      pixels);
+  if (options.type == TextureType::_2D_ARRAY) {
+    glTexSubImage3D(
+        GL_TEXTURE_2D_ARRAY,
+        0,
+        0,
+        0,
+        0,
+        GetWidth(),
+        GetHeight(),
+        options.layers,
+        options.GetOpenGLExternalFormat(),
+        options.GetOpenGLType(),
+        pixels);
+  } else {
+    glTexSubImage2D(
+        GL_TEXTURE_2D,
+        0,
+        0,
+        0,
+        GetWidth(),
+        GetHeight(),
+        options.GetOpenGLInternalFormat(),
+        options.GetOpenGLType(),
+        pixels);
+  }
   if (options.mipmap && genMipMap) {
     GenerateMips();
   }
-  Unbind();
 }
 
 void dg::OpenGLTexture::UpdateData(TextureFace face, const void *pixels,
@@ -197,10 +296,22 @@ void dg::OpenGLTexture::UpdateData(TextureFace face, const void *pixels,
     GenerateMips(face);
   }
 
-  Unbind();
+}
+
+void dg::OpenGLTexture::UpdateBufferData(const void *data, size_t size) {
+  assert(options.type == TextureType::BUFFER);
+  assert(bufferHandle != 0);
+  assert(size <= GetWidth() * options.GetOpenGLBytesPerPixel());
+
+  glBindBuffer(GL_TEXTURE_BUFFER, bufferHandle);
+  glBufferSubData(GL_TEXTURE_BUFFER, 0, size, data);
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
 }
 
 void dg::OpenGLTexture::GenerateMips() {
+  if (GetType() != TextureType::BUFFER) {
+    Bind();
+  }
   switch (GetType()) {
     case TextureType::_2D:
       glGenerateMipmap(GL_TEXTURE_2D);
@@ -213,6 +324,11 @@ void dg::OpenGLTexture::GenerateMips() {
       GenerateMips(TextureFace::Back);
       GenerateMips(TextureFace::Front);
       break;
+    case TextureType::_2D_ARRAY:
+      glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+      break;
+    case TextureType::BUFFER:
+      break;
   }
 }
 
@@ -225,9 +341,27 @@ void dg::OpenGLTexture::GenerateImage(void *pixels) {
 
   GLenum target = options.GetOpenGLTarget();
 
+  // Buffer textures have no image or sampler state of their own, just a view
+  // of a buffer object's storage.
+  if (options.type == TextureType::BUFFER) {
+    glGenBuffers(1, &bufferHandle);
+    glBindBuffer(GL_TEXTURE_BUFFER, bufferHandle);
+    glBufferData(GL_TEXTURE_BUFFER,
+                 options.width * options.GetOpenGLBytesPerPixel(), pixels,
+                 GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    glGenTextures(1, &textureHandle);
+    Bind();
+    glTexBuffer(target, options.GetOpenGLInternalFormat(), bufferHandle);
+    return;
+  }
+
   glGenTextures(1, &textureHandle);
-  glBindTexture(target, textureHandle);
+  Bind();
 
+  // Shaders sample through sampler objects, which override these, but
+  // they're kept for anything sampling the texture without one.
   glTexParameteri(target, GL_TEXTURE_MIN_FILTER, options.GetOpenGLMinFilter());
   glTexParameteri(target, GL_TEXTURE_MAG_FILTER, options.GetOpenGLMagFilter());
   GLenum wrap = options.GetOpenGLWrap();
@@ -262,13 +396,25 @@ void dg::OpenGLTexture::GenerateImage(void *pixels) {
                      pixels);
       }
       break;
+    case TextureType::_2D_ARRAY:
+      glTexImage3D(GL_TEXTURE_2D_ARRAY,
+                   0,                                  // Level of detail
+                   options.GetOpenGLInternalFormat(),  // Internal format
+                   options.width,
+                   options.height,
+                   options.layers,
+                   0,                                  // Border
+                   options.GetOpenGLExternalFormat(),  // External format
+                   options.GetOpenGLType(),            // Type
+                   pixels);
+      break;
+    default:
+      break;
   }
 
   if (pixels != nullptr && options.mipmap) {
     glGenerateMipmap(target);
   }
-
-  glBindTexture(target, 0);
 }
 
 #endif
@@ -336,6 +482,14 @@ void dg::DirectXTexture::GenerateImage(void *pixels) {
         "Cannot create a texture that is CPU readable and shader readable.");
   }
 
+  if (options.type == TextureType::BUFFER) {
+    throw EngineError("TODO: Implement DirectX buffer textures.");
+  }
+
+  if (options.type == TextureType::_2D_ARRAY) {
+    throw EngineError("TODO: Implement DirectX array textures.");
+  }
+
   auto internalFormat = options.GetDirectXInternalFormat();
 
   D3D11_TEXTURE2D_DESC desc = {};
@@ -414,7 +568,12 @@ GLenum dg::TextureOptions::GetOpenGLTarget() const {
       return GL_TEXTURE_2D;
     case TextureType::CUBEMAP:
       return GL_TEXTURE_CUBE_MAP;
+    case TextureType::_2D_ARRAY:
+      return GL_TEXTURE_2D_ARRAY;
+    case TextureType::BUFFER:
+      return GL_TEXTURE_BUFFER;
   }
+  return GL_NONE;
 }
 
 GLenum dg::TextureOptions::GetOpenGLWrap() const {
@@ -457,6 +616,12 @@ GLenum dg::TextureOptions::GetOpenGLMagFilter() const {
 }
 
 GLenum dg::TextureOptions::GetOpenGLInternalFormat() const {
+  // Buffer textures require a sized internal format, and are fetched without
+  // conversion, so INT and FLOAT map to 32-bit integer and float channels.
+  if (type == TextureType::BUFFER) {
+    return GetOpenGLImageFormat();
+  }
+
   switch (format) {
     case TexturePixelFormat::RGBA:
       return GL_RGBA;
@@ -468,6 +633,19 @@ GLenum dg::TextureOptions::GetOpenGLInternalFormat() const {
   return GL_NONE;
 }
 
+GLenum dg::TextureOptions::GetOpenGLImageFormat() const {
+  assert(format == TexturePixelFormat::RGBA);
+  switch (pixelType) {
+    case TexturePixelType::BYTE:
+      return GL_RGBA8;
+    case TexturePixelType::INT:
+      return GL_RGBA32UI;
+    case TexturePixelType::FLOAT:
+      return GL_RGBA32F;
+  }
+  return GL_NONE;
+}
+
 GLenum dg::TextureOptions::GetOpenGLExternalFormat() const {
   switch (format) {
     case TexturePixelFormat::DEPTH_STENCIL:
@@ -494,6 +672,17 @@ GLenum dg::TextureOptions::GetOpenGLType() const {
   return GL_NONE;
 }
 
+unsigned int dg::TextureOptions::GetOpenGLBytesPerPixel() const {
+  switch (format) {
+    case TexturePixelFormat::RGBA:
+      return (pixelType == TexturePixelType::BYTE) ? 4 : 16;
+    case TexturePixelFormat::DEPTH:
+    case TexturePixelFormat::DEPTH_STENCIL:
+      return 4;
+  }
+  return 0;
+}
+
 #elif defined(_DIRECTX)
 
 DXGI_FORMAT dg::TextureOptions::GetDirectXInternalFormat() const {
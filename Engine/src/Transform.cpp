@@ -8,6 +8,139 @@
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/quaternion.hpp>
 
+#if defined(__SSE__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define DG_TRANSFORM_SIMD
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define DG_TRANSFORM_SIMD
+#endif
+
+#if defined(DG_TRANSFORM_SIMD)
+namespace {
+
+  // Four floats, one for each of four transforms being processed at once.
+#if defined(__aarch64__) || defined(_M_ARM64)
+  typedef float32x4_t float4;
+  inline float4 Load(const float *f) { return vld1q_f32(f); }
+  inline void Store(float *f, float4 v) { vst1q_f32(f, v); }
+  inline float4 Splat(float f) { return vdupq_n_f32(f); }
+  inline float4 Add(float4 a, float4 b) { return vaddq_f32(a, b); }
+  inline float4 Sub(float4 a, float4 b) { return vsubq_f32(a, b); }
+  inline float4 Mul(float4 a, float4 b) { return vmulq_f32(a, b); }
+  inline float4 Div(float4 a, float4 b) { return vdivq_f32(a, b); }
+#else
+  typedef __m128 float4;
+  inline float4 Load(const float *f) { return _mm_load_ps(f); }
+  inline void Store(float *f, float4 v) { _mm_store_ps(f, v); }
+  inline float4 Splat(float f) { return _mm_set1_ps(f); }
+  inline float4 Add(float4 a, float4 b) { return _mm_add_ps(a, b); }
+  inline float4 Sub(float4 a, float4 b) { return _mm_sub_ps(a, b); }
+  inline float4 Mul(float4 a, float4 b) { return _mm_mul_ps(a, b); }
+  inline float4 Div(float4 a, float4 b) { return _mm_div_ps(a, b); }
+#endif
+
+  // Components of four transforms, each holding one component of all four.
+  struct Lanes {
+    float4 tx, ty, tz;
+    float4 qx, qy, qz, qw;
+    float4 sx, sy, sz;
+  };
+
+  Lanes LoadLanes(const dg::Transform *transforms) {
+    alignas(16) float c[10][4];
+    for (int i = 0; i < 4; i++) {
+      const dg::Transform &xf = transforms[i];
+      c[0][i] = xf.translation.x;
+      c[1][i] = xf.translation.y;
+      c[2][i] = xf.translation.z;
+      c[3][i] = xf.rotation.x;
+      c[4][i] = xf.rotation.y;
+      c[5][i] = xf.rotation.z;
+      c[6][i] = xf.rotation.w;
+      c[7][i] = xf.scale.x;
+      c[8][i] = xf.scale.y;
+      c[9][i] = xf.scale.z;
+    }
+    Lanes lanes;
+    lanes.tx = Load(c[0]);
+    lanes.ty = Load(c[1]);
+    lanes.tz = Load(c[2]);
+    lanes.qx = Load(c[3]);
+    lanes.qy = Load(c[4]);
+    lanes.qz = Load(c[5]);
+    lanes.qw = Load(c[6]);
+    lanes.sx = Load(c[7]);
+    lanes.sy = Load(c[8]);
+    lanes.sz = Load(c[9]);
+    return lanes;
+  }
+
+  void StoreLanes(const Lanes &lanes, dg::Transform *transforms) {
+    alignas(16) float c[10][4];
+    Store(c[0], lanes.tx);
+    Store(c[1], lanes.ty);
+    Store(c[2], lanes.tz);
+    Store(c[3], lanes.qx);
+    Store(c[4], lanes.qy);
+    Store(c[5], lanes.qz);
+    Store(c[6], lanes.qw);
+    Store(c[7], lanes.sx);
+    Store(c[8], lanes.sy);
+    Store(c[9], lanes.sz);
+    for (int i = 0; i < 4; i++) {
+      dg::Transform &xf = transforms[i];
+      xf.translation = glm::vec3(c[0][i], c[1][i], c[2][i]);
+      xf.rotation = glm::quat(c[6][i], c[3][i], c[4][i], c[5][i]);
+      xf.scale = glm::vec3(c[7][i], c[8][i], c[9][i]);
+    }
+  }
+
+  // Writes four affine matrices, given the top three rows of each column.
+  void StoreAffine(const float4 (&columns)[4][3], glm::mat4x4 *matrices) {
+    alignas(16) float c[4][3][4];
+    for (int col = 0; col < 4; col++) {
+      for (int row = 0; row < 3; row++) {
+        Store(c[col][row], columns[col][row]);
+      }
+    }
+    for (int i = 0; i < 4; i++) {
+      for (int col = 0; col < 4; col++) {
+        matrices[i][col] = glm::vec4(c[col][0][i], c[col][1][i],
+                                     c[col][2][i], col == 3 ? 1.f : 0.f);
+      }
+    }
+  }
+
+  // Columns of the rotation matrices of four unit quaternions, as in
+  // glm::mat3_cast().
+  void RotationColumns(const Lanes &lanes, float4 (&r)[3][3]) {
+    float4 one = Splat(1);
+    float4 two = Splat(2);
+    float4 xx = Mul(lanes.qx, lanes.qx);
+    float4 yy = Mul(lanes.qy, lanes.qy);
+    float4 zz = Mul(lanes.qz, lanes.qz);
+    float4 xy = Mul(lanes.qx, lanes.qy);
+    float4 xz = Mul(lanes.qx, lanes.qz);
+    float4 yz = Mul(lanes.qy, lanes.qz);
+    float4 wx = Mul(lanes.qw, lanes.qx);
+    float4 wy = Mul(lanes.qw, lanes.qy);
+    float4 wz = Mul(lanes.qw, lanes.qz);
+    r[0][0] = Sub(one, Mul(two, Add(yy, zz)));
+    r[0][1] = Mul(two, Add(xy, wz));
+    r[0][2] = Mul(two, Sub(xz, wy));
+    r[1][0] = Mul(two, Sub(xy, wz));
+    r[1][1] = Sub(one, Mul(two, Add(xx, zz)));
+    r[1][2] = Mul(two, Add(yz, wx));
+    r[2][0] = Mul(two, Add(xz, wy));
+    r[2][1] = Mul(two, Sub(yz, wx));
+    r[2][2] = Sub(one, Mul(two, Add(xx, yy)));
+  }
+
+} // namespace
+#endif
+
 dg::Transform dg::Transform::T(glm::vec3 translation) {
   Transform xf;
   xf.translation = translation;
@@ -87,10 +220,121 @@ glm::mat4x4 dg::operator*(const dg::Transform& a, const glm::mat4x4& b) {
 }
 
 glm::mat4x4 dg::Transform::ToMat4() const {
-  glm::mat4x4 r = glm::toMat4(rotation);
-  glm::mat4x4 t = glm::translate(glm::mat4x4(1), translation);
-  glm::mat4x4 s = glm::scale(glm::mat4x4(1), scale);
-  return t * r * s;
+  // T * R * S, built directly instead of multiplying the three together.
+  glm::mat3x3 r = glm::mat3_cast(rotation);
+  return glm::mat4x4(
+      glm::vec4(r[0] * scale.x, 0),
+      glm::vec4(r[1] * scale.y, 0),
+      glm::vec4(r[2] * scale.z, 0),
+      glm::vec4(translation, 1));
+}
+
+glm::mat4x4 dg::Transform::ToNormalMat4() const {
+  // The inverse transpose of R * S is R * S^-1.
+  glm::mat3x3 r = glm::mat3_cast(rotation);
+  return glm::mat4x4(
+      glm::vec4(r[0] / scale.x, 0),
+      glm::vec4(r[1] / scale.y, 0),
+      glm::vec4(r[2] / scale.z, 0),
+      glm::vec4(0, 0, 0, 1));
+}
+
+void dg::Transform::ToMat4(const Transform *transforms,
+                           glm::mat4x4 *matrices, size_t count) {
+  size_t i = 0;
+#if defined(DG_TRANSFORM_SIMD)
+  for (; i + 4 <= count; i += 4) {
+    Lanes lanes = LoadLanes(transforms + i);
+    float4 r[3][3];
+    RotationColumns(lanes, r);
+    float4 scale[3] = { lanes.sx, lanes.sy, lanes.sz };
+    float4 columns[4][3];
+    for (int col = 0; col < 3; col++) {
+      for (int row = 0; row < 3; row++) {
+        columns[col][row] = Mul(r[col][row], scale[col]);
+      }
+    }
+    columns[3][0] = lanes.tx;
+    columns[3][1] = lanes.ty;
+    columns[3][2] = lanes.tz;
+    StoreAffine(columns, matrices + i);
+  }
+#endif
+  for (; i < count; i++) {
+    matrices[i] = transforms[i].ToMat4();
+  }
+}
+
+void dg::Transform::ToNormalMat4(const Transform *transforms,
+                                 glm::mat4x4 *matrices, size_t count) {
+  size_t i = 0;
+#if defined(DG_TRANSFORM_SIMD)
+  for (; i + 4 <= count; i += 4) {
+    Lanes lanes = LoadLanes(transforms + i);
+    float4 r[3][3];
+    RotationColumns(lanes, r);
+    float4 one = Splat(1);
+    float4 inverseScale[3] = {
+        Div(one, lanes.sx), Div(one, lanes.sy), Div(one, lanes.sz) };
+    float4 columns[4][3];
+    for (int col = 0; col < 3; col++) {
+      for (int row = 0; row < 3; row++) {
+        columns[col][row] = Mul(r[col][row], inverseScale[col]);
+      }
+    }
+    columns[3][0] = columns[3][1] = columns[3][2] = Splat(0);
+    StoreAffine(columns, matrices + i);
+  }
+#endif
+  for (; i < count; i++) {
+    matrices[i] = transforms[i].ToNormalMat4();
+  }
+}
+
+void dg::Transform::Multiply(const Transform *a, const Transform *b,
+                             Transform *products, size_t count) {
+  size_t i = 0;
+#if defined(DG_TRANSFORM_SIMD)
+  for (; i + 4 <= count; i += 4) {
+    Lanes l = LoadLanes(a + i);
+    Lanes r = LoadLanes(b + i);
+    Lanes p;
+
+    p.sx = Mul(l.sx, r.sx);
+    p.sy = Mul(l.sy, r.sy);
+    p.sz = Mul(l.sz, r.sz);
+
+    p.qw = Sub(Sub(Sub(Mul(l.qw, r.qw), Mul(l.qx, r.qx)), Mul(l.qy, r.qy)),
+               Mul(l.qz, r.qz));
+    p.qx = Sub(Add(Add(Mul(l.qw, r.qx), Mul(l.qx, r.qw)), Mul(l.qy, r.qz)),
+               Mul(l.qz, r.qy));
+    p.qy = Sub(Add(Add(Mul(l.qw, r.qy), Mul(l.qy, r.qw)), Mul(l.qz, r.qx)),
+               Mul(l.qx, r.qz));
+    p.qz = Sub(Add(Add(Mul(l.qw, r.qz), Mul(l.qz, r.qw)), Mul(l.qx, r.qy)),
+               Mul(l.qy, r.qx));
+
+    // Rotate the scaled translation v by a's rotation q, as glm does:
+    // v + 2 * (q.w * (q.xyz x v) + q.xyz x (q.xyz x v)).
+    float4 vx = Mul(l.sx, r.tx);
+    float4 vy = Mul(l.sy, r.ty);
+    float4 vz = Mul(l.sz, r.tz);
+    float4 ux = Sub(Mul(l.qy, vz), Mul(l.qz, vy));
+    float4 uy = Sub(Mul(l.qz, vx), Mul(l.qx, vz));
+    float4 uz = Sub(Mul(l.qx, vy), Mul(l.qy, vx));
+    float4 uux = Sub(Mul(l.qy, uz), Mul(l.qz, uy));
+    float4 uuy = Sub(Mul(l.qz, ux), Mul(l.qx, uz));
+    float4 uuz = Sub(Mul(l.qx, uy), Mul(l.qy, ux));
+    float4 two = Splat(2);
+    p.tx = Add(Add(l.tx, vx), Mul(two, Add(Mul(l.qw, ux), uux)));
+    p.ty = Add(Add(l.ty, vy), Mul(two, Add(Mul(l.qw, uy), uuy)));
+    p.tz = Add(Add(l.tz, vz), Mul(two, Add(Mul(l.qw, uz), uuz)));
+
+    StoreLanes(p, products + i);
+  }
+#endif
+  for (; i < count; i++) {
+    products[i] = a[i] * b[i];
+  }
 }
 
 glm::vec3 dg::Transform::Right() const {
@@ -106,7 +106,7 @@ void dg::StandardMaterial::Use() const {
 
 void dg::StandardMaterial::SetUVScale(glm::vec2 scale) {
 #if defined(_OPENGL)
-  SetProperty("_UVScale", scale);
+  SetProperty("_Material.uvScale", scale);
 #elif defined(_DIRECTX)
   SetProperty("uvScale", scale);
 #endif
@@ -114,7 +114,7 @@ void dg::StandardMaterial::SetUVScale(glm::vec2 scale) {
 
 void dg::StandardMaterial::SetLit(bool lit) {
 #if defined(_OPENGL)
-  SetProperty("_Material.lit", lit);
+  SetKeyword("LIT", lit);
 #elif defined(_DIRECTX)
   SetProperty("lit", lit);
 #endif
@@ -130,7 +130,7 @@ void dg::StandardMaterial::SetDiffuse(glm::vec3 diffuse) {
 
 void dg::StandardMaterial::SetDiffuse(glm::vec4 diffuse) {
 #if defined(_OPENGL)
-  SetProperty("_Material.useDiffuseMap", false);
+  SetKeyword("DIFFUSE_MAP", false);
   SetProperty("_Material.diffuse", diffuse);
 #elif defined(_DIRECTX)
   SetProperty("useDiffuseMap", false);
@@ -141,11 +141,11 @@ void dg::StandardMaterial::SetDiffuse(glm::vec4 diffuse) {
 void dg::StandardMaterial::SetDiffuse(std::shared_ptr<Texture> diffuseMap) {
 #if defined(_OPENGL)
   if (diffuseMap == nullptr) {
-    SetProperty("_Material.useDiffuseMap", false);
-    ClearProperty("_Material.diffuseMap");
+    SetKeyword("DIFFUSE_MAP", false);
+    ClearProperty("_DiffuseMap");
   } else {
-    SetProperty("_Material.useDiffuseMap", true);
-    SetProperty("_Material.diffuseMap", diffuseMap, (int)TexUnitHints::DIFFUSE);
+    SetKeyword("DIFFUSE_MAP", true);
+    SetProperty("_DiffuseMap", diffuseMap, (int)TexUnitHints::DIFFUSE);
   }
 #elif defined(_DIRECTX)
   if (diffuseMap == nullptr) {
@@ -164,9 +164,9 @@ void dg::StandardMaterial::SetSpecular(float specular) {
 
 void dg::StandardMaterial::SetSpecular(glm::vec3 specular) {
 #if defined(_OPENGL)
-  SetProperty("_Material.useSpecularMap", false);
+  SetKeyword("SPECULAR_MAP", false);
   SetProperty("_Material.specular", specular);
-  ClearProperty("_Material.specularMap");
+  ClearProperty("_SpecularMap");
 #elif defined(_DIRECTX)
   SetProperty("useSpecularMap", false);
   SetProperty("specular", specular);
@@ -177,12 +177,11 @@ void dg::StandardMaterial::SetSpecular(glm::vec3 specular) {
 void dg::StandardMaterial::SetSpecular(std::shared_ptr<Texture> specularMap) {
 #if defined(_OPENGL)
   if (specularMap == nullptr) {
-    SetProperty("_Material.useSpecularMap", false);
-    ClearProperty("_Material.specularMap");
+    SetKeyword("SPECULAR_MAP", false);
+    ClearProperty("_SpecularMap");
   } else {
-    SetProperty("_Material.useSpecularMap", true);
-    SetProperty("_Material.specularMap", specularMap,
-                (int)TexUnitHints::SPECULAR);
+    SetKeyword("SPECULAR_MAP", true);
+    SetProperty("_SpecularMap", specularMap, (int)TexUnitHints::SPECULAR);
   }
 #elif defined(_DIRECTX)
   if (specularMap == nullptr) {
@@ -198,11 +197,11 @@ void dg::StandardMaterial::SetSpecular(std::shared_ptr<Texture> specularMap) {
 void dg::StandardMaterial::SetNormalMap(std::shared_ptr<Texture> normalMap) {
 #if defined(_OPENGL)
   if (normalMap == nullptr) {
-    SetProperty("_Material.useNormalMap", false);
-    ClearProperty("_Material.normalMap");
+    SetKeyword("NORMAL_MAP", false);
+    ClearProperty("_NormalMap");
   } else {
-    SetProperty("_Material.useNormalMap", true);
-    SetProperty("_Material.normalMap", normalMap, (int)TexUnitHints::NORMAL);
+    SetKeyword("NORMAL_MAP", true);
+    SetProperty("_NormalMap", normalMap, (int)TexUnitHints::NORMAL);
   }
 #elif defined(_DIRECTX)
   if (normalMap == nullptr) {
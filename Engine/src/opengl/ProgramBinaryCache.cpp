@@ -0,0 +1,216 @@
+//
+//  opengl/ProgramBinaryCache.cpp
+//
+
+#include "dg/opengl/ProgramBinaryCache.h"
+#include <GLFW/glfw3.h>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include "dg/FileUtils.h"
+#include "dg/Graphics.h"
+
+// Program binaries are core in GL 4.1, which GLAD wasn't generated for.
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+namespace {
+
+  typedef void (APIENTRYP GetProgramBinaryProc)(GLuint program,
+                                                GLsizei bufSize,
+                                                GLsizei *length,
+                                                GLenum *binaryFormat,
+                                                void *binary);
+  typedef void (APIENTRYP ProgramBinaryProc)(GLuint program,
+                                             GLenum binaryFormat,
+                                             const void *binary,
+                                             GLsizei length);
+  typedef void (APIENTRYP ProgramParameteriProc)(GLuint program,
+                                                 GLenum pname, GLint value);
+
+  struct Procs {
+    GetProgramBinaryProc getProgramBinary = nullptr;
+    ProgramBinaryProc programBinary = nullptr;
+    ProgramParameteriProc programParameteri = nullptr;
+  };
+
+  // Program binary functions, all nullptr if the context doesn't support
+  // them or has no binary formats.
+  const Procs &GetProcs() {
+    static Procs procs = []() {
+      Procs procs;
+      if (!dg::Graphics::Instance->SupportsVersion(4, 1) &&
+          !dg::Graphics::Instance->SupportsExtension(
+              "GL_ARB_get_program_binary")) {
+        return procs;
+      }
+      GLint formats = 0;
+      glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+      if (formats <= 0) {
+        return procs;
+      }
+      procs.getProgramBinary =
+          (GetProgramBinaryProc)glfwGetProcAddress("glGetProgramBinary");
+      procs.programBinary =
+          (ProgramBinaryProc)glfwGetProcAddress("glProgramBinary");
+      procs.programParameteri =
+          (ProgramParameteriProc)glfwGetProcAddress("glProgramParameteri");
+      if (procs.getProgramBinary == nullptr ||
+          procs.programBinary == nullptr ||
+          procs.programParameteri == nullptr) {
+        procs = Procs();
+      }
+      return procs;
+    }();
+    return procs;
+  }
+
+  // Header at the start of each cached binary file.
+  struct Header {
+    char magic[4];
+    uint32_t version;
+    uint64_t key;
+    uint32_t format;
+    uint32_t length;
+  };
+
+  const char MAGIC[4] = { 'D', 'G', 'P', 'B' };
+
+  // Incremented whenever the file layout changes.
+  const uint32_t FILE_VERSION = 1;
+
+  // 64-bit FNV-1a, continued from hash.
+  void HashBytes(uint64_t &hash, const void *data, size_t size) {
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (size_t i = 0; i < size; i++) {
+      hash ^= bytes[i];
+      hash *= 1099511628211ull;
+    }
+  }
+
+  // Hashes a string along with its length, so that consecutive strings
+  // can't run into each other.
+  void HashString(uint64_t &hash, const std::string &str) {
+    uint64_t length = str.size();
+    HashBytes(hash, &length, sizeof(length));
+    HashBytes(hash, str.data(), str.size());
+  }
+
+  std::string GetString(GLenum name) {
+    const GLubyte *str = glGetString(name);
+    return str == nullptr ? std::string() : std::string((const char *)str);
+  }
+
+} // namespace
+
+std::string dg::ProgramBinaryCache::directory = "shadercache";
+
+bool dg::ProgramBinaryCache::IsSupported() {
+  return GetProcs().programBinary != nullptr;
+}
+
+uint64_t dg::ProgramBinaryCache::GetKey(
+    const std::vector<std::shared_ptr<ShaderSource>> &sources) {
+  static const uint64_t driverHash = []() {
+    uint64_t hash = 14695981039346656037ull;
+    HashString(hash, GetString(GL_VENDOR));
+    HashString(hash, GetString(GL_RENDERER));
+    HashString(hash, GetString(GL_VERSION));
+    return hash;
+  }();
+
+  uint64_t hash = driverHash;
+  for (auto &source : sources) {
+    GLenum type = source->GetType();
+    HashBytes(hash, &type, sizeof(type));
+    HashString(hash, source->GetContent());
+  }
+  return hash;
+}
+
+bool dg::ProgramBinaryCache::Load(GLuint program, uint64_t key) {
+  if (!IsSupported()) {
+    return false;
+  }
+
+  std::ifstream file(GetPath(key), std::ios::binary);
+  if (!file) {
+    return false;
+  }
+
+  Header header;
+  if (!file.read((char *)&header, sizeof(header)) ||
+      memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+      header.version != FILE_VERSION || header.key != key ||
+      header.length == 0) {
+    return false;
+  }
+  std::vector<char> binary(header.length);
+  if (!file.read(binary.data(), binary.size())) {
+    return false;
+  }
+
+  GetProcs().programBinary(program, header.format, binary.data(),
+                           (GLsizei)binary.size());
+  GLint success = 0;
+  glGetProgramiv(program, GL_LINK_STATUS, &success);
+  return success != 0;
+}
+
+void dg::ProgramBinaryCache::PrepareToLink(GLuint program) {
+  if (IsSupported()) {
+    GetProcs().programParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                                 GL_TRUE);
+  }
+}
+
+void dg::ProgramBinaryCache::Store(GLuint program, uint64_t key) {
+  if (!IsSupported()) {
+    return;
+  }
+
+  GLint length = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0) {
+    return;
+  }
+  std::vector<char> binary(length);
+  GLsizei written = 0;
+  GLenum format = 0;
+  GetProcs().getProgramBinary(program, length, &written, &format,
+                              binary.data());
+  if (written <= 0) {
+    return;
+  }
+
+  if (!FileUtils::MakeDirectory(directory)) {
+    return;
+  }
+  std::ofstream file(GetPath(key), std::ios::binary | std::ios::trunc);
+  if (!file) {
+    return;
+  }
+  Header header;
+  memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.version = FILE_VERSION;
+  header.key = key;
+  header.format = format;
+  header.length = (uint32_t)written;
+  file.write((const char *)&header, sizeof(header));
+  file.write(binary.data(), written);
+}
+
+std::string dg::ProgramBinaryCache::GetPath(uint64_t key) {
+  std::stringstream path;
+  path << directory << "/" << std::hex << std::setw(16) << std::setfill('0')
+       << key << ".bin";
+  return path.str();
+}
@@ -7,11 +7,12 @@
 #include "dg/Exceptions.h"
 
 std::shared_ptr<dg::ShaderSource> dg::ShaderSource::FromFile(
-    GLenum type, const std::string& path) {
+    GLenum type, const std::string& path,
+    const std::vector<std::string>& defines) {
   auto source = std::shared_ptr<ShaderSource>(new ShaderSource());
   source->shaderType = type;
-  source->file = Preprocessor::ForFile(path);
-  source->CompileShader();
+  source->path = path;
+  source->content = Preprocessor::Process(path, defines);
   return source;
 }
 
@@ -22,13 +23,14 @@ dg::ShaderSource::~ShaderSource() {
   }
 }
 
-void dg::ShaderSource::CompileShader() {
-  assert(shaderHandle == 0);
+void dg::ShaderSource::Compile() {
+  if (shaderHandle != 0) {
+    return;
+  }
   shaderHandle = glCreateShader(shaderType);
   const char *code = GetContent().c_str();
   glShaderSource(shaderHandle, 1, &code, NULL);
   glCompileShader(shaderHandle);
-  CheckCompileErrors();
 }
 
 void dg::ShaderSource::CheckCompileErrors() {
@@ -0,0 +1,49 @@
+//
+//  opengl/StorageBuffer.cpp
+//
+
+#include "dg/opengl/StorageBuffer.h"
+#include <cassert>
+
+dg::StorageBuffer::~StorageBuffer() {
+  if (bufferHandle != 0) {
+    glDeleteBuffers(1, &bufferHandle);
+    bufferHandle = 0;
+  }
+}
+
+void dg::StorageBuffer::Allocate(size_t size, const void *data) {
+  if (bufferHandle == 0) {
+    glGenBuffers(1, &bufferHandle);
+  }
+  this->size = size;
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, bufferHandle);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, size, data, GL_DYNAMIC_COPY);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void dg::StorageBuffer::Update(size_t offset, const void *data,
+                               size_t size) {
+  assert(offset + size <= this->size);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, bufferHandle);
+  glBufferSubData(GL_SHADER_STORAGE_BUFFER, offset, size, data);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void dg::StorageBuffer::Read(size_t offset, void *data, size_t size) const {
+  assert(offset + size <= this->size);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, bufferHandle);
+  glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, offset, size, data);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void dg::StorageBuffer::Bind(GLuint binding, size_t offset,
+                             size_t size) const {
+  assert(offset + size <= this->size);
+  glBindBufferRange(GL_SHADER_STORAGE_BUFFER, binding, bufferHandle, offset,
+                    size);
+}
+
+void dg::StorageBuffer::Bind(GLuint binding) const {
+  Bind(binding, 0, size);
+}
@@ -0,0 +1,41 @@
+//
+//  opengl/UniformBuffer.cpp
+//
+
+#include "dg/opengl/UniformBuffer.h"
+#include <cassert>
+
+dg::UniformBuffer::~UniformBuffer() {
+  if (bufferHandle != 0) {
+    glDeleteBuffers(1, &bufferHandle);
+    bufferHandle = 0;
+  }
+}
+
+void dg::UniformBuffer::Allocate(size_t size, const void *data) {
+  if (bufferHandle == 0) {
+    glGenBuffers(1, &bufferHandle);
+  }
+  this->size = size;
+  glBindBuffer(GL_UNIFORM_BUFFER, bufferHandle);
+  glBufferData(GL_UNIFORM_BUFFER, size, data, GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void dg::UniformBuffer::Update(size_t offset, const void *data,
+                               size_t size) {
+  assert(offset + size <= this->size);
+  glBindBuffer(GL_UNIFORM_BUFFER, bufferHandle);
+  glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void dg::UniformBuffer::Bind(GLuint binding, size_t offset,
+                             size_t size) const {
+  assert(offset + size <= this->size);
+  glBindBufferRange(GL_UNIFORM_BUFFER, binding, bufferHandle, offset, size);
+}
+
+void dg::UniformBuffer::Bind(GLuint binding) const {
+  Bind(binding, 0, size);
+}
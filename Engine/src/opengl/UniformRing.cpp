@@ -0,0 +1,146 @@
+//
+//  opengl/UniformRing.cpp
+//
+
+#include "dg/opengl/UniformRing.h"
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include "dg/Graphics.h"
+
+// Buffer storage is core in GL 4.4, which GLAD wasn't generated for.
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+namespace {
+
+  typedef void (APIENTRYP BufferStorageProc)(GLenum target, GLsizeiptr size,
+                                             const void *data,
+                                             GLbitfield flags);
+
+  // glBufferStorage(), or nullptr if the context doesn't support it.
+  BufferStorageProc GetBufferStorage() {
+    static BufferStorageProc bufferStorage = []() {
+      if (!dg::Graphics::Instance->SupportsVersion(4, 4) &&
+          !dg::Graphics::Instance->SupportsExtension(
+              "GL_ARB_buffer_storage")) {
+        return (BufferStorageProc)nullptr;
+      }
+      return (BufferStorageProc)glfwGetProcAddress("glBufferStorage");
+    }();
+    return bufferStorage;
+  }
+
+  // Longest to wait for the GPU to release a segment, in nanoseconds.
+  const GLuint64 FENCE_TIMEOUT = 1000000000;
+
+} // namespace
+
+const unsigned int dg::UniformRing::FRAMES_IN_FLIGHT;
+const size_t dg::UniformRing::DEFAULT_SEGMENT_SIZE;
+
+dg::UniformRing::UniformRing(size_t segmentSize)
+    : segmentSize(segmentSize) {}
+
+dg::UniformRing::~UniformRing() {
+  DeleteBuffer();
+}
+
+void dg::UniformRing::BeginFrame() {
+  if (bufferHandle == 0) {
+    return;
+  }
+
+  fences[segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  segment = (segment + 1) % FRAMES_IN_FLIGHT;
+  offset = 0;
+
+  if (fences[segment] != nullptr) {
+    glClientWaitSync(fences[segment], GL_SYNC_FLUSH_COMMANDS_BIT,
+                     FENCE_TIMEOUT);
+    glDeleteSync(fences[segment]);
+    fences[segment] = nullptr;
+  }
+}
+
+size_t dg::UniformRing::Write(const void *data, size_t size) {
+  size_t start = (offset + alignment - 1) / alignment * alignment;
+  if (bufferHandle == 0) {
+    CreateBuffer(std::max(segmentSize, size));
+    start = 0;
+  } else if (start + size > segmentSize) {
+    // The GPU may still be reading the old buffer, but GL keeps it alive
+    // until it's done.
+    CreateBuffer(std::max(segmentSize * 2, size));
+    start = 0;
+  }
+
+  size_t position = segment * segmentSize + start;
+  if (mapped != nullptr) {
+    memcpy(mapped + position, data, size);
+  } else {
+    glBindBuffer(GL_UNIFORM_BUFFER, bufferHandle);
+    glBufferSubData(GL_UNIFORM_BUFFER, position, size, data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  }
+  offset = start + size;
+  return position;
+}
+
+void dg::UniformRing::Bind(GLuint binding, size_t offset,
+                           size_t size) const {
+  assert(offset + size <= segmentSize * FRAMES_IN_FLIGHT);
+  glBindBufferRange(GL_UNIFORM_BUFFER, binding, bufferHandle, offset, size);
+}
+
+void dg::UniformRing::CreateBuffer(size_t segmentSize) {
+  DeleteBuffer();
+
+  GLint offsetAlignment = 0;
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment);
+  alignment = (size_t)std::max(offsetAlignment, 1);
+  this->segmentSize =
+      (segmentSize + alignment - 1) / alignment * alignment;
+  segment = 0;
+  offset = 0;
+
+  size_t size = this->segmentSize * FRAMES_IN_FLIGHT;
+  glGenBuffers(1, &bufferHandle);
+  generation++;
+  glBindBuffer(GL_UNIFORM_BUFFER, bufferHandle);
+  BufferStorageProc bufferStorage = GetBufferStorage();
+  if (bufferStorage != nullptr) {
+    GLbitfield flags =
+        GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    bufferStorage(GL_UNIFORM_BUFFER, size, nullptr, flags);
+    mapped = (char *)glMapBufferRange(GL_UNIFORM_BUFFER, 0, size, flags);
+  } else {
+    glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_STREAM_DRAW);
+  }
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void dg::UniformRing::DeleteBuffer() {
+  for (GLsync &fence : fences) {
+    if (fence != nullptr) {
+      glDeleteSync(fence);
+      fence = nullptr;
+    }
+  }
+
+  if (bufferHandle != 0) {
+    if (mapped != nullptr) {
+      glBindBuffer(GL_UNIFORM_BUFFER, bufferHandle);
+      glUnmapBuffer(GL_UNIFORM_BUFFER);
+      glBindBuffer(GL_UNIFORM_BUFFER, 0);
+      mapped = nullptr;
+    }
+    glDeleteBuffers(1, &bufferHandle);
+    bufferHandle = 0;
+  }
+}
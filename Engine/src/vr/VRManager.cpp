@@ -204,6 +204,36 @@ void dg::VRManager::SubmitFrame(vr::EVREye eye) {
                        vr::EVRSubmitFlags::Submit_Default);
 }
 
+std::shared_ptr<dg::FrameBuffer> dg::VRManager::GetStereoFramebuffer() {
+  if (stereoFramebuffer == nullptr) {
+    FrameBuffer::Options options = leftFramebuffer->GetOptions();
+    options.width *= 2;
+    stereoFramebuffer = FrameBuffer::Create(options);
+  }
+  return stereoFramebuffer;
+}
+
+void dg::VRManager::SubmitStereoFrame() {
+  vr::Texture_t frameTexture;
+  frameTexture.eColorSpace = vr::EColorSpace::ColorSpace_Auto;
+#if defined(_OPENGL)
+  frameTexture.eType = vr::ETextureType::TextureType_OpenGL;
+  frameTexture.handle =
+      (void *)(long)stereoFramebuffer->GetColorTexture()->GetHandle();
+#elif defined(_DIRECTX)
+  frameTexture.eType = vr::ETextureType::TextureType_DirectX;
+  frameTexture.handle = stereoFramebuffer->GetColorTexture()->GetTexture();
+#endif
+
+  // Each eye is one half of the texture.
+  vr::VRTextureBounds_t leftBounds = { 0, 0, 0.5f, 1 };
+  vr::VRTextureBounds_t rightBounds = { 0.5f, 0, 1, 1 };
+  vrCompositor->Submit(vr::EVREye::Eye_Left, &frameTexture, &leftBounds,
+                       vr::EVRSubmitFlags::Submit_Default);
+  vrCompositor->Submit(vr::EVREye::Eye_Right, &frameTexture, &rightBounds,
+                       vr::EVRSubmitFlags::Submit_Default);
+}
+
 std::shared_ptr<dg::Mesh> dg::VRManager::GetRenderModelMesh(
     const std::string& name) {
   std::shared_ptr<RenderModelInfo> info = nullptr;
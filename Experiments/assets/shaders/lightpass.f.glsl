@@ -75,7 +75,7 @@ vec3 calculateLight(
 
   // Calculate shadow
   float shadow = 0;
-  if (light.hasShadow == 1) {
+  if (light.hasShadow == 1 && light.type == LIGHT_TYPE_SPOT) {
     vec4 fragPosLightSpace = light.lightTransform * vec4(position, 1);
     vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
     projCoords = projCoords * 0.5 + 0.5;
@@ -0,0 +1,32 @@
+//
+//  scenes/TransformsScene.h
+//
+
+#pragma once
+
+#include <memory>
+#include "dg/Scene.h"
+
+namespace dg {
+
+  // Microbenchmark of Transform conversion and composition, comparing the
+  // batched Transform functions to converting and composing one transform
+  // at a time. Results are printed to the console.
+  class TransformsScene : public Scene {
+
+    public:
+
+      static std::unique_ptr<TransformsScene> Make();
+
+      TransformsScene();
+
+      virtual void Initialize();
+      virtual void Update();
+
+    private:
+
+      void RunBenchmarks();
+
+  }; // class TransformsScene
+
+} // namespace dg
@@ -20,6 +20,7 @@
 #include "dg/scenes/ShadowScene.h"
 #include "dg/scenes/SimpleScene.h"
 #include "dg/scenes/TexturesScene.h"
+#include "dg/scenes/TransformsScene.h"
 #include "dg/scenes/TransparencyScene.h"
 #include "dg/scenes/VRScene.h"
 #include "dg/scenes/WidgetScene.h"
@@ -48,6 +49,7 @@ std::unique_ptr<Scene> PromptForScene(
   constructors["canvas"]       = dg::CanvasTestScene::Make;
   constructors["vr"]           = dg::VRScene::Make;
   constructors["transparency"] = dg::TransparencyScene::Make;
+  constructors["transforms"]   = dg::TransformsScene::Make;
   std::string sceneName;
   if (!launchArg.empty()) {
     sceneName = launchArg;
@@ -7,6 +7,7 @@
 #include <forward_list>
 #include <glm/glm.hpp>
 #include <random>
+#include <vector>
 #include "dg/Camera.h"
 #include "dg/Canvas.h"
 #include "dg/Graphics.h"
@@ -166,6 +167,7 @@ void dg::AOScene::InitializeSSAO() {
   std::default_random_engine generator;
 
   const int numSamples = 64;
+  std::vector<glm::vec3> samples(numSamples);
   for (unsigned int i = 0; i < numSamples; ++i) {
     // Sample is a vector in tangent space.
     glm::vec3 sample(randomFloats(generator) * 2.0 - 1.0, // x = [-1, 1]
@@ -178,10 +180,9 @@ void dg::AOScene::InitializeSSAO() {
     scale = lerp(0.1f, 1.0f, scale * scale);
     sample *= scale;
 
-    // TODO: Set this using glUniform3fv() instead of setting each element.
-    std::string key = "_Samples[" + std::to_string(i) + "]";
-    ssaoSubrender.material->SetProperty(key, sample);
+    samples[i] = sample;
   }
+  ssaoSubrender.material->SetProperty("_Samples", samples);
 
   // Create a 4x4 texture of random rotation vectors to tile over the screen.
   TextureOptions noiseTexOpts;
@@ -124,6 +124,7 @@ void dg::PointShadowScene::Initialize() {
     glm::vec3(0.5f, 0.63f, 0.76f), 1.43f, 1.132f, 3.1f);
   pointLight->transform.translation = { 0, 1.0f, -2 };
   pointLight->SetCastShadows(true);
+  pointLight->SetShadowResolution(1024);
   Behavior::Attach(pointLight,
                    std::make_shared<KeyboardLightController>(window));
   lightContainer->AddChild(pointLight, false);
@@ -145,28 +146,28 @@ void dg::PointShadowScene::Initialize() {
       Texture::FromPath("assets/textures/container2_specular.png"));
   cubeMaterial->SetShininess(64);
 
-  // Create wooden cubes.
+  // Create wooden cubes. They never move, so their shadows can be cached.
   float cubeSize = 0.9f;
-  AddChild(std::make_shared<Model>(
-      Mesh::Cube, cubeMaterial,
+  Transform cubeTransforms[] = {
       Transform::TRS({-2.0, cubeSize * 0.5f, 2.1},
                      glm::quat(glm::radians(glm::vec3(0, 40, 0))),
-                     glm::vec3(cubeSize))));
-  AddChild(std::make_shared<Model>(
-      Mesh::Cube, cubeMaterial,
+                     glm::vec3(cubeSize)),
       Transform::TRS({-2.2, cubeSize * 1.5f, 2.2},
                      glm::quat(glm::radians(glm::vec3(0, 10, 0))),
-                     glm::vec3(cubeSize))));
-  AddChild(std::make_shared<Model>(
-      Mesh::Cube, cubeMaterial,
+                     glm::vec3(cubeSize)),
       Transform::TRS({2.1, cubeSize * 0.5f, -1.8},
                      glm::quat(glm::radians(glm::vec3(0, -34, 0))),
-                     glm::vec3(cubeSize))));
-  AddChild(std::make_shared<Model>(
-      Mesh::Cube, cubeMaterial,
+                     glm::vec3(cubeSize)),
       Transform::TRS({-0.3, cubeSize * 0.5f, -1.2},
                      glm::quat(glm::radians(glm::vec3(0, 3, 0))),
-                     glm::vec3(cubeSize))));
+                     glm::vec3(cubeSize)),
+  };
+  for (const Transform &cubeTransform : cubeTransforms) {
+    auto cube =
+        std::make_shared<Model>(Mesh::Cube, cubeMaterial, cubeTransform);
+    cube->isStatic = true;
+    AddChild(cube);
+  }
 
   // Robot materials.
   std::shared_ptr<StandardMaterial> robotMaterial =
@@ -249,6 +250,13 @@ void dg::PointShadowScene::Initialize() {
       { wallSize.x, wallSize.y, 1 }
   )), false);
 
+  // The floor and walls never move either.
+  for (auto &roomSide : roomSides->Children()) {
+    if (auto model = std::dynamic_pointer_cast<Model>(roomSide)) {
+      model->isStatic = true;
+    }
+  }
+
   // Torso
   auto torso = std::make_shared<Model>(
     Mesh::Cube,
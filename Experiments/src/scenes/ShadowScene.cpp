@@ -74,6 +74,7 @@ void dg::ShadowScene::Initialize() {
   cube = std::make_shared<Model>(
       dg::Mesh::Cube, std::make_shared<StandardMaterial>(cubeMaterial),
       Transform::TS(glm::vec3(0, 0.25f, 0), glm::vec3(0.5f)));
+  cube->isStatic = true;
   AddChild(cube);
 
   // Create floor material.
@@ -83,10 +84,12 @@ void dg::ShadowScene::Initialize() {
   floorMaterial.SetUVScale(glm::vec2((float)floorSize));
 
   // Create floor plane.
-  AddChild(std::make_shared<Model>(
+  auto floor = std::make_shared<Model>(
       dg::Mesh::Quad, std::make_shared<StandardMaterial>(floorMaterial),
       Transform::RS(glm::quat(glm::radians(glm::vec3(-90, 0, 0))),
-                    glm::vec3(floorSize, floorSize, 1))));
+                    glm::vec3(floorSize, floorSize, 1)));
+  floor->isStatic = true;
+  AddChild(floor);
 
   // Configure camera.
   cameras.main->transform = Transform::T({1.054, 1.467, 2.048});
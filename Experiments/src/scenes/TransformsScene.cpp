@@ -0,0 +1,204 @@
+//
+//  scenes/TransformsScene.cpp
+//
+
+#include "dg/scenes/TransformsScene.h"
+
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/quaternion.hpp>
+#include "dg/Window.h"
+
+namespace {
+
+  const int TRANSFORM_COUNT = 10000;
+  const int ITERATIONS = 200;
+
+  // Branching factor of the benchmarked hierarchy.
+  const int CHILDREN_PER_OBJECT = 8;
+
+  // Runs a benchmark and prints its average time per iteration. Returns the
+  // average time in microseconds.
+  double Benchmark(const std::string &name,
+                   const std::function<void()> &iteration) {
+    iteration();  // Warm up.
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+      iteration();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    double microseconds =
+        std::chrono::duration<double, std::micro>(end - start).count() /
+        ITERATIONS;
+    std::cout << "  " << std::left << std::setw(44) << name << std::right
+              << std::fixed << std::setprecision(1) << std::setw(10)
+              << microseconds << " us" << std::endl;
+    return microseconds;
+  }
+
+  void PrintSpeedup(double before, double after) {
+    std::cout << "  " << std::left << std::setw(44) << "Speedup" << std::right
+              << std::fixed << std::setprecision(2) << std::setw(10)
+              << before / after << " x" << std::endl
+              << std::endl;
+  }
+
+  // Transform::ToMat4() as it was before it built the matrix directly.
+  glm::mat4x4 ReferenceToMat4(const dg::Transform &xf) {
+    glm::mat4x4 r = glm::toMat4(xf.rotation);
+    glm::mat4x4 t = glm::translate(glm::mat4x4(1), xf.translation);
+    glm::mat4x4 s = glm::scale(glm::mat4x4(1), xf.scale);
+    return t * r * s;
+  }
+
+  // SceneObject::CacheSceneSpace() as it was before it composed each level
+  // of the hierarchy in a batch.
+  void ReferenceCacheSceneSpace(const std::vector<dg::Transform> &locals,
+                                const std::vector<int> &parents,
+                                const std::vector<std::vector<int>> &children,
+                                std::vector<dg::Transform> &sceneSpaces,
+                                int index) {
+    sceneSpaces[index] = parents[index] < 0
+                             ? locals[index]
+                             : sceneSpaces[parents[index]] * locals[index];
+    for (int child : children[index]) {
+      ReferenceCacheSceneSpace(locals, parents, children, sceneSpaces, child);
+    }
+  }
+
+} // namespace
+
+std::unique_ptr<dg::TransformsScene> dg::TransformsScene::Make() {
+  return std::unique_ptr<dg::TransformsScene>(new dg::TransformsScene());
+}
+
+dg::TransformsScene::TransformsScene() : Scene() {}
+
+void dg::TransformsScene::Initialize() {
+  Scene::Initialize();
+
+  std::cout << "This scene benchmarks Transform conversion and composition."
+            << std::endl
+            << std::endl
+            << "Press SPACE to run the benchmarks again." << std::endl
+            << std::endl;
+
+  RunBenchmarks();
+}
+
+void dg::TransformsScene::Update() {
+  Scene::Update();
+
+  if (window->IsKeyJustPressed(Key::SPACE)) {
+    RunBenchmarks();
+  }
+}
+
+void dg::TransformsScene::RunBenchmarks() {
+  std::mt19937 random(0);
+  std::uniform_real_distribution<float> position(-10, 10);
+  std::uniform_real_distribution<float> angle(-glm::pi<float>(),
+                                              glm::pi<float>());
+  std::uniform_real_distribution<float> scale(0.5f, 2);
+
+  std::vector<Transform> transforms(TRANSFORM_COUNT);
+  std::vector<Transform> others(TRANSFORM_COUNT);
+  for (int i = 0; i < TRANSFORM_COUNT; i++) {
+    for (Transform *xf : { &transforms[i], &others[i] }) {
+      *xf = Transform::TRS(
+          glm::vec3(position(random), position(random), position(random)),
+          glm::quat(glm::vec3(angle(random), angle(random), angle(random))),
+          glm::vec3(scale(random), scale(random), scale(random)));
+    }
+  }
+  std::vector<glm::mat4x4> matrices(TRANSFORM_COUNT);
+  std::vector<Transform> products(TRANSFORM_COUNT);
+
+  // Sum of results, printed so that no benchmark can be optimized away.
+  float checksum = 0;
+
+  std::cout << TRANSFORM_COUNT << " transforms, average of " << ITERATIONS
+            << " iterations:" << std::endl
+            << std::endl;
+
+  double before = Benchmark("ToMat4() with T * R * S", [&]() {
+    for (int i = 0; i < TRANSFORM_COUNT; i++) {
+      matrices[i] = ReferenceToMat4(transforms[i]);
+    }
+    checksum += matrices[TRANSFORM_COUNT - 1][3][0];
+  });
+  Benchmark("ToMat4() built directly", [&]() {
+    for (int i = 0; i < TRANSFORM_COUNT; i++) {
+      matrices[i] = transforms[i].ToMat4();
+    }
+    checksum += matrices[TRANSFORM_COUNT - 1][3][0];
+  });
+  double after = Benchmark("Batched ToMat4()", [&]() {
+    Transform::ToMat4(transforms.data(), matrices.data(), TRANSFORM_COUNT);
+    checksum += matrices[TRANSFORM_COUNT - 1][3][0];
+  });
+  PrintSpeedup(before, after);
+
+  before = Benchmark("Normal matrix with inverse(ToMat4())", [&]() {
+    for (int i = 0; i < TRANSFORM_COUNT; i++) {
+      matrices[i] = glm::transpose(glm::inverse(ReferenceToMat4(
+          transforms[i])));
+    }
+    checksum += matrices[TRANSFORM_COUNT - 1][0][0];
+  });
+  after = Benchmark("Batched ToNormalMat4()", [&]() {
+    Transform::ToNormalMat4(transforms.data(), matrices.data(),
+                            TRANSFORM_COUNT);
+    checksum += matrices[TRANSFORM_COUNT - 1][0][0];
+  });
+  PrintSpeedup(before, after);
+
+  before = Benchmark("operator*", [&]() {
+    for (int i = 0; i < TRANSFORM_COUNT; i++) {
+      products[i] = transforms[i] * others[i];
+    }
+    checksum += products[TRANSFORM_COUNT - 1].translation.x;
+  });
+  after = Benchmark("Batched Multiply()", [&]() {
+    Transform::Multiply(transforms.data(), others.data(), products.data(),
+                        TRANSFORM_COUNT);
+    checksum += products[TRANSFORM_COUNT - 1].translation.x;
+  });
+  PrintSpeedup(before, after);
+
+  // Build a hierarchy of SceneObjects, and the same hierarchy as index
+  // arrays for the recursive reference implementation.
+  std::vector<std::shared_ptr<SceneObject>> objects(TRANSFORM_COUNT);
+  std::vector<int> parents(TRANSFORM_COUNT);
+  std::vector<std::vector<int>> children(TRANSFORM_COUNT);
+  for (int i = 0; i < TRANSFORM_COUNT; i++) {
+    objects[i] = std::make_shared<SceneObject>(transforms[i]);
+    parents[i] = (i == 0) ? -1 : (i - 1) / CHILDREN_PER_OBJECT;
+    if (parents[i] >= 0) {
+      objects[parents[i]]->AddChild(objects[i], false);
+      children[parents[i]].push_back(i);
+    }
+  }
+  std::vector<Transform> sceneSpaces(TRANSFORM_COUNT);
+
+  before = Benchmark("Recursive hierarchy propagation", [&]() {
+    ReferenceCacheSceneSpace(transforms, parents, children, sceneSpaces, 0);
+    checksum += sceneSpaces[TRANSFORM_COUNT - 1].translation.x;
+  });
+  after = Benchmark("Batched CacheSceneSpace()", [&]() {
+    objects[0]->CacheSceneSpace();
+    checksum +=
+        objects[TRANSFORM_COUNT - 1]->CachedSceneSpace().translation.x;
+  });
+  PrintSpeedup(before, after);
+
+  std::cout << "Checksum: " << checksum << std::endl << std::endl;
+}